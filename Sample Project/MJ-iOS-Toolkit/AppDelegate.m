@@ -15,6 +15,14 @@
 //
 #import "AppDelegate.h"
 
+#import "MJCryptoBenchmark.h"
+#import "MJInteractorBenchmark.h"
+#import "MJDataProviderBenchmark.h"
+#import "MJTaskDispatcherBenchmark.h"
+#import "MJTaskExecutorBenchmark.h"
+#import "MJObjectStackBenchmark.h"
+#import "MJAppLinkRecognizerBenchmark.h"
+
 @interface AppDelegate ()
 
 @end
@@ -24,6 +32,28 @@
 
 - (BOOL)application:(UIApplication *)application didFinishLaunchingWithOptions:(NSDictionary *)launchOptions {
     // Override point for customization after application launch.
+    
+    // Benchmarks are launched with their class name as argument, and print their JSON report to the standard output.
+    NSArray *benchmarkClasses = @[MJCryptoBenchmark.class,
+                                  MJInteractorBenchmark.class,
+                                  MJDataProviderBenchmark.class,
+                                  MJTaskDispatcherBenchmark.class,
+                                  MJTaskExecutorBenchmark.class,
+                                  MJObjectStackBenchmark.class,
+                                  MJAppLinkRecognizerBenchmark.class,
+                                  ];
+    
+    NSArray *arguments = [NSProcessInfo processInfo].arguments;
+    
+    for (Class benchmarkClass in benchmarkClasses)
+    {
+        if ([arguments containsObject:[@"-" stringByAppendingString:NSStringFromClass(benchmarkClass)]])
+        {
+            [self mjz_runBenchmarkOfClass:benchmarkClass];
+            break;
+        }
+    }
+    
     return YES;
 }
 
@@ -49,4 +79,18 @@
     // Called when the application is about to terminate. Save data if appropriate. See also applicationDidEnterBackground:.
 }
 
+#pragma mark Private Methods
+
+- (void)mjz_runBenchmarkOfClass:(Class)benchmarkClass
+{
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        // All benchmarks implement -runJSON.
+        NSData *report = [[[benchmarkClass alloc] init] runJSON];
+        fwrite(report.bytes, 1, report.length, stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+        exit(0);
+    });
+}
+
 @end
@@ -0,0 +1,54 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Benchmark of MJAppLinkRecognizer routing.
+ * @discussion A recognizer is configured with a number of routes, with both anchor options, and handles URLs hitting random routes, plus a share of unsupported ones. The same URLs are matched by a copy of the previous recognizer loop, which compiled the regular expression of every pattern for each URL. Each result contains the URLs per second and the number of recognized URLs.
+ *
+ * Launch the sample app with the `-MJAppLinkRecognizerBenchmark` argument to run it and print the JSON report to the standard output.
+ **/
+@interface MJAppLinkRecognizerBenchmark : NSObject
+
+/**
+ * The number of routes. Default value is 500.
+ **/
+@property (nonatomic, assign) NSUInteger routeCount;
+
+/**
+ * The number of URLs handled by the routing trie. Default value is 1000000.
+ **/
+@property (nonatomic, assign) NSUInteger urlCount;
+
+/**
+ * The number of URLs handled by the previous regular expression loop. Default value is 1000.
+ **/
+@property (nonatomic, assign) NSUInteger legacyURLCount;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
@@ -0,0 +1,262 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJAppLinkRecognizerBenchmark.h"
+
+#import "MJAppLinkRecognizer.h"
+
+static NSUInteger const MJAppLinkRecognizerBenchmarkURLPoolSize = 4096;
+
+/**
+ * Recognizer loop before the routing trie: the regular expression of every pattern is compiled for each URL, until one matches.
+ **/
+@interface MJAppLinkLegacyMatcher : NSObject
+
+- (id)initWithScheme:(NSString*)scheme patterns:(NSDictionary <NSString*, NSString*> *)patterns options:(MJAppLinkOptions)options;
+
+- (NSString*)keyForURL:(NSURL*)url components:(NSArray**)components;
+
+@end
+
+@implementation MJAppLinkLegacyMatcher
+{
+    NSString *_scheme;
+    NSDictionary <NSString*, NSString*> *_patterns;
+    MJAppLinkOptions _options;
+}
+
+- (id)initWithScheme:(NSString*)scheme patterns:(NSDictionary <NSString*, NSString*> *)patterns options:(MJAppLinkOptions)options
+{
+    self = [super init];
+    if (self)
+    {
+        _scheme = scheme;
+        _patterns = [patterns copy];
+        _options = options;
+    }
+    return self;
+}
+
+- (NSString*)keyForURL:(NSURL*)url components:(NSArray**)components
+{
+    if (_scheme != nil && ![url.scheme isEqualToString:_scheme])
+        return nil;
+    
+    NSString *linkString = [url resourceSpecifier];
+    
+    NSRegularExpressionOptions regularExpressionOptions = 0;
+    
+    if ((_options & MJAppLinkOptionsCaseInsensitive) != 0)
+        regularExpressionOptions |= NSRegularExpressionCaseInsensitive;
+    
+    for (NSString *patternKey in _patterns)
+    {
+        NSString *pattern = _patterns[patternKey];
+        
+        if ((_options & MJAppLinkOptionsAnchoredStart) != 0)
+            pattern = [@"^" stringByAppendingString:pattern];
+        
+        if ((_options & MJAppLinkOptionsAnchoredEnd) != 0)
+            pattern = [pattern stringByAppendingString:@"$"];
+        
+        NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:pattern
+                                                                               options:regularExpressionOptions
+                                                                                 error:nil];
+        
+        NSTextCheckingResult *result = [regex firstMatchInString:linkString
+                                                         options:0
+                                                           range:NSMakeRange(0, linkString.length)];
+        
+        if (result)
+        {
+            NSMutableArray *captures = [NSMutableArray array];
+            
+            for (NSUInteger i = 1; i < result.numberOfRanges; i++)
+                [captures addObject:[linkString substringWithRange:[result rangeAtIndex:i]]];
+            
+            if (components)
+                *components = [captures copy];
+            
+            return patternKey;
+        }
+    }
+    
+    return nil;
+}
+
+@end
+
+#pragma mark -
+
+@interface MJAppLinkRecognizerBenchmark () <MJAppLinkRecognizerObserver>
+
+@end
+
+@implementation MJAppLinkRecognizerBenchmark
+{
+    NSUInteger _recognizedCount;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _routeCount = 500;
+        _urlCount = 1000000;
+        _legacyURLCount = 1000;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    NSArray *urls = [self mjz_urls];
+    NSDictionary *patterns = [self mjz_patterns];
+    
+    return @{@"routes": @(_routeCount),
+             @"results": @[[self mjz_measureRecognizerWithPatterns:patterns urls:urls count:_urlCount],
+                           [self mjz_measureLegacyMatcherWithPatterns:patterns urls:urls count:_legacyURLCount],
+                           ],
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (NSArray <NSURL*> *)mjz_urls
+{
+    NSMutableArray *urls = [NSMutableArray arrayWithCapacity:MJAppLinkRecognizerBenchmarkURLPoolSize];
+    
+    for (NSUInteger i = 0; i < MJAppLinkRecognizerBenchmarkURLPoolSize; i++)
+    {
+        NSUInteger route = arc4random_uniform((uint32_t)_routeCount);
+        NSString *string = nil;
+        
+        if (i % 10 == 0)
+            string = [NSString stringWithFormat:@"mjapp://example.com/unknown%lu/%u", (unsigned long)route, arc4random()];
+        else if (route % 2 == 0)
+            string = [NSString stringWithFormat:@"mjapp://example.com/section%lu/%u/detail", (unsigned long)route, arc4random()];
+        else
+            string = [NSString stringWithFormat:@"mjapp://example.com/section%lu/items/item-%u", (unsigned long)route, arc4random()];
+        
+        [urls addObject:[NSURL URLWithString:string]];
+    }
+    
+    return urls;
+}
+
+- (NSDictionary <NSString*, NSString*> *)mjz_patterns
+{
+    NSMutableDictionary *patterns = [NSMutableDictionary dictionaryWithCapacity:_routeCount];
+    
+    for (NSUInteger i = 0; i < _routeCount; i++)
+    {
+        NSString *key = [NSString stringWithFormat:@"route.%lu", (unsigned long)i];
+        
+        if (i % 2 == 0)
+            patterns[key] = [NSString stringWithFormat:@"//example\\.com/section%lu/%@/detail", (unsigned long)i, MJAppLinkPatternNumeric];
+        else
+            patterns[key] = [NSString stringWithFormat:@"//example\\.com/section%lu/items/%@", (unsigned long)i, MJAppLinkPatternAlphanumericAndDash];
+    }
+    
+    return patterns;
+}
+
+- (NSDictionary*)mjz_measureRecognizerWithPatterns:(NSDictionary <NSString*, NSString*> *)patterns urls:(NSArray <NSURL*> *)urls count:(NSUInteger)count
+{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    MJAppLinkRecognizer *recognizer = [[MJAppLinkRecognizer alloc] initWithConfiguration:^(MJAppLinkRecognizerConfiguration *configuration) {
+        configuration.scheme = @"mjapp";
+        configuration.options = MJAppLinkOptionsAnchoredStart | MJAppLinkOptionsAnchoredEnd;
+        
+        [patterns enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *pattern, BOOL *stop) {
+            [configuration setPattern:pattern forKey:key];
+        }];
+    }];
+    
+    CFAbsoluteTime configured = CFAbsoluteTimeGetCurrent();
+    
+    [recognizer addObserver:self];
+    _recognizedCount = 0;
+    
+    NSUInteger poolSize = urls.count;
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        @autoreleasepool
+        {
+            [recognizer handleURL:urls[i % poolSize]];
+        }
+    }
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - configured;
+    
+    return @{@"mode": @"trie",
+             @"urls": @(count),
+             @"configuration_seconds": @(configured - start),
+             @"seconds": @(elapsed),
+             @"urls_per_s": @(count / elapsed),
+             @"recognized": @(_recognizedCount),
+             };
+}
+
+- (NSDictionary*)mjz_measureLegacyMatcherWithPatterns:(NSDictionary <NSString*, NSString*> *)patterns urls:(NSArray <NSURL*> *)urls count:(NSUInteger)count
+{
+    MJAppLinkLegacyMatcher *matcher = [[MJAppLinkLegacyMatcher alloc] initWithScheme:@"mjapp"
+                                                                            patterns:patterns
+                                                                             options:MJAppLinkOptionsAnchoredStart | MJAppLinkOptionsAnchoredEnd];
+    
+    NSUInteger recognizedCount = 0;
+    NSUInteger poolSize = urls.count;
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        @autoreleasepool
+        {
+            if ([matcher keyForURL:urls[i % poolSize] components:NULL])
+                recognizedCount++;
+        }
+    }
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    return @{@"mode": @"legacy_regex",
+             @"urls": @(count),
+             @"configuration_seconds": @0,
+             @"seconds": @(elapsed),
+             @"urls_per_s": @(count / elapsed),
+             @"recognized": @(recognizedCount),
+             };
+}
+
+#pragma mark - MJAppLinkRecognizerObserver
+
+- (void)appLinkRecognizer:(MJAppLinkRecognizer*)recognizer didRecognizeURLForKey:(NSString*)key components:(NSArray*)components
+{
+    _recognizedCount++;
+}
+
+@end
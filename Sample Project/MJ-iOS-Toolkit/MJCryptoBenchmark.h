@@ -0,0 +1,72 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Throughput benchmark of the NSData+AES family (NSData+AES, NSMutableData+AES and NSData+SHA).
+ * @discussion Every operation is measured for each combination of payload size, padding and thread count. Each result contains the operation, payload size, padding, thread count, iterations, nanoseconds per operation and MB/s.
+ *
+ * The `stream` results compare `NSDataAESStreamCipher` with `aes_encrypt:` for each stream size, with the throughput and the growth of the memory footprint during the operation.
+ *
+ * The `in_place` results count, for each payload size, the heap allocations, allocated bytes and copied bytes per call of `NSMutableData+AES`, compared with encrypting into a new data and copying it back with `setData:`. Copied bytes are those copied with `setData:` plus those relocated when the buffer moves.
+ *
+ * The `derived_key` results measure the per-record cost of a key that is not 256 bits long (hashed on every call) against the same key prepared once with `+[NSDataAESCipher cipherKeyForKey:]`, and of a non block-sized initialization vector with and without the derived IV cache.
+ *
+ * The `records` results measure the records per second of `aes_encryptRecords:` (pooled cryptors, see `NSDataAESCryptorPool`) against `aes_encryptValue:` for each record, at 1, 4 and 8 threads.
+ *
+ * Launch the sample app with the `-MJCryptoBenchmark` argument to run it and print the JSON report to the standard output.
+ **/
+@interface MJCryptoBenchmark : NSObject
+
+/**
+ * Payload sizes in bytes. Must be multiples of the AES block size. Default value is 16, 256, 4 KB, 64 KB and 1 MB.
+ **/
+@property (nonatomic, strong) NSArray <NSNumber*> *payloadSizes;
+
+/**
+ * Number of concurrent threads. Default value is 1, 2, 4 and the number of active processors.
+ **/
+@property (nonatomic, strong) NSArray <NSNumber*> *threadCounts;
+
+/**
+ * Minimum time spent measuring each combination. Default value is 0.5 seconds.
+ **/
+@property (nonatomic, assign) NSTimeInterval duration;
+
+/**
+ * Input sizes of the stream benchmark in bytes. Default value is 1 KB, 1 MB, 64 MB and 1 GB.
+ **/
+@property (nonatomic, strong) NSArray <NSNumber*> *streamSizes;
+
+/**
+ * Largest input also encrypted at once with `aes_encrypt:`, which needs the whole input and output in memory. Default value is 64 MB.
+ **/
+@property (nonatomic, assign) NSUInteger wholeBufferLimit;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the environment and the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
@@ -0,0 +1,454 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJCryptoBenchmark.h"
+
+#import <Security/Security.h>
+#import <stdatomic.h>
+#import <mach/mach.h>
+#import <pthread.h>
+
+#import "NSData+AES.h"
+#import "NSData+AESKey.h"
+#import "NSMutableData+AES.h"
+#import "NSData+SHA.h"
+#import "NSDataAESStreamCipher.h"
+#import "NSDataAESCipher.h"
+
+static NSString * const MJCryptoBenchmarkPaddingNone    = @"none";
+static NSString * const MJCryptoBenchmarkPaddingPKCS7   = @"pkcs7";
+
+/**
+ * Returns the physical memory footprint of the process, in bytes.
+ **/
+static uint64_t MJCryptoBenchmarkFootprint()
+{
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0;
+    
+    return info.phys_footprint;
+}
+
+// Hook of libmalloc, called on every allocation. Used by the allocation tools, not declared in a public header.
+typedef void (MJCryptoBenchmarkMallocLogger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip);
+extern MJCryptoBenchmarkMallocLogger *malloc_logger;
+
+static uint32_t const MJCryptoBenchmarkMallocLogAllocate    = 2;
+static uint32_t const MJCryptoBenchmarkMallocLogDeallocate  = 4;
+
+static pthread_t _countedThread;
+static atomic_bool _countingAllocations;
+static atomic_llong _allocationCount;
+static atomic_llong _allocatedBytes;
+
+static void MJCryptoBenchmarkCountAllocation(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip)
+{
+    if (!(type & MJCryptoBenchmarkMallocLogAllocate) || !atomic_load(&_countingAllocations) || !pthread_equal(pthread_self(), _countedThread))
+        return;
+    
+    // Reallocations log the new size as third argument.
+    uintptr_t size = (type & MJCryptoBenchmarkMallocLogDeallocate) ? arg3 : arg2;
+    
+    atomic_fetch_add(&_allocationCount, 1);
+    atomic_fetch_add(&_allocatedBytes, (long long)size);
+}
+
+@implementation MJCryptoBenchmark
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        NSUInteger processorCount = [NSProcessInfo processInfo].activeProcessorCount;
+        
+        _payloadSizes = @[@16, @256, @(4 * 1024), @(64 * 1024), @(1024 * 1024)];
+        _threadCounts = [[NSOrderedSet orderedSetWithArray:@[@1, @2, @4, @(processorCount)]] array];
+        _duration = 0.5;
+        _streamSizes = @[@1024, @(1024 * 1024), @(64 * 1024 * 1024), @(1024 * 1024 * 1024)];
+        _wholeBufferLimit = 64 * 1024 * 1024;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    NSData *key = [self mjz_randomDataWithLength:32];
+    NSMutableArray *results = [NSMutableArray array];
+    
+    for (NSNumber *payloadSize in _payloadSizes)
+    {
+        NSData *plaintext = [self mjz_randomDataWithLength:payloadSize.unsignedIntegerValue];
+        
+        for (NSNumber *threadCount in _threadCounts)
+        {
+            for (NSString *padding in @[MJCryptoBenchmarkPaddingPKCS7, MJCryptoBenchmarkPaddingNone])
+            {
+                CCOptions options = [padding isEqualToString:MJCryptoBenchmarkPaddingPKCS7] ? kCCOptionPKCS7Padding : 0;
+                NSData *ciphertext = [plaintext aes_encrypt:key withPadding:options];
+                
+                [results addObject:[self mjz_measureOperation:@"encrypt" payload:plaintext padding:padding threads:threadCount block:^(NSMutableData *buffer) {
+                    [plaintext aes_encrypt:key withPadding:options];
+                }]];
+                
+                [results addObject:[self mjz_measureOperation:@"decrypt" payload:plaintext padding:padding threads:threadCount block:^(NSMutableData *buffer) {
+                    [ciphertext aes_decrypt:key withPadding:options];
+                }]];
+            }
+            
+            // In place operations keep the buffer length only without padding, so they can be repeated on the same buffer.
+            [results addObject:[self mjz_measureOperation:@"encrypt_in_place" payload:plaintext padding:MJCryptoBenchmarkPaddingNone threads:threadCount block:^(NSMutableData *buffer) {
+                [buffer aes_encryptInPlace:key withPadding:0];
+            }]];
+            
+            [results addObject:[self mjz_measureOperation:@"decrypt_in_place" payload:plaintext padding:MJCryptoBenchmarkPaddingNone threads:threadCount block:^(NSMutableData *buffer) {
+                [buffer aes_decryptInPlace:key withPadding:0];
+            }]];
+            
+            [results addObject:[self mjz_measureOperation:@"sha1" payload:plaintext padding:nil threads:threadCount block:^(NSMutableData *buffer) {
+                [plaintext sha_SHA1];
+            }]];
+            
+            [results addObject:[self mjz_measureOperation:@"sha256" payload:plaintext padding:nil threads:threadCount block:^(NSMutableData *buffer) {
+                [plaintext sha_SHA256];
+            }]];
+        }
+    }
+    
+    NSArray *streamResults = [self mjz_streamResultsWithKey:key];
+    NSArray *inPlaceResults = [self mjz_inPlaceResultsWithKey:key];
+    NSArray *derivedKeyResults = [self mjz_derivedKeyResults];
+    NSArray *recordResults = [self mjz_recordResultsWithKey:key];
+    
+    NSProcessInfo *processInfo = [NSProcessInfo processInfo];
+    
+    return @{@"environment": @{@"os": processInfo.operatingSystemVersionString,
+                               @"processors": @(processInfo.activeProcessorCount),
+                               @"duration": @(_duration),
+                               },
+             @"results": results,
+             @"stream": streamResults,
+             @"in_place": inPlaceResults,
+             @"derived_key": derivedKeyResults,
+             @"records": recordResults,
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (NSDictionary*)mjz_measureOperation:(NSString*)operation
+                              payload:(NSData*)payload
+                              padding:(NSString*)padding
+                              threads:(NSNumber*)threadCount
+                                block:(void (^)(NSMutableData *buffer))block
+{
+    NSUInteger threads = MAX(threadCount.unsignedIntegerValue, 1);
+    NSTimeInterval duration = _duration;
+    
+    // Warm up, so lazy initializations and caches are not measured.
+    block([payload mutableCopy]);
+    
+    __block atomic_llong iterations = 0;
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    dispatch_apply(threads, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t index) {
+        NSMutableData *buffer = [payload mutableCopy];
+        int64_t count = 0;
+        
+        while (CFAbsoluteTimeGetCurrent() - start < duration)
+        {
+            @autoreleasepool
+            {
+                block(buffer);
+            }
+            count++;
+        }
+        
+        atomic_fetch_add(&iterations, count);
+    });
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    int64_t total = MAX(atomic_load(&iterations), 1);
+    double bytes = (double)total * payload.length;
+    
+    return @{@"operation": operation,
+             @"payload": @(payload.length),
+             @"padding": padding ?: [NSNull null],
+             @"threads": @(threads),
+             @"iterations": @(total),
+             @"ns_per_op": @(elapsed * 1e9 / total),
+             @"mb_per_s": @(bytes / elapsed / (1024.0 * 1024.0)),
+             };
+}
+
+- (NSArray*)mjz_streamResultsWithKey:(NSData*)key
+{
+    NSMutableArray *results = [NSMutableArray array];
+    
+    NSUInteger chunkSize = NSDataAESStreamCipherDefaultBufferSize;
+    NSData *chunk = [self mjz_randomDataWithLength:chunkSize];
+    
+    for (NSNumber *streamSize in _streamSizes)
+    {
+        unsigned long long length = streamSize.unsignedLongLongValue;
+        
+        @autoreleasepool
+        {
+            // The input is fed chunk by chunk, as read from a stream, and the output of each chunk is dropped as written to one.
+            NSDataAESStreamCipher *cipher = [NSDataAESStreamCipher streamCipherWithKey:key iv:nil operation:kCCEncrypt options:kCCOptionPKCS7Padding];
+            NSMutableData *output = [NSMutableData dataWithCapacity:chunkSize + kCCBlockSizeAES128];
+            
+            uint64_t baseline = MJCryptoBenchmarkFootprint();
+            uint64_t peak = baseline;
+            unsigned long long remaining = length;
+            
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            
+            while (remaining > 0)
+            {
+                size_t chunkLength = (size_t)MIN(remaining, (unsigned long long)chunkSize);
+                
+                output.length = 0;
+                [cipher updateWithBytes:chunk.bytes length:chunkLength output:output error:nil];
+                remaining -= chunkLength;
+                
+                peak = MAX(peak, MJCryptoBenchmarkFootprint());
+            }
+            
+            output.length = 0;
+            [cipher finalizeWithOutput:output error:nil];
+            
+            CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+            
+            [results addObject:[self mjz_streamResultWithOperation:@"stream_encrypt" length:length elapsed:elapsed footprint:peak - baseline]];
+        }
+        
+        if (length > _wholeBufferLimit)
+            continue;
+        
+        @autoreleasepool
+        {
+            NSData *plaintext = [self mjz_randomDataWithLength:(NSUInteger)length];
+            
+            uint64_t baseline = MJCryptoBenchmarkFootprint();
+            
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            NSData *ciphertext = [plaintext aes_encrypt:key withPadding:kCCOptionPKCS7Padding];
+            CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+            
+            // The output is still alive, as the whole ciphertext is needed before writing it.
+            uint64_t peak = MAX(baseline, MJCryptoBenchmarkFootprint());
+            ciphertext = nil;
+            
+            [results addObject:[self mjz_streamResultWithOperation:@"whole_buffer_encrypt" length:length elapsed:elapsed footprint:peak - baseline]];
+        }
+    }
+    
+    return results;
+}
+
+- (NSArray*)mjz_inPlaceResultsWithKey:(NSData*)key
+{
+    NSMutableArray *results = [NSMutableArray array];
+    
+    for (NSNumber *payloadSize in _payloadSizes)
+    {
+        NSData *plaintext = [self mjz_randomDataWithLength:payloadSize.unsignedIntegerValue];
+        
+        [results addObject:[self mjz_countAllocationsOfOperation:@"encrypt_in_place" payload:plaintext padding:MJCryptoBenchmarkPaddingNone block:^NSUInteger(NSMutableData *buffer) {
+            [buffer aes_encryptInPlace:key withPadding:0];
+            return 0;
+        }]];
+        
+        [results addObject:[self mjz_countAllocationsOfOperation:@"encrypt_in_place" payload:plaintext padding:MJCryptoBenchmarkPaddingPKCS7 block:^NSUInteger(NSMutableData *buffer) {
+            [buffer aes_encryptInPlace:key withPadding:kCCOptionPKCS7Padding];
+            return 0;
+        }]];
+        
+        // What in place encryption did before: a new data, copied back into the buffer.
+        [results addObject:[self mjz_countAllocationsOfOperation:@"encrypt_copy_back" payload:plaintext padding:MJCryptoBenchmarkPaddingPKCS7 block:^NSUInteger(NSMutableData *buffer) {
+            NSData *ciphertext = [buffer aes_encrypt:key withPadding:kCCOptionPKCS7Padding];
+            [buffer setData:ciphertext];
+            return ciphertext.length;
+        }]];
+    }
+    
+    return results;
+}
+
+- (NSArray*)mjz_derivedKeyResults
+{
+    NSMutableArray *results = [NSMutableArray array];
+    
+    // Passphrase-style key and IV, not 256 and 128 bits long, so both are derived.
+    NSData *passphrase = [@"benchmark passphrase" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *preparedKey = [NSDataAESCipher cipherKeyForKey:passphrase];
+    NSData *iv = [@"record iv" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    for (NSNumber *recordSize in @[@64, @512])
+    {
+        NSData *record = [self mjz_randomDataWithLength:recordSize.unsignedIntegerValue];
+        
+        [results addObject:[self mjz_measureOperation:@"encrypt_passphrase_key" payload:record padding:MJCryptoBenchmarkPaddingPKCS7 threads:@1 block:^(NSMutableData *buffer) {
+            [record aes_encrypt:passphrase withPadding:kCCOptionPKCS7Padding];
+        }]];
+        
+        [results addObject:[self mjz_measureOperation:@"encrypt_prepared_key" payload:record padding:MJCryptoBenchmarkPaddingPKCS7 threads:@1 block:^(NSMutableData *buffer) {
+            [record aes_encrypt:preparedKey withPadding:kCCOptionPKCS7Padding];
+        }]];
+        
+        [results addObject:[self mjz_measureOperation:@"encrypt_iv_cached" payload:record padding:MJCryptoBenchmarkPaddingPKCS7 threads:@1 block:^(NSMutableData *buffer) {
+            [record aes_encrypt:preparedKey withInitial:iv];
+        }]];
+        
+        [NSDataAESCipher setIVCacheLimit:0];
+        
+        [results addObject:[self mjz_measureOperation:@"encrypt_iv_uncached" payload:record padding:MJCryptoBenchmarkPaddingPKCS7 threads:@1 block:^(NSMutableData *buffer) {
+            [record aes_encrypt:preparedKey withInitial:iv];
+        }]];
+        
+        [NSDataAESCipher setIVCacheLimit:NSDataAESCipherIVCacheDefaultLimit];
+    }
+    
+    return results;
+}
+
+- (NSArray*)mjz_recordResultsWithKey:(NSData*)key
+{
+    static NSUInteger const batchCount = 256;
+    
+    NSMutableArray *results = [NSMutableArray array];
+    
+    for (NSNumber *recordSize in @[@64, @256, @512])
+    {
+        NSMutableArray *records = [NSMutableArray arrayWithCapacity:batchCount];
+        for (NSUInteger i = 0; i < batchCount; i++)
+            [records addObject:[self mjz_randomDataWithLength:recordSize.unsignedIntegerValue]];
+        
+        NSData *record = records.firstObject;
+        
+        for (NSNumber *threadCount in @[@1, @4, @8])
+        {
+            NSDictionary *result = [self mjz_measureOperation:@"encrypt_records" payload:record padding:MJCryptoBenchmarkPaddingPKCS7 threads:threadCount block:^(NSMutableData *buffer) {
+                [key aes_encryptRecords:records];
+            }];
+            [results addObject:[self mjz_recordResultWithResult:result batchCount:batchCount]];
+            
+            result = [self mjz_measureOperation:@"encrypt_values" payload:record padding:MJCryptoBenchmarkPaddingPKCS7 threads:threadCount block:^(NSMutableData *buffer) {
+                for (NSData *value in records)
+                    [key aes_encryptValue:value];
+            }];
+            [results addObject:[self mjz_recordResultWithResult:result batchCount:batchCount]];
+        }
+    }
+    
+    return results;
+}
+
+- (NSDictionary*)mjz_recordResultWithResult:(NSDictionary*)result batchCount:(NSUInteger)batchCount
+{
+    // Each measured operation is a batch of records.
+    double recordsPerSecond = 1e9 / [result[@"ns_per_op"] doubleValue] * batchCount;
+    
+    NSMutableDictionary *recordResult = [result mutableCopy];
+    recordResult[@"records_per_op"] = @(batchCount);
+    recordResult[@"records_per_s"] = @(recordsPerSecond);
+    recordResult[@"mb_per_s"] = @(recordsPerSecond * [result[@"payload"] doubleValue] / (1024.0 * 1024.0));
+    
+    return recordResult;
+}
+
+- (NSDictionary*)mjz_countAllocationsOfOperation:(NSString*)operation
+                                         payload:(NSData*)payload
+                                         padding:(NSString*)padding
+                                           block:(NSUInteger (^)(NSMutableData *buffer))block
+{
+    static NSUInteger const iterations = 1000;
+    
+    NSMutableData *buffer = [payload mutableCopy];
+    unsigned long long copiedBytes = 0;
+    
+    // Warm up, so lazy initializations are not counted.
+    block(buffer);
+    
+    _countedThread = pthread_self();
+    atomic_store(&_allocationCount, 0);
+    atomic_store(&_allocatedBytes, 0);
+    
+    MJCryptoBenchmarkMallocLogger *previousLogger = malloc_logger;
+    malloc_logger = MJCryptoBenchmarkCountAllocation;
+    
+    for (NSUInteger i = 0; i < iterations; i++)
+    {
+        @autoreleasepool
+        {
+            // Every call starts from the payload length, as padding grows the buffer.
+            buffer.length = payload.length;
+            const void *bytes = buffer.bytes;
+            
+            atomic_store(&_countingAllocations, YES);
+            copiedBytes += block(buffer);
+            atomic_store(&_countingAllocations, NO);
+            
+            if (buffer.bytes != bytes)
+                copiedBytes += payload.length;
+        }
+    }
+    
+    malloc_logger = previousLogger;
+    
+    return @{@"operation": operation,
+             @"payload": @(payload.length),
+             @"padding": padding,
+             @"iterations": @(iterations),
+             @"allocations_per_op": @((double)atomic_load(&_allocationCount) / iterations),
+             @"allocated_bytes_per_op": @((double)atomic_load(&_allocatedBytes) / iterations),
+             @"copied_bytes_per_op": @((double)copiedBytes / iterations),
+             };
+}
+
+- (NSDictionary*)mjz_streamResultWithOperation:(NSString*)operation length:(unsigned long long)length elapsed:(CFAbsoluteTime)elapsed footprint:(uint64_t)footprint
+{
+    elapsed = MAX(elapsed, 1e-9);
+    
+    return @{@"operation": operation,
+             @"payload": @(length),
+             @"seconds": @(elapsed),
+             @"mb_per_s": @((double)length / elapsed / (1024.0 * 1024.0)),
+             @"footprint_growth": @(footprint),
+             };
+}
+
+- (NSData*)mjz_randomDataWithLength:(NSUInteger)length
+{
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    SecRandomCopyBytes(kSecRandomDefault, length, data.mutableBytes);
+    return data;
+}
+
+@end
@@ -0,0 +1,69 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Benchmark of the MJDataProviderDirector scheduler under contention.
+ * @discussion A burst of requests from the three scheduler lanes resolves with network against a mock network. The mock network has a number of channels: when more requests are in flight, each one takes proportionally longer, as in a shared radio. The burst runs once without scheduler and once with a scheduler limited to the number of channels. Each result contains the latency percentiles of each lane and the scheduler statistics.
+ *
+ * Launch the sample app with the `-MJDataProviderBenchmark` argument to run it and print the JSON report to the standard output.
+ **/
+@interface MJDataProviderBenchmark : NSObject
+
+/**
+ * The number of requests of the burst. Default value is 400.
+ **/
+@property (nonatomic, assign) NSUInteger requestCount;
+
+/**
+ * The percentage of visible requests. Default value is 10.
+ **/
+@property (nonatomic, assign) NSUInteger visiblePercentage;
+
+/**
+ * The percentage of prefetch requests. Default value is 30. The remaining requests are background requests.
+ **/
+@property (nonatomic, assign) NSUInteger prefetchPercentage;
+
+/**
+ * The latency of a request of the mock network without contention. Default value is 20 milliseconds.
+ **/
+@property (nonatomic, assign) NSTimeInterval latency;
+
+/**
+ * The random latency added to each request, up to this value. Default value is 10 milliseconds.
+ **/
+@property (nonatomic, assign) NSTimeInterval jitter;
+
+/**
+ * The number of requests the mock network serves without contention. Default value is 4.
+ **/
+@property (nonatomic, assign) NSUInteger channelCount;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
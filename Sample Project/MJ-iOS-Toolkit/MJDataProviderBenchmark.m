@@ -0,0 +1,205 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJDataProviderBenchmark.h"
+
+#import "MJDataProviderDirector.h"
+
+#pragma mark - Mock network
+
+/**
+ * Local stand-in of a network with a limited number of channels.
+ **/
+@interface MJMockNetwork : NSObject
+
+@property (nonatomic, assign) NSTimeInterval latency;
+@property (nonatomic, assign) NSTimeInterval jitter;
+@property (nonatomic, assign) NSUInteger channelCount;
+
+- (void)requestWithCompletion:(void (^)(void))completion;
+
+@end
+
+@implementation MJMockNetwork
+{
+    NSUInteger _inFlight;
+}
+
+- (void)requestWithCompletion:(void (^)(void))completion
+{
+    NSTimeInterval duration = 0;
+    
+    @synchronized(self)
+    {
+        _inFlight++;
+        
+        // Channels are shared: above the channel count, every request slows down.
+        double contention = MAX(1.0, (double)_inFlight / (double)MAX(_channelCount, 1));
+        duration = (_latency + _jitter * arc4random_uniform(1000) / 1000.0) * contention;
+    }
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(duration * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        @synchronized(self)
+        {
+            _inFlight--;
+        }
+        completion();
+    });
+}
+
+@end
+
+#pragma mark - Benchmark
+
+@implementation MJDataProviderBenchmark
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _requestCount = 400;
+        _visiblePercentage = 10;
+        _prefetchPercentage = 30;
+        _latency = 0.020;
+        _jitter = 0.010;
+        _channelCount = 4;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    scheduler.maxConcurrentRequests = _channelCount;
+    
+    return @{@"requests": @(_requestCount),
+             @"latency": @(_latency),
+             @"jitter": @(_jitter),
+             @"channels": @(_channelCount),
+             @"results": @[[self mjz_measureWithScheduler:nil],
+                           [self mjz_measureWithScheduler:scheduler],
+                           ],
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (MJDataProviderSchedulerLane)mjz_laneForRequestAtIndex:(NSUInteger)index
+{
+    NSUInteger percentile = (index * 37) % 100;
+    
+    if (percentile < _visiblePercentage)
+        return MJDataProviderSchedulerLaneVisible;
+    else if (percentile < _visiblePercentage + _prefetchPercentage)
+        return MJDataProviderSchedulerLanePrefetch;
+    else
+        return MJDataProviderSchedulerLaneBackground;
+}
+
+- (NSDictionary*)mjz_measureWithScheduler:(MJDataProviderScheduler*)scheduler
+{
+    MJMockNetwork *network = [[MJMockNetwork alloc] init];
+    network.latency = _latency;
+    network.jitter = _jitter;
+    network.channelCount = _channelCount;
+    
+    NSArray *directors = @[[[MJDataProviderDirector alloc] init],
+                           [[MJDataProviderDirector alloc] init],
+                           [[MJDataProviderDirector alloc] init],
+                           ];
+    
+    for (MJDataProviderSchedulerLane lane = MJDataProviderSchedulerLaneVisible; lane <= MJDataProviderSchedulerLaneBackground; lane++)
+    {
+        MJDataProviderDirector *director = directors[lane];
+        director.scheduler = scheduler;
+        director.lane = lane;
+    }
+    
+    NSArray *latencies = @[[NSMutableArray array], [NSMutableArray array], [NSMutableArray array]];
+    dispatch_group_t group = dispatch_group_create();
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    for (NSUInteger i = 0; i < _requestCount; i++)
+    {
+        MJDataProviderSchedulerLane lane = [self mjz_laneForRequestAtIndex:i];
+        MJDataProviderDirector *director = directors[lane];
+        CFAbsoluteTime requestStart = CFAbsoluteTimeGetCurrent();
+        
+        dispatch_group_enter(group);
+        [director networkBlock:^(MJDataProviderDirectorResolver *resolver) {
+            [network requestWithCompletion:^{
+                CFTimeInterval latency = CFAbsoluteTimeGetCurrent() - requestStart;
+                @synchronized(latencies)
+                {
+                    [latencies[lane] addObject:@(latency)];
+                }
+                [resolver finish];
+                dispatch_group_leave(group);
+            }];
+        } cacheBlock:nil];
+    }
+    
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    NSArray *names = @[@"visible", @"prefetch", @"background"];
+    NSMutableDictionary *lanes = [NSMutableDictionary dictionary];
+    
+    for (MJDataProviderSchedulerLane lane = MJDataProviderSchedulerLaneVisible; lane <= MJDataProviderSchedulerLaneBackground; lane++)
+        lanes[names[lane]] = [self mjz_percentilesOfLatencies:latencies[lane]];
+    
+    NSMutableDictionary *result = [NSMutableDictionary dictionary];
+    result[@"scheduler"] = scheduler ? @"weighted_round_robin" : @"none";
+    result[@"seconds"] = @(elapsed);
+    result[@"lanes"] = lanes;
+    
+    if (scheduler)
+        result[@"statistics"] = [scheduler statistics];
+    
+    return result;
+}
+
+- (NSDictionary*)mjz_percentilesOfLatencies:(NSArray <NSNumber*> *)latencies
+{
+    NSArray *sorted = [latencies sortedArrayUsingSelector:@selector(compare:)];
+    
+    if (sorted.count == 0)
+        return @{@"count": @0};
+    
+    NSNumber* (^percentile)(double) = ^NSNumber*(double p) {
+        NSUInteger index = MIN((NSUInteger)(p * sorted.count), sorted.count - 1);
+        return @([sorted[index] doubleValue] * 1000.0);
+    };
+    
+    return @{@"count": @(sorted.count),
+             @"p50_ms": percentile(0.50),
+             @"p95_ms": percentile(0.95),
+             @"p99_ms": percentile(0.99),
+             @"max_ms": @([sorted.lastObject doubleValue] * 1000.0),
+             };
+}
+
+@end
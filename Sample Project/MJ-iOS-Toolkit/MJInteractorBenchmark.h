@@ -0,0 +1,55 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Benchmark of MJInteractor concurrency policies.
+ * @discussion For each policy, a number of interactors begin jobs at the same time. Each job simulates an asynchronous request that ends after a delay. Each result contains the policy, jobs per second and the peak number of threads of the process. The report also counts the backend hits of identical concurrent requests using single-flight jobs.
+ *
+ * Launch the sample app with the `-MJInteractorBenchmark` argument to run it and print the JSON report to the standard output.
+ * Must not be run in the main thread, as jobs end in the main queue.
+ **/
+@interface MJInteractorBenchmark : NSObject
+
+/**
+ * The number of concurrent interactors. Default value is 100.
+ **/
+@property (nonatomic, assign) NSUInteger interactorCount;
+
+/**
+ * The number of jobs begun by each interactor. Default value is 10.
+ **/
+@property (nonatomic, assign) NSUInteger jobsPerInteractor;
+
+/**
+ * The simulated duration of each request. Default value is 5 milliseconds.
+ **/
+@property (nonatomic, assign) NSTimeInterval jobDuration;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
@@ -0,0 +1,250 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJInteractorBenchmark.h"
+
+#import <mach/mach.h>
+#import <stdatomic.h>
+
+#import "MJInteractor.h"
+
+static NSUInteger MJInteractorBenchmarkThreadCount()
+{
+    thread_act_array_t threads = NULL;
+    mach_msg_type_number_t count = 0;
+    
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS)
+        return 0;
+    
+    for (mach_msg_type_number_t i = 0; i < count; i++)
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+    
+    return count;
+}
+
+#pragma mark - Interactors
+
+@interface MJSerialBenchmarkInteractor : MJInteractor
+
+@property (nonatomic, assign) NSUInteger index;
+
+- (void)performJobWithDuration:(NSTimeInterval)duration completion:(void (^)())completion;
+
+@end
+
+@implementation MJSerialBenchmarkInteractor
+
+- (void)performJobWithDuration:(NSTimeInterval)duration completion:(void (^)())completion
+{
+    [self begin:^{
+        // Simulates an asynchronous request.
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(duration * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [self end:^{
+                completion();
+            }];
+        });
+    }];
+}
+
+@end
+
+@interface MJBoundedParallelBenchmarkInteractor : MJSerialBenchmarkInteractor
+
+@end
+
+@implementation MJBoundedParallelBenchmarkInteractor
+
++ (MJInteractorConcurrencyPolicy)concurrencyPolicy
+{
+    return MJInteractorConcurrencyPolicyBoundedParallel;
+}
+
++ (NSUInteger)maxConcurrentJobs
+{
+    return 16;
+}
+
+@end
+
+@interface MJKeyedSerialBenchmarkInteractor : MJSerialBenchmarkInteractor
+
+@end
+
+@implementation MJKeyedSerialBenchmarkInteractor
+
++ (MJInteractorConcurrencyPolicy)concurrencyPolicy
+{
+    return MJInteractorConcurrencyPolicyKeyedSerial;
+}
+
++ (NSUInteger)maxConcurrentJobs
+{
+    return 16;
+}
+
+- (NSString*)serialKey
+{
+    return [NSString stringWithFormat:@"%lu", (unsigned long)(self.index % 10)];
+}
+
+@end
+
+@interface MJSingleFlightBenchmarkInteractor : MJInteractor
+
+@end
+
+@implementation MJSingleFlightBenchmarkInteractor
+
++ (MJInteractorConcurrencyPolicy)concurrencyPolicy
+{
+    return MJInteractorConcurrencyPolicyBoundedParallel;
+}
+
+@end
+
+#pragma mark - Benchmark
+
+@implementation MJInteractorBenchmark
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _interactorCount = 100;
+        _jobsPerInteractor = 10;
+        _jobDuration = 0.005;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    NSMutableArray *results = [NSMutableArray array];
+    
+    [results addObject:[self mjz_measurePolicy:@"serial" interactorClass:MJSerialBenchmarkInteractor.class]];
+    [results addObject:[self mjz_measurePolicy:@"bounded_parallel" interactorClass:MJBoundedParallelBenchmarkInteractor.class]];
+    [results addObject:[self mjz_measurePolicy:@"keyed_serial" interactorClass:MJKeyedSerialBenchmarkInteractor.class]];
+    
+    return @{@"interactors": @(_interactorCount),
+             @"jobs_per_interactor": @(_jobsPerInteractor),
+             @"job_duration": @(_jobDuration),
+             @"results": results,
+             @"single_flight": [self mjz_measureSingleFlight],
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (NSDictionary*)mjz_measureSingleFlight
+{
+    __block atomic_int backendHits = 0;
+    __block atomic_int results = 0;
+    
+    dispatch_group_t group = dispatch_group_create();
+    NSTimeInterval duration = _jobDuration;
+    
+    // Identical requests from different interactors, all at once.
+    for (NSUInteger i = 0; i < _interactorCount; i++)
+    {
+        MJSingleFlightBenchmarkInteractor *interactor = [[MJSingleFlightBenchmarkInteractor alloc] init];
+        
+        dispatch_group_enter(group);
+        [interactor begin:^(void (^complete)(id result, NSError *error)) {
+            atomic_fetch_add(&backendHits, 1);
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(duration * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                complete(@"result", nil);
+            });
+        } forKey:@"request" end:^(id result, NSError *error) {
+            if (result)
+                atomic_fetch_add(&results, 1);
+            dispatch_group_leave(group);
+        }];
+    }
+    
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    return @{@"requests": @(_interactorCount),
+             @"results": @(atomic_load(&results)),
+             @"backend_hits": @(atomic_load(&backendHits)),
+             };
+}
+
+- (NSDictionary*)mjz_measurePolicy:(NSString*)policy interactorClass:(Class)interactorClass
+{
+    NSMutableArray *interactors = [NSMutableArray arrayWithCapacity:_interactorCount];
+    for (NSUInteger i = 0; i < _interactorCount; i++)
+    {
+        MJSerialBenchmarkInteractor *interactor = [[interactorClass alloc] init];
+        interactor.index = i;
+        [interactors addObject:interactor];
+    }
+    
+    NSUInteger jobCount = _interactorCount * _jobsPerInteractor;
+    dispatch_group_t group = dispatch_group_create();
+    
+    NSUInteger initialThreadCount = MJInteractorBenchmarkThreadCount();
+    __block NSUInteger peakThreadCount = initialThreadCount;
+    __block volatile BOOL finished = NO;
+    
+    // Samples the thread count while jobs are running.
+    dispatch_group_t samplingGroup = dispatch_group_create();
+    dispatch_group_async(samplingGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        while (!finished)
+        {
+            peakThreadCount = MAX(peakThreadCount, MJInteractorBenchmarkThreadCount());
+            usleep(1000);
+        }
+    });
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    for (NSUInteger i = 0; i < _jobsPerInteractor; i++)
+    {
+        for (MJSerialBenchmarkInteractor *interactor in interactors)
+        {
+            dispatch_group_enter(group);
+            [interactor performJobWithDuration:_jobDuration completion:^{
+                dispatch_group_leave(group);
+            }];
+        }
+    }
+    
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    finished = YES;
+    dispatch_group_wait(samplingGroup, DISPATCH_TIME_FOREVER);
+    
+    return @{@"policy": policy,
+             @"jobs": @(jobCount),
+             @"seconds": @(elapsed),
+             @"jobs_per_s": @(jobCount / elapsed),
+             @"initial_threads": @(initialThreadCount),
+             @"peak_threads": @(peakThreadCount),
+             };
+}
+
+@end
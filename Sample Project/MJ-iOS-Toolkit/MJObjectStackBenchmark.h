@@ -0,0 +1,49 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Benchmark of MJObjectStack.
+ * @discussion The stack is filled with a number of entries, then lookups, removals and churn (pushes, pops and deallocated entries) are measured. Each result contains the nanoseconds per operation of a phase.
+ *
+ * Launch the sample app with the `-MJObjectStackBenchmark` argument to run it and print the JSON report to the standard output.
+ **/
+@interface MJObjectStackBenchmark : NSObject
+
+/**
+ * The number of entries of the stack. Default value is 10000.
+ **/
+@property (nonatomic, assign) NSUInteger entryCount;
+
+/**
+ * The number of operations of each phase. Default value is 100000.
+ **/
+@property (nonatomic, assign) NSUInteger operationCount;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
@@ -0,0 +1,143 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJObjectStackBenchmark.h"
+
+#import "MJObjectStack.h"
+
+@interface MJObjectStackBenchmarkEntry : NSObject <MJObjectStackIdentity>
+
+@property (nonatomic, strong) NSString *identity;
+
+@end
+
+@implementation MJObjectStackBenchmarkEntry
+
+- (NSString*)objectStackIdentity
+{
+    return _identity;
+}
+
+@end
+
+#pragma mark -
+
+@implementation MJObjectStackBenchmark
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _entryCount = 10000;
+        _operationCount = 100000;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    MJObjectStack *stack = [[MJObjectStack alloc] init];
+    NSMutableArray <MJObjectStackBenchmarkEntry*> *entries = [NSMutableArray arrayWithCapacity:_entryCount];
+    
+    for (NSUInteger i = 0; i < _entryCount; i++)
+    {
+        MJObjectStackBenchmarkEntry *entry = [[MJObjectStackBenchmarkEntry alloc] init];
+        entry.identity = [NSString stringWithFormat:@"entry.%lu", (unsigned long)i];
+        [entries addObject:entry];
+    }
+    
+    NSUInteger entryCount = _entryCount;
+    NSMutableArray *results = [NSMutableArray array];
+    
+    [results addObject:[self mjz_measurePhase:@"push" operations:entryCount block:^(NSUInteger i) {
+        [stack push:entries[i]];
+    }]];
+    
+    [results addObject:[self mjz_measurePhase:@"contains" operations:_operationCount block:^(NSUInteger i) {
+        [stack contains:entries[arc4random_uniform((uint32_t)entryCount)]];
+    }]];
+    
+    [results addObject:[self mjz_measurePhase:@"is_top" operations:_operationCount block:^(NSUInteger i) {
+        [stack isTop:entries[arc4random_uniform((uint32_t)entryCount)]];
+    }]];
+    
+    [results addObject:[self mjz_measurePhase:@"push_existing" operations:_operationCount block:^(NSUInteger i) {
+        [stack push:entries[arc4random_uniform((uint32_t)entryCount)]];
+    }]];
+    
+    [results addObject:[self mjz_measurePhase:@"remove_push" operations:_operationCount block:^(NSUInteger i) {
+        MJObjectStackBenchmarkEntry *entry = entries[arc4random_uniform((uint32_t)entryCount)];
+        [stack remove:entry];
+        [stack push:entry];
+    }]];
+    
+    // Churn: half of the entries are deallocated and replaced by new ones, then the stack is read and popped.
+    @autoreleasepool
+    {
+        for (NSUInteger i = 0; i < entryCount; i += 2)
+        {
+            MJObjectStackBenchmarkEntry *entry = [[MJObjectStackBenchmarkEntry alloc] init];
+            entry.identity = [NSString stringWithFormat:@"churn.%lu", (unsigned long)i];
+            entries[i] = entry;
+        }
+    }
+    
+    [results addObject:[self mjz_measurePhase:@"churn_push_top" operations:_operationCount block:^(NSUInteger i) {
+        MJObjectStackBenchmarkEntry *entry = entries[arc4random_uniform((uint32_t)entryCount)];
+        [stack push:entry];
+        [stack top];
+    }]];
+    
+    [results addObject:[self mjz_measurePhase:@"pop" operations:entryCount block:^(NSUInteger i) {
+        [stack top];
+        [stack pop];
+    }]];
+    
+    return @{@"entries": @(_entryCount),
+             @"operations": @(_operationCount),
+             @"results": results,
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (NSDictionary*)mjz_measurePhase:(NSString*)phase operations:(NSUInteger)operations block:(void (^)(NSUInteger i))block
+{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    @autoreleasepool
+    {
+        for (NSUInteger i = 0; i < operations; i++)
+            block(i);
+    }
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    return @{@"phase": phase,
+             @"operations": @(operations),
+             @"ns_per_op": @(elapsed * 1e9 / MAX(operations, 1)),
+             };
+}
+
+@end
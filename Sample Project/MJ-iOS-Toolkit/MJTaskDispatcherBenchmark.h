@@ -0,0 +1,49 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Contention benchmark of MJTaskDispatcher.
+ * @discussion Tasks are started and then completed from several threads at once, while another thread reads the pending count. The same workload runs against a reference dispatcher guarded by a single `@synchronized` lock. Each result contains the operations per second of each phase.
+ *
+ * Launch the sample app with the `-MJTaskDispatcherBenchmark` argument to run it and print the JSON report to the standard output.
+ **/
+@interface MJTaskDispatcherBenchmark : NSObject
+
+/**
+ * The number of tasks. Default value is 10000.
+ **/
+@property (nonatomic, assign) NSUInteger taskCount;
+
+/**
+ * The number of threads completing tasks. Default value is 8.
+ **/
+@property (nonatomic, assign) NSUInteger threadCount;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
@@ -0,0 +1,205 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJTaskDispatcherBenchmark.h"
+
+#import <stdatomic.h>
+
+#import "MJTaskDispatcher.h"
+
+#pragma mark - Reference dispatcher
+
+/**
+ * Reference dispatcher with a single lock for the whole task table.
+ **/
+@interface MJLockedTaskDispatcher : NSObject
+
+- (NSUInteger)count;
+- (void)startTaskWithKey:(NSString*)key;
+- (void)completeTaskWithKey:(NSString*)key object:(id)object succeed:(BOOL)succeed;
+
+@end
+
+@implementation MJLockedTaskDispatcher
+{
+    NSMutableSet *_pendingTasks;
+    NSMutableSet *_completedTasks;
+    NSMutableSet *_failedTasks;
+    NSMutableDictionary *_objects;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _pendingTasks = [NSMutableSet set];
+        _completedTasks = [NSMutableSet set];
+        _failedTasks = [NSMutableSet set];
+        _objects = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    @synchronized(self)
+    {
+        return _pendingTasks.count;
+    }
+}
+
+- (void)startTaskWithKey:(NSString*)key
+{
+    @synchronized(self)
+    {
+        [_pendingTasks addObject:key];
+    }
+}
+
+- (void)completeTaskWithKey:(NSString*)key object:(id)object succeed:(BOOL)succeed
+{
+    @synchronized(self)
+    {
+        [_pendingTasks removeObject:key];
+        
+        if (succeed)
+            [_completedTasks addObject:key];
+        else
+            [_failedTasks addObject:key];
+        
+        if (object)
+            [_objects setObject:object forKey:key];
+        
+        if (_pendingTasks.count == 0)
+        {
+            // Same snapshot the observers would receive.
+            __unused NSSet *completedTasks = [_completedTasks copy];
+            __unused NSSet *failedTasks = [_failedTasks copy];
+            __unused NSDictionary *objects = [_objects copy];
+        }
+    }
+}
+
+@end
+
+#pragma mark - Benchmark
+
+@interface MJTaskDispatcherBenchmark () <MJTaskDispatcherObserver>
+
+@end
+
+@implementation MJTaskDispatcherBenchmark
+{
+    atomic_int _notificationCount;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _taskCount = 10000;
+        _threadCount = 8;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:_taskCount];
+    for (NSUInteger i = 0; i < _taskCount; i++)
+        [keys addObject:[NSString stringWithFormat:@"task.%lu", (unsigned long)i]];
+    
+    MJTaskDispatcher *dispatcher = [[MJTaskDispatcher alloc] init];
+    [dispatcher addObserver:self];
+    atomic_store(&_notificationCount, 0);
+    
+    NSMutableDictionary *sharded = [[self mjz_measureDispatcher:dispatcher keys:keys] mutableCopy];
+    sharded[@"dispatcher"] = @"sharded";
+    sharded[@"notifications"] = @(atomic_load(&_notificationCount));
+    
+    NSMutableDictionary *locked = [[self mjz_measureDispatcher:[[MJLockedTaskDispatcher alloc] init] keys:keys] mutableCopy];
+    locked[@"dispatcher"] = @"locked";
+    
+    return @{@"tasks": @(_taskCount),
+             @"threads": @(_threadCount),
+             @"results": @[sharded, locked],
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (NSDictionary*)mjz_measureDispatcher:(id)dispatcher keys:(NSArray <NSString*> *)keys
+{
+    NSUInteger taskCount = keys.count;
+    NSUInteger threadCount = MAX(_threadCount, 1);
+    
+    __block atomic_bool finished = NO;
+    __block atomic_int countReads = 0;
+    
+    // Reads the pending count while tasks are being started and completed.
+    dispatch_group_t readingGroup = dispatch_group_create();
+    dispatch_group_async(readingGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        while (!atomic_load(&finished))
+        {
+            [dispatcher count];
+            atomic_fetch_add(&countReads, 1);
+        }
+    });
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    dispatch_apply(threadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        for (NSUInteger i = thread; i < taskCount; i += threadCount)
+            [dispatcher startTaskWithKey:keys[i]];
+    });
+    
+    CFAbsoluteTime started = CFAbsoluteTimeGetCurrent();
+    
+    dispatch_apply(threadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        for (NSUInteger i = thread; i < taskCount; i += threadCount)
+            [dispatcher completeTaskWithKey:keys[i] object:@(i) succeed:(i % 10 != 0)];
+    });
+    
+    CFAbsoluteTime completed = CFAbsoluteTimeGetCurrent();
+    
+    atomic_store(&finished, YES);
+    dispatch_group_wait(readingGroup, DISPATCH_TIME_FOREVER);
+    
+    return @{@"start_ops_per_s": @(taskCount / (started - start)),
+             @"complete_ops_per_s": @(taskCount / (completed - started)),
+             @"seconds": @(completed - start),
+             @"count_reads": @(atomic_load(&countReads)),
+             @"pending": @([dispatcher count]),
+             };
+}
+
+#pragma mark - MJTaskDispatcherObserver
+
+- (void)dispatcher:(MJTaskDispatcher*)dispatcher didCompleteTasks:(NSSet*)completedTasks failedTasks:(NSSet*)failedTasks objects:(NSDictionary*)objects
+{
+    atomic_fetch_add(&_notificationCount, 1);
+}
+
+@end
@@ -0,0 +1,59 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Benchmark of MJTaskExecutor against launching every task at once.
+ * @discussion Each task allocates a buffer and simulates an asynchronous request that completes after a delay, releasing the buffer. Tasks are launched once all at once and once through an executor with a limited concurrency, both reporting to a MJTaskDispatcher. Each result contains the tasks per second, the peak resident memory growth and the peak number of threads.
+ *
+ * Launch the sample app with the `-MJTaskExecutorBenchmark` argument to run it and print the JSON report to the standard output.
+ **/
+@interface MJTaskExecutorBenchmark : NSObject
+
+/**
+ * The number of tasks. Default value is 10000.
+ **/
+@property (nonatomic, assign) NSUInteger taskCount;
+
+/**
+ * The buffer allocated by each task. Default value is 16 KB.
+ **/
+@property (nonatomic, assign) NSUInteger bufferSize;
+
+/**
+ * The simulated duration of each request. Default value is 2 milliseconds.
+ **/
+@property (nonatomic, assign) NSTimeInterval taskDuration;
+
+/**
+ * The concurrency limit of the executor. Default value is 16.
+ **/
+@property (nonatomic, assign) NSUInteger maxConcurrentTasks;
+
+/**
+ * Runs the benchmark.
+ * @return A report with the results, ready to be serialized as JSON.
+ **/
+- (NSDictionary*)run;
+
+/**
+ * Runs the benchmark.
+ * @return The report as JSON data.
+ **/
+- (NSData*)runJSON;
+
+@end
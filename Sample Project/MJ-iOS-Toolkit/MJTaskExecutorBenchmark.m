@@ -0,0 +1,177 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJTaskExecutorBenchmark.h"
+
+#import <mach/mach.h>
+
+#import "MJTaskExecutor.h"
+
+static NSUInteger MJTaskExecutorBenchmarkResidentSize()
+{
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0;
+    
+    return (NSUInteger)info.resident_size;
+}
+
+static NSUInteger MJTaskExecutorBenchmarkThreadCount()
+{
+    thread_act_array_t threads = NULL;
+    mach_msg_type_number_t count = 0;
+    
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS)
+        return 0;
+    
+    for (mach_msg_type_number_t i = 0; i < count; i++)
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+    
+    return count;
+}
+
+@interface MJTaskExecutorBenchmark () <MJTaskDispatcherObserver>
+
+@end
+
+@implementation MJTaskExecutorBenchmark
+{
+    dispatch_semaphore_t _completion;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _taskCount = 10000;
+        _bufferSize = 16 * 1024;
+        _taskDuration = 0.002;
+        _maxConcurrentTasks = 16;
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (NSDictionary*)run
+{
+    NSDictionary *fireAll = [self mjz_measureMode:@"fire_all" block:^(MJTaskDispatcher *dispatcher, MJTaskExecutorBlock block) {
+        for (NSUInteger i = 0; i < _taskCount; i++)
+        {
+            NSString *key = [NSString stringWithFormat:@"task.%lu", (unsigned long)i];
+            [dispatcher startTaskWithKey:key];
+            
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                block(^(id object, BOOL succeed) {
+                    [dispatcher completeTaskWithKey:key object:object succeed:succeed];
+                });
+            });
+        }
+    }];
+    
+    NSDictionary *executor = [self mjz_measureMode:@"executor" block:^(MJTaskDispatcher *dispatcher, MJTaskExecutorBlock block) {
+        MJTaskExecutor *executor = [[MJTaskExecutor alloc] initWithDispatcher:dispatcher];
+        executor.maxConcurrentTasks = _maxConcurrentTasks;
+        
+        for (NSUInteger i = 0; i < _taskCount; i++)
+            [executor submitTaskWithKey:[NSString stringWithFormat:@"task.%lu", (unsigned long)i] block:block];
+    }];
+    
+    return @{@"tasks": @(_taskCount),
+             @"buffer_size": @(_bufferSize),
+             @"task_duration": @(_taskDuration),
+             @"max_concurrent_tasks": @(_maxConcurrentTasks),
+             @"results": @[fireAll, executor],
+             };
+}
+
+- (NSData*)runJSON
+{
+    return [NSJSONSerialization dataWithJSONObject:[self run] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+#pragma mark Private Methods
+
+- (NSDictionary*)mjz_measureMode:(NSString*)mode block:(void (^)(MJTaskDispatcher *dispatcher, MJTaskExecutorBlock block))launchBlock
+{
+    NSUInteger bufferSize = _bufferSize;
+    NSTimeInterval duration = _taskDuration;
+    
+    MJTaskExecutorBlock block = ^(void (^completion)(id object, BOOL succeed)) {
+        // The buffer is alive until the simulated request completes.
+        NSMutableData *buffer = [NSMutableData dataWithLength:bufferSize];
+        memset(buffer.mutableBytes, 1, bufferSize);
+        
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(duration * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [buffer setLength:0];
+            completion(nil, YES);
+        });
+    };
+    
+    MJTaskDispatcher *dispatcher = [[MJTaskDispatcher alloc] init];
+    [dispatcher addObserver:self];
+    
+    _completion = dispatch_semaphore_create(0);
+    
+    NSUInteger initialResidentSize = MJTaskExecutorBenchmarkResidentSize();
+    NSUInteger initialThreadCount = MJTaskExecutorBenchmarkThreadCount();
+    __block NSUInteger peakResidentSize = initialResidentSize;
+    __block NSUInteger peakThreadCount = initialThreadCount;
+    __block volatile BOOL finished = NO;
+    
+    // Samples memory and threads while tasks are running.
+    dispatch_group_t samplingGroup = dispatch_group_create();
+    dispatch_group_async(samplingGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        while (!finished)
+        {
+            peakResidentSize = MAX(peakResidentSize, MJTaskExecutorBenchmarkResidentSize());
+            peakThreadCount = MAX(peakThreadCount, MJTaskExecutorBenchmarkThreadCount());
+            usleep(1000);
+        }
+    });
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    launchBlock(dispatcher, block);
+    dispatch_semaphore_wait(_completion, DISPATCH_TIME_FOREVER);
+    
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    finished = YES;
+    dispatch_group_wait(samplingGroup, DISPATCH_TIME_FOREVER);
+    
+    return @{@"mode": mode,
+             @"seconds": @(elapsed),
+             @"tasks_per_s": @(_taskCount / elapsed),
+             @"peak_memory_growth": @(peakResidentSize - initialResidentSize),
+             @"initial_threads": @(initialThreadCount),
+             @"peak_threads": @(peakThreadCount),
+             };
+}
+
+#pragma mark - MJTaskDispatcherObserver
+
+- (void)dispatcher:(MJTaskDispatcher*)dispatcher didCompleteTasks:(NSSet*)completedTasks failedTasks:(NSSet*)failedTasks objects:(NSDictionary*)objects
+{
+    if (completedTasks.count + failedTasks.count >= _taskCount)
+        dispatch_semaphore_signal(_completion);
+}
+
+@end
@@ -0,0 +1,192 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJAppLinkRecognizer.h"
+
+@interface MJAppLinkRecognizerTests : XCTestCase <MJAppLinkRecognizerDelegate>
+
+@end
+
+@implementation MJAppLinkRecognizerTests
+{
+    NSDictionary <NSString*, NSString*> *_patterns;
+    NSSet <NSString*> *_vetoedKeys;
+    NSString *_recognizedKey;
+    NSArray *_recognizedComponents;
+    uint32_t _seed;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // Routes sharing prefixes and overlapping captures, plus patterns only matched with regular expressions.
+    _patterns = @{@"home": @"//example\\.com/home",
+                  @"user": [NSString stringWithFormat:@"//example\\.com/users/%@", MJAppLinkPatternNumeric],
+                  @"user_name": [NSString stringWithFormat:@"//example\\.com/users/%@", MJAppLinkPatternAlphanumeric],
+                  @"comment": [NSString stringWithFormat:@"//example\\.com/users/%@/comments/%@", MJAppLinkPatternNumeric, MJAppLinkPatternNumeric],
+                  @"tag": [NSString stringWithFormat:@"//example\\.com/tags/%@", MJAppLinkPatternAlphanumericAndDash],
+                  @"profile": [NSString stringWithFormat:@"//example\\.com/%@/profile", MJAppLinkPatternAlphanumeric],
+                  @"search": [NSString stringWithFormat:@"//example\\.com/search/%@", MJAppLinkPatternNonNumeric],
+                  @"file": @"//example\\.com/files/.*",
+                  };
+    
+    _vetoedKeys = [NSSet set];
+    _seed = 42;
+}
+
+#pragma mark Equivalence
+
+- (void)testAnchoredRoutesMatchAsRegularExpressions
+{
+    [self mjz_assertEquivalenceWithOptions:MJAppLinkOptionsAnchoredStart | MJAppLinkOptionsAnchoredEnd];
+}
+
+- (void)testCaseInsensitiveRoutesMatchAsRegularExpressions
+{
+    [self mjz_assertEquivalenceWithOptions:MJAppLinkOptionsAnchoredStart | MJAppLinkOptionsAnchoredEnd | MJAppLinkOptionsCaseInsensitive];
+}
+
+- (void)testVetoedRoutesFallBackAsRegularExpressions
+{
+    _vetoedKeys = [NSSet setWithObjects:@"user", @"profile", @"search", nil];
+    
+    [self mjz_assertEquivalenceWithOptions:MJAppLinkOptionsAnchoredStart | MJAppLinkOptionsAnchoredEnd];
+}
+
+- (void)testRoutesAreTriedFromTheMostSpecificCapture
+{
+    MJAppLinkRecognizer *recognizer = [self mjz_recognizerWithOptions:MJAppLinkOptionsAnchoredStart | MJAppLinkOptionsAnchoredEnd];
+    
+    XCTAssertEqualObjects([self mjz_keyForURLString:@"mjapp://example.com/users/42" recognizer:recognizer], @"user");
+    XCTAssertEqualObjects([self mjz_keyForURLString:@"mjapp://example.com/users/john" recognizer:recognizer], @"user_name");
+    XCTAssertEqualObjects(_recognizedComponents, @[@"john"]);
+    XCTAssertNil([self mjz_keyForURLString:@"mjapp://example.com/users/42/" recognizer:recognizer]);
+    XCTAssertNil([self mjz_keyForURLString:@"other://example.com/home" recognizer:recognizer]);
+}
+
+#pragma mark MJAppLinkRecognizerDelegate
+
+- (BOOL)appLinkRecognizer:(MJAppLinkRecognizer*)recognizer willRecognizeURLForKey:(NSString*)key components:(NSArray*)components
+{
+    return ![_vetoedKeys containsObject:key];
+}
+
+- (void)appLinkRecognizer:(MJAppLinkRecognizer*)recognizer didRecognizeURLForKey:(NSString*)key components:(NSArray*)components
+{
+    _recognizedKey = key;
+    _recognizedComponents = components;
+}
+
+#pragma mark Private Methods
+
+- (MJAppLinkRecognizer*)mjz_recognizerWithOptions:(MJAppLinkOptions)options
+{
+    NSDictionary *patterns = _patterns;
+    
+    MJAppLinkRecognizer *recognizer = [[MJAppLinkRecognizer alloc] initWithConfiguration:^(MJAppLinkRecognizerConfiguration *configuration) {
+        configuration.scheme = @"mjapp";
+        configuration.options = options;
+        
+        [patterns enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *pattern, BOOL *stop) {
+            [configuration setPattern:pattern forKey:key];
+        }];
+    }];
+    
+    recognizer.delegate = self;
+    return recognizer;
+}
+
+- (NSString*)mjz_keyForURLString:(NSString*)string recognizer:(MJAppLinkRecognizer*)recognizer
+{
+    _recognizedKey = nil;
+    _recognizedComponents = nil;
+    
+    if ([recognizer handleURL:[NSURL URLWithString:string]] != MJAppLinkRecognizerResultValid)
+        return nil;
+    
+    return _recognizedKey;
+}
+
+- (void)mjz_assertEquivalenceWithOptions:(MJAppLinkOptions)options
+{
+    MJAppLinkRecognizer *recognizer = [self mjz_recognizerWithOptions:options];
+    
+    // The reference: one anchored regular expression per pattern.
+    NSRegularExpressionOptions regularExpressionOptions = (options & MJAppLinkOptionsCaseInsensitive) != 0 ? NSRegularExpressionCaseInsensitive : 0;
+    NSMutableDictionary <NSString*, NSRegularExpression*> *regexes = [NSMutableDictionary dictionary];
+    
+    [_patterns enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *pattern, BOOL *stop) {
+        NSString *anchoredPattern = [NSString stringWithFormat:@"^%@$", pattern];
+        regexes[key] = [NSRegularExpression regularExpressionWithPattern:anchoredPattern options:regularExpressionOptions error:nil];
+    }];
+    
+    NSArray *hosts = @[@"example.com", @"Example.COM", @"example.org"];
+    NSArray *segments = @[@"home", @"HOME", @"users", @"comments", @"tags", @"profile", @"search", @"files",
+                          @"42", @"007", @"john", @"x_y", @"A1", @"a-b", @"a,b", @"a.b", @"caf%C3%A9", @"", @"-",
+                          ];
+    
+    for (NSUInteger i = 0; i < 5000; i++)
+    {
+        NSMutableString *string = [NSMutableString stringWithFormat:@"mjapp://%@", hosts[[self mjz_random] % hosts.count]];
+        NSUInteger segmentCount = 1 + [self mjz_random] % 4;
+        
+        for (NSUInteger j = 0; j < segmentCount; j++)
+            [string appendFormat:@"/%@", segments[[self mjz_random] % segments.count]];
+        
+        NSURL *url = [NSURL URLWithString:string];
+        NSString *linkString = url.resourceSpecifier;
+        
+        NSMutableDictionary <NSString*, NSArray*> *matches = [NSMutableDictionary dictionary];
+        
+        [regexes enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSRegularExpression *regex, BOOL *stop) {
+            NSTextCheckingResult *result = [regex firstMatchInString:linkString options:0 range:NSMakeRange(0, linkString.length)];
+            
+            if (!result || [_vetoedKeys containsObject:key])
+                return;
+            
+            NSMutableArray *components = [NSMutableArray array];
+            for (NSUInteger k = 1; k < result.numberOfRanges; k++)
+                [components addObject:[linkString substringWithRange:[result rangeAtIndex:k]]];
+            
+            matches[key] = components;
+        }];
+        
+        NSString *key = [self mjz_keyForURLString:string recognizer:recognizer];
+        
+        if (matches.count == 0)
+        {
+            XCTAssertNil(key, @"%@", string);
+        }
+        else
+        {
+            XCTAssertNotNil(key, @"%@", string);
+            XCTAssertEqualObjects(_recognizedComponents, matches[key], @"%@", string);
+        }
+    }
+}
+
+- (uint32_t)mjz_random
+{
+    // Fixed sequence, so failures can be reproduced.
+    _seed = _seed * 1664525 + 1013904223;
+    return _seed >> 8;
+}
+
+@end
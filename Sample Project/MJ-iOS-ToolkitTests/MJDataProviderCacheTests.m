@@ -0,0 +1,299 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MJDataProviderCache.h"
+
+@interface MJDataProviderCacheTests : XCTestCase
+
+@end
+
+@implementation MJDataProviderCacheTests
+{
+    NSURL *_directoryURL;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    _directoryURL = [NSURL fileURLWithPath:path isDirectory:YES];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:_directoryURL error:nil];
+    
+    [super tearDown];
+}
+
+#pragma mark Expiration
+
+- (void)testObjectWithoutTimeToLiveNeverExpires
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    [cache setObject:@"value" forKey:@"key"];
+    
+    MJDataProviderCacheEntry *entry = [cache entryForKey:@"key"];
+    
+    XCTAssertEqualObjects(entry.object, @"value");
+    XCTAssertNil(entry.expirationDate);
+    XCTAssertNil(entry.staleDate);
+    XCTAssertFalse(entry.isExpired);
+    XCTAssertFalse(entry.isStale);
+}
+
+- (void)testExpiredObjectIsServedStaleUntilTheRevalidationWindowEnds
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    [cache setObject:@"value" forKey:@"key" cost:0 timeToLive:0.1 staleWhileRevalidate:0.3];
+    
+    XCTAssertEqualObjects([cache objectForKey:@"key"], @"value");
+    
+    [NSThread sleepForTimeInterval:0.2];
+    
+    // Expired: not returned as object, but the entry can still be used while revalidating.
+    MJDataProviderCacheEntry *entry = [cache entryForKey:@"key"];
+    XCTAssertNil([cache objectForKey:@"key"]);
+    XCTAssertEqualObjects(entry.object, @"value");
+    XCTAssertTrue(entry.isExpired);
+    XCTAssertFalse(entry.isStale);
+    
+    [NSThread sleepForTimeInterval:0.3];
+    
+    XCTAssertTrue(entry.isStale);
+}
+
+#pragma mark Memory budget
+
+- (void)testMemoryUsageIsBoundedByTheCapacity
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    cache.memoryCapacity = 100;
+    
+    [cache setObject:@"a" forKey:@"a" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    [cache setObject:@"b" forKey:@"b" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    XCTAssertEqual(cache.memoryUsage, 80);
+    
+    [cache setObject:@"c" forKey:@"c" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    XCTAssertEqual(cache.memoryUsage, 80);
+    
+    // Memory only, so the least recently used object is gone.
+    XCTAssertNil([cache objectForKey:@"a"]);
+    XCTAssertEqualObjects([cache objectForKey:@"b"], @"b");
+    XCTAssertEqualObjects([cache objectForKey:@"c"], @"c");
+}
+
+- (void)testReadingAnObjectMakesItTheMostRecentlyUsed
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    cache.memoryCapacity = 100;
+    
+    [cache setObject:@"a" forKey:@"a" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    [cache setObject:@"b" forKey:@"b" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    
+    XCTAssertEqualObjects([cache objectForKey:@"a"], @"a");
+    
+    [cache setObject:@"c" forKey:@"c" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    
+    XCTAssertEqualObjects([cache objectForKey:@"a"], @"a");
+    XCTAssertNil([cache objectForKey:@"b"]);
+}
+
+- (void)testReducingTheCapacityTrimsTheMemory
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    
+    for (NSUInteger i = 0; i < 10; i++)
+        [cache setObject:@(i) forKey:@(i).stringValue cost:10 timeToLive:0 staleWhileRevalidate:0];
+    
+    cache.memoryCapacity = 35;
+    
+    XCTAssertEqual(cache.memoryUsage, 30);
+    XCTAssertNil([cache objectForKey:@"6"]);
+    XCTAssertEqualObjects([cache objectForKey:@"9"], @9);
+}
+
+#pragma mark Disk
+
+- (void)testObjectsEvictedFromMemoryArePromotedFromDisk
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    cache.memoryCapacity = 50;
+    
+    [cache setObject:@"a" forKey:@"a" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    [cache setObject:@"b" forKey:@"b" cost:40 timeToLive:0 staleWhileRevalidate:0];
+    
+    MJDataProviderCacheEntry *entry = [cache entryForKey:@"a"];
+    
+    XCTAssertEqualObjects(entry.object, @"a");
+    XCTAssertEqualObjects([cache objectForKey:@"b"], @"b");
+}
+
+- (void)testCostSurvivesPromotionFromDisk
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    MJDataProviderCacheEntry *entry = [cache setObject:@"value" forKey:@"key" cost:1000 timeToLive:0 staleWhileRevalidate:0 tag:nil];
+    MJDataProviderCacheEntry *sizedEntry = [cache setObject:@"value" forKey:@"sized" cost:0 timeToLive:0 staleWhileRevalidate:0 tag:nil];
+    
+    [cache removeAllObjectsFromMemory];
+    
+    XCTAssertEqual([cache entryForKey:@"key"].cost, 1000);
+    XCTAssertEqual([cache entryForKey:@"sized"].cost, sizedEntry.cost);
+    XCTAssertEqual(cache.memoryUsage, entry.cost + sizedEntry.cost);
+}
+
+- (void)testRemovedObjectsAreNotReadFromDisk
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    
+    [cache setObject:@"a" forKey:@"a"];
+    [cache removeObjectForKey:@"a"];
+    
+    XCTAssertNil([cache entryForKey:@"a"]);
+    
+    [cache setObject:@"b" forKey:@"b"];
+    [cache removeAllObjects];
+    
+    XCTAssertNil([cache entryForKey:@"b"]);
+}
+
+- (void)testAsynchronousReadPromotesFromDisk
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    [cache setObject:@"a" forKey:@"a"];
+    [cache removeAllObjectsFromMemory];
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"entry"];
+    
+    [cache entryForKey:@"a" completion:^(MJDataProviderCacheEntry *entry) {
+        XCTAssertTrue([NSThread isMainThread]);
+        XCTAssertEqualObjects(entry.object, @"a");
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testTrimmingTheDiskRemovesStaleFiles
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    [cache setObject:@"stale" forKey:@"stale" cost:0 timeToLive:0.05 staleWhileRevalidate:0];
+    [cache setObject:@"fresh" forKey:@"fresh"];
+    
+    XCTAssertTrue([self mjz_waitForFileCount:2]);
+    
+    [NSThread sleepForTimeInterval:0.1];
+    [cache trimDisk];
+    
+    XCTAssertTrue([self mjz_waitForFileCount:1]);
+    
+    [cache removeAllObjectsFromMemory];
+    XCTAssertNil([cache entryForKey:@"stale"]);
+    XCTAssertEqualObjects([cache objectForKey:@"fresh"], @"fresh");
+}
+
+- (void)testTrimmingTheDiskKeepsItUnderTheCapacity
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    
+    NSData *payload = [NSMutableData dataWithLength:4096];
+    for (NSUInteger i = 0; i < 8; i++)
+        [cache setObject:payload forKey:@(i).stringValue];
+    
+    XCTAssertTrue([self mjz_waitForFileCount:8]);
+    
+    cache.diskCapacity = 4 * 4096;
+    
+    // Trimmed down to three quarters of the capacity.
+    XCTAssertTrue([self mjz_waitForDiskUsageAtMost:3 * 4096]);
+}
+
+- (void)testContentHashSurvivesPromotionFromDisk
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:_directoryURL];
+    MJDataProviderCacheEntry *entry = [cache setObject:@"value" forKey:@"key" cost:0 timeToLive:0 staleWhileRevalidate:0 tag:nil];
+    
+    [cache removeAllObjectsFromMemory];
+    MJDataProviderCacheEntry *promotedEntry = [cache entryForKey:@"key"];
+    
+    XCTAssertEqualObjects(promotedEntry.contentHash, entry.contentHash);
+    XCTAssertTrue([promotedEntry hasSameContentAsEntry:entry]);
+}
+
+- (void)testTagsTakePrecedenceOverTheContentHash
+{
+    MJDataProviderCache *cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    MJDataProviderCacheEntry *entry1 = [cache setObject:@"value1" forKey:@"key" cost:0 timeToLive:0 staleWhileRevalidate:0 tag:@"v1"];
+    MJDataProviderCacheEntry *entry2 = [cache setObject:@"value2" forKey:@"key" cost:0 timeToLive:0 staleWhileRevalidate:0 tag:@"v1"];
+    MJDataProviderCacheEntry *entry3 = [cache setObject:@"value2" forKey:@"key" cost:0 timeToLive:0 staleWhileRevalidate:0 tag:nil];
+    
+    XCTAssertTrue([entry2 hasSameContentAsEntry:entry1]);
+    XCTAssertTrue([entry3 hasSameContentAsEntry:entry2]);
+    XCTAssertFalse([entry3 hasSameContentAsEntry:entry1]);
+    XCTAssertFalse([entry3 hasSameContentAsEntry:nil]);
+}
+
+#pragma mark Private Methods
+
+- (NSArray <NSURL*> *)mjz_files
+{
+    return [[NSFileManager defaultManager] contentsOfDirectoryAtURL:_directoryURL
+                                         includingPropertiesForKeys:@[NSURLFileSizeKey]
+                                                            options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                              error:nil];
+}
+
+- (BOOL)mjz_waitForCondition:(BOOL (^)(void))condition
+{
+    // Disk operations are asynchronous.
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+    
+    while (!condition())
+    {
+        if ([timeout timeIntervalSinceNow] < 0)
+            return NO;
+        
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    
+    return YES;
+}
+
+- (BOOL)mjz_waitForFileCount:(NSUInteger)count
+{
+    return [self mjz_waitForCondition:^BOOL{
+        return [self mjz_files].count == count;
+    }];
+}
+
+- (BOOL)mjz_waitForDiskUsageAtMost:(unsigned long long)usage
+{
+    return [self mjz_waitForCondition:^BOOL{
+        unsigned long long total = 0;
+        for (NSURL *url in [self mjz_files])
+        {
+            NSNumber *size = nil;
+            [url getResourceValue:&size forKey:NSURLFileSizeKey error:nil];
+            total += size.unsignedLongLongValue;
+        }
+        return total <= usage;
+    }];
+}
+
+@end
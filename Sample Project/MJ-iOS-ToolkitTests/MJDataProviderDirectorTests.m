@@ -0,0 +1,244 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJDataProviderDirector.h"
+
+@interface MJDataProviderDirectorTests : XCTestCase
+
+@end
+
+@implementation MJDataProviderDirectorTests
+{
+    MJDataProviderDirector *_director;
+    NSMutableArray <NSString*> *_events;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _director = [[MJDataProviderDirector alloc] init];
+    _director.cache = [[MJDataProviderCache alloc] initWithDirectoryURL:nil];
+    _director.timeToLive = 60;
+    _director.staleWhileRevalidate = 60;
+    
+    _events = [NSMutableArray array];
+}
+
+#pragma mark Stale-while-revalidate
+
+- (void)testMissingEntryIsDeliveredThroughTheUpdateBlock
+{
+    [self mjz_resolveWithNetworkObject:@"network" tag:nil];
+    
+    NSArray *events = @[@"network", @"update:network"];
+    XCTAssertEqualObjects(_events, events);
+    XCTAssertEqualObjects([_director.cache objectForKey:@"key"], @"network");
+}
+
+- (void)testFreshEntryIsNotRevalidated
+{
+    [_director.cache setObject:@"cached" forKey:@"key" cost:0 timeToLive:60 staleWhileRevalidate:60];
+    
+    [self mjz_resolveWithNetworkObject:@"network" tag:nil];
+    
+    NSArray *events = @[@"cache:cached"];
+    XCTAssertEqualObjects(_events, events);
+}
+
+- (void)testExpiredEntryIsServedAndRevalidated
+{
+    [_director.cache setObject:@"cached" forKey:@"key" cost:0 timeToLive:0.05 staleWhileRevalidate:60];
+    [NSThread sleepForTimeInterval:0.1];
+    
+    [self mjz_resolveWithNetworkObject:@"network" tag:nil];
+    
+    NSArray *events = @[@"cache:cached", @"revalidating", @"update:network"];
+    XCTAssertEqualObjects(_events, events);
+}
+
+- (void)testUnchangedContentDoesNotExecuteTheUpdateBlock
+{
+    [_director.cache setObject:@"cached" forKey:@"key" cost:0 timeToLive:0.05 staleWhileRevalidate:60];
+    [NSThread sleepForTimeInterval:0.1];
+    
+    [self mjz_resolveWithNetworkObject:@"cached" tag:nil];
+    
+    NSArray *events = @[@"cache:cached", @"revalidating"];
+    XCTAssertEqualObjects(_events, events);
+    XCTAssertFalse([_director.cache entryForKey:@"key"].isExpired);
+}
+
+- (void)testUnchangedTagDoesNotExecuteTheUpdateBlock
+{
+    [_director.cache setObject:@"cached" forKey:@"key" cost:0 timeToLive:0.05 staleWhileRevalidate:60 tag:@"v1"];
+    [NSThread sleepForTimeInterval:0.1];
+    
+    [self mjz_resolveWithNetworkObject:@"network" tag:@"v1"];
+    
+    NSArray *events = @[@"cache:cached", @"revalidating"];
+    XCTAssertEqualObjects(_events, events);
+}
+
+- (void)testStaleEntryIsNotServed
+{
+    [_director.cache setObject:@"cached" forKey:@"key" cost:0 timeToLive:0.05 staleWhileRevalidate:0.05];
+    [NSThread sleepForTimeInterval:0.15];
+    
+    [self mjz_resolveWithNetworkObject:@"network" tag:nil];
+    
+    NSArray *events = @[@"network", @"update:network"];
+    XCTAssertEqualObjects(_events, events);
+}
+
+- (void)testForceRefreshSkipsTheCache
+{
+    [_director.cache setObject:@"cached" forKey:@"key" cost:0 timeToLive:60 staleWhileRevalidate:60];
+    _director.forceRefresh = YES;
+    
+    [self mjz_resolveWithNetworkObject:@"network" tag:nil];
+    
+    NSArray *events = @[@"network", @"update:network"];
+    XCTAssertEqualObjects(_events, events);
+}
+
+#pragma mark Prefetching
+
+- (void)testPrefetchSkipsWarmKeys
+{
+    [_director.cache setObject:@"cached" forKey:@"a" cost:0 timeToLive:60 staleWhileRevalidate:60];
+    [_director.cache setObject:@"expired" forKey:@"b" cost:0 timeToLive:0.05 staleWhileRevalidate:60];
+    [NSThread sleepForTimeInterval:0.1];
+    
+    _director.scheduler = [[MJDataProviderScheduler alloc] init];
+    MJDataProviderPrefetchGroup *group = [self mjz_prefetchKeys:@[@"a", @"b", @"c"]];
+    
+    NSArray *keys = @[@"b", @"c"];
+    XCTAssertEqualObjects(group.keys, keys);
+    
+    NSArray *events = @[@"network:b", @"network:c"];
+    XCTAssertEqualObjects(_events, events);
+    XCTAssertEqualObjects([_director.cache objectForKey:@"a"], @"cached");
+}
+
+- (void)testPrefetchStoresResultsWithoutOtherBlocks
+{
+    _director.scheduler = [[MJDataProviderScheduler alloc] init];
+    NSMutableArray *events = _events;
+    
+    [_director prefetchKeys:@[@"a", @"b"] networkBlock:^(NSString *key, MJDataProviderDirectorResolver *resolver) {
+        [events addObject:[@"network:" stringByAppendingString:key]];
+        
+        // Prefetch resolvers have no cache block to route to.
+        [resolver resolveWithCache];
+        [resolver storeObject:[@"value:" stringByAppendingString:key]];
+        [resolver storeObject:[@"changed:" stringByAppendingString:key]];
+        [resolver finish];
+    }];
+    
+    NSArray *expectedEvents = @[@"network:a", @"network:b"];
+    XCTAssertEqualObjects(_events, expectedEvents);
+    XCTAssertEqualObjects([_director.cache objectForKey:@"a"], @"changed:a");
+    XCTAssertEqualObjects([_director.cache objectForKey:@"b"], @"changed:b");
+}
+
+- (void)testPrefetchUsesThePrefetchLane
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    _director.scheduler = scheduler;
+    _director.lane = MJDataProviderSchedulerLaneVisible;
+    
+    [self mjz_prefetchKeys:@[@"a", @"b", @"c"]];
+    
+    NSDictionary *statistics = scheduler.statistics;
+    XCTAssertEqualObjects(statistics[@"prefetch"][@"started"], @3);
+    XCTAssertEqualObjects(statistics[@"prefetch"][@"in_flight"], @0);
+    XCTAssertEqualObjects(statistics[@"visible"][@"started"], @0);
+}
+
+- (void)testCancelledPrefetchStopsPendingRequestsAndStores
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    scheduler.maxConcurrentRequests = 1;
+    _director.scheduler = scheduler;
+    
+    NSMutableArray *events = _events;
+    NSMutableArray <MJDataProviderDirectorResolver*> *resolvers = [NSMutableArray array];
+    
+    // The first request keeps its slot, so the others stay pending.
+    MJDataProviderPrefetchGroup *group = [_director prefetchKeys:@[@"a", @"b", @"c"] networkBlock:^(NSString *key, MJDataProviderDirectorResolver *resolver) {
+        @synchronized(events)
+        {
+            [events addObject:[@"network:" stringByAppendingString:key]];
+            [resolvers addObject:resolver];
+        }
+    }];
+    
+    XCTAssertEqualObjects(scheduler.statistics[@"prefetch"][@"queue_depth"], @2);
+    
+    [group cancel];
+    
+    XCTAssertTrue(group.isCancelled);
+    XCTAssertEqualObjects(scheduler.statistics[@"prefetch"][@"queue_depth"], @0);
+    XCTAssertEqualObjects(scheduler.statistics[@"prefetch"][@"in_flight"], @0);
+    XCTAssertEqualObjects(scheduler.statistics[@"prefetch"][@"cancelled"], @3);
+    
+    MJDataProviderDirectorResolver *resolver = resolvers.firstObject;
+    XCTAssertTrue(resolver.isCancelled);
+    
+    [resolver storeObject:@"late"];
+    XCTAssertNil([_director.cache objectForKey:@"a"]);
+    
+    [NSThread sleepForTimeInterval:0.1];
+    
+    @synchronized(events)
+    {
+        NSArray *expectedEvents = @[@"network:a"];
+        XCTAssertEqualObjects(events, expectedEvents);
+    }
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_resolveWithNetworkObject:(NSString*)object tag:(NSString*)tag
+{
+    NSMutableArray *events = _events;
+    
+    [_director networkBlock:^(MJDataProviderDirectorResolver *resolver) {
+        [events addObject:resolver.isRevalidating ? @"revalidating" : @"network"];
+        [resolver storeObject:object cost:0 tag:tag];
+    } cacheBlock:^(MJDataProviderDirectorResolver *resolver) {
+        [events addObject:[@"cache:" stringByAppendingString:resolver.cachedObject]];
+    } cacheKey:@"key" updateBlock:^(MJDataProviderDirectorResolver *resolver) {
+        [events addObject:[@"update:" stringByAppendingString:resolver.cachedObject]];
+    }];
+}
+
+- (MJDataProviderPrefetchGroup*)mjz_prefetchKeys:(NSArray <NSString*> *)keys
+{
+    NSMutableArray *events = _events;
+    
+    return [_director prefetchKeys:keys networkBlock:^(NSString *key, MJDataProviderDirectorResolver *resolver) {
+        [events addObject:[@"network:" stringByAppendingString:key]];
+        [resolver storeObject:[@"value:" stringByAppendingString:key]];
+        [resolver finish];
+    }];
+}
+
+@end
@@ -0,0 +1,171 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJDataProviderScheduler.h"
+
+@interface MJDataProviderSchedulerTests : XCTestCase
+
+@end
+
+@implementation MJDataProviderSchedulerTests
+
+#pragma mark Weights
+
+- (void)testDefaultWeights
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    
+    XCTAssertEqual([scheduler weightForLane:MJDataProviderSchedulerLaneVisible], 8);
+    XCTAssertEqual([scheduler weightForLane:MJDataProviderSchedulerLanePrefetch], 2);
+    XCTAssertEqual([scheduler weightForLane:MJDataProviderSchedulerLaneBackground], 1);
+}
+
+- (void)testWeightIsAtLeastOne
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    [scheduler setWeight:0 forLane:MJDataProviderSchedulerLanePrefetch];
+    
+    XCTAssertEqual([scheduler weightForLane:MJDataProviderSchedulerLanePrefetch], 1);
+}
+
+- (void)testLanesAreServedByWeight
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    scheduler.maxConcurrentRequests = 1;
+    [scheduler setWeight:2 forLane:MJDataProviderSchedulerLaneVisible];
+    [scheduler setWeight:1 forLane:MJDataProviderSchedulerLanePrefetch];
+    [scheduler setWeight:1 forLane:MJDataProviderSchedulerLaneBackground];
+    
+    // Holds the only slot, using the background credit of the first round.
+    MJDataProviderTicket *blocker = [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) { } lane:MJDataProviderSchedulerLaneBackground];
+    
+    NSMutableString *order = [NSMutableString string];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"order"];
+    
+    NSArray *lanes = @[@(MJDataProviderSchedulerLaneBackground), @(MJDataProviderSchedulerLaneBackground),
+                       @(MJDataProviderSchedulerLanePrefetch), @(MJDataProviderSchedulerLanePrefetch),
+                       @(MJDataProviderSchedulerLaneVisible), @(MJDataProviderSchedulerLaneVisible),
+                       @(MJDataProviderSchedulerLaneVisible), @(MJDataProviderSchedulerLaneVisible),
+                       ];
+    
+    for (NSNumber *lane in lanes)
+    {
+        [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) {
+            @synchronized(order)
+            {
+                [order appendString:@[@"V", @"P", @"B"][ticket.lane]];
+                if (order.length == lanes.count)
+                    [expectation fulfill];
+            }
+            [ticket finish];
+        } lane:lane.integerValue];
+    }
+    
+    [blocker finish];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    // Rounds of 2 visible, 1 prefetch and 1 background requests.
+    XCTAssertEqualObjects(order, @"VVPVVPBB");
+}
+
+#pragma mark Concurrency
+
+- (void)testRequestsAreStartedInTheCallingThreadWhileSlotsAreAvailable
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    scheduler.maxConcurrentRequests = 2;
+    
+    __block NSUInteger started = 0;
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) {
+            started++;
+        } lane:MJDataProviderSchedulerLaneVisible];
+    }
+    
+    XCTAssertEqual(started, 2);
+    
+    NSDictionary *statistics = [scheduler statistics][@"visible"];
+    XCTAssertEqualObjects(statistics[@"in_flight"], @2);
+    XCTAssertEqualObjects(statistics[@"queue_depth"], @1);
+}
+
+- (void)testFinishingARequestStartsThePendingOne
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    scheduler.maxConcurrentRequests = 1;
+    
+    MJDataProviderTicket *first = [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) { } lane:MJDataProviderSchedulerLaneVisible];
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"second"];
+    [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) {
+        [expectation fulfill];
+    } lane:MJDataProviderSchedulerLaneBackground];
+    
+    [first finish];
+    [first finish];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    NSDictionary *statistics = [scheduler statistics];
+    XCTAssertEqualObjects(statistics[@"visible"][@"in_flight"], @0);
+    XCTAssertEqualObjects(statistics[@"background"][@"in_flight"], @1);
+    XCTAssertEqualObjects(statistics[@"background"][@"started"], @1);
+}
+
+- (void)testCancelledRequestsAreNotExecuted
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    scheduler.maxConcurrentRequests = 1;
+    
+    MJDataProviderTicket *first = [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) { } lane:MJDataProviderSchedulerLaneVisible];
+    
+    __block BOOL executed = NO;
+    MJDataProviderTicket *second = [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) {
+        executed = YES;
+    } lane:MJDataProviderSchedulerLaneVisible];
+    
+    [second cancel];
+    [first finish];
+    
+    XCTAssertTrue(second.isCancelled);
+    
+    NSDictionary *statistics = [scheduler statistics][@"visible"];
+    XCTAssertEqualObjects(statistics[@"queue_depth"], @0);
+    XCTAssertEqualObjects(statistics[@"in_flight"], @0);
+    XCTAssertEqualObjects(statistics[@"cancelled"], @1);
+    XCTAssertFalse(executed);
+}
+
+- (void)testResetStatistics
+{
+    MJDataProviderScheduler *scheduler = [[MJDataProviderScheduler alloc] init];
+    MJDataProviderTicket *ticket = [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) { } lane:MJDataProviderSchedulerLanePrefetch];
+    
+    [scheduler resetStatistics];
+    
+    NSDictionary *statistics = [scheduler statistics][@"prefetch"];
+    XCTAssertEqualObjects(statistics[@"started"], @0);
+    XCTAssertEqualObjects(statistics[@"in_flight"], @1);
+    
+    [ticket finish];
+}
+
+@end
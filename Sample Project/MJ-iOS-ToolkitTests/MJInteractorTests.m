@@ -0,0 +1,261 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#import <XCTest/XCTest.h>
+#import <stdatomic.h>
+
+#import "MJInteractor.h"
+
+/**
+ * Interactor with its own (serial) lane.
+ **/
+@interface MJInteractorTestInteractor : MJInteractor
+
+@end
+
+@implementation MJInteractorTestInteractor
+
+@end
+
+#pragma mark -
+
+@interface MJInteractorTests : XCTestCase
+
+@end
+
+@implementation MJInteractorTests
+{
+    atomic_int _runCount;
+    atomic_bool _laneBlocked;
+    void (^_complete)(id result, NSError *error);
+    NSMutableArray *_results;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    atomic_init(&_runCount, 0);
+    atomic_init(&_laneBlocked, false);
+    _complete = nil;
+    _results = [NSMutableArray array];
+}
+
+#pragma mark Single-flight
+
+- (void)testCallersWithTheSameKeyShareTheJob
+{
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    MJInteractorTestInteractor *otherInteractor = [[MJInteractorTestInteractor alloc] init];
+    
+    [interactor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    [otherInteractor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    
+    [self mjz_completeWithResult:@"result"];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:2]);
+    XCTAssertEqualObjects(_results, (@[@"result", @"result"]));
+    XCTAssertEqual(atomic_load(&_runCount), 1);
+}
+
+- (void)testCancellingAnAttachedCallerKeepsTheJob
+{
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    MJInteractorTestInteractor *otherInteractor = [[MJInteractorTestInteractor alloc] init];
+    
+    [interactor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    [otherInteractor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    
+    [otherInteractor cancel];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:1]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorCancelledErrorCode)]));
+    
+    [self mjz_completeWithResult:@"result"];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:2]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorCancelledErrorCode), @"result"]));
+    XCTAssertEqual(atomic_load(&_runCount), 1);
+}
+
+- (void)testCancellingTheOwnerKeepsAttachedCallers
+{
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    MJInteractorTestInteractor *otherInteractor = [[MJInteractorTestInteractor alloc] init];
+    
+    [interactor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    [otherInteractor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    
+    XCTAssertTrue([self mjz_waitForRunCount:1]);
+    [interactor cancel];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:1]);
+    XCTAssertFalse(interactor.isCancelled);
+    
+    [self mjz_completeWithResult:@"result"];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:2]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorCancelledErrorCode), @"result"]));
+}
+
+- (void)testCancellingTheLastCallerFlagsTheRunningJob
+{
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    
+    [interactor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    
+    XCTAssertTrue([self mjz_waitForRunCount:1]);
+    [interactor cancel];
+    
+    XCTAssertTrue(interactor.isCancelled);
+    XCTAssertTrue([self mjz_waitForResultCount:1]);
+    
+    // The late result is not delivered, and the key is free for a new job.
+    [self mjz_completeWithResult:@"late"];
+    [[[MJInteractorTestInteractor alloc] init] begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    [self mjz_completeWithResult:@"result"];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:2]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorCancelledErrorCode), @"result"]));
+    XCTAssertEqual(atomic_load(&_runCount), 2);
+}
+
+- (void)testCancellingAllCallersDropsThePendingJob
+{
+    MJInteractorTestInteractor *blockingInteractor = [self mjz_blockLane];
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    MJInteractorTestInteractor *otherInteractor = [[MJInteractorTestInteractor alloc] init];
+    
+    [interactor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    [otherInteractor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    
+    [interactor cancel];
+    [otherInteractor cancel];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:2]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorCancelledErrorCode), @(MJInteractorCancelledErrorCode)]));
+    
+    [blockingInteractor end:^{ }];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    
+    XCTAssertEqual(atomic_load(&_runCount), 0);
+}
+
+- (void)testTimeoutDetachesOnlyThatCaller
+{
+    MJInteractorTestInteractor *blockingInteractor = [self mjz_blockLane];
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    MJInteractorTestInteractor *otherInteractor = [[MJInteractorTestInteractor alloc] init];
+    otherInteractor.timeout = 0.05;
+    
+    [interactor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    [otherInteractor begin:[self mjz_jobBlock] forKey:@"key" end:[self mjz_endBlock]];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:1]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorTimeoutErrorCode)]));
+    
+    [blockingInteractor end:^{ }];
+    [self mjz_completeWithResult:@"result"];
+    
+    XCTAssertTrue([self mjz_waitForResultCount:2]);
+    XCTAssertEqualObjects(_results, (@[@(MJInteractorTimeoutErrorCode), @"result"]));
+}
+
+#pragma mark Private Methods
+
+- (void (^)(void (^complete)(id result, NSError *error)))mjz_jobBlock
+{
+    return ^(void (^complete)(id result, NSError *error)) {
+        @synchronized(self)
+        {
+            _complete = complete;
+        }
+        atomic_fetch_add(&_runCount, 1);
+    };
+}
+
+- (void (^)(id result, NSError *error))mjz_endBlock
+{
+    // Executed in the main queue. Errors are recorded by code.
+    return ^(id result, NSError *error) {
+        [_results addObject:result ?: @(error.code)];
+    };
+}
+
+- (void)mjz_completeWithResult:(id)result
+{
+    __block void (^complete)(id result, NSError *error) = nil;
+    
+    XCTAssertTrue([self mjz_waitForCondition:^BOOL{
+        @synchronized(self)
+        {
+            complete = _complete;
+            _complete = nil;
+        }
+        return complete != nil;
+    }]);
+    
+    complete(result, nil);
+}
+
+- (MJInteractorTestInteractor*)mjz_blockLane
+{
+    // A running job that only ends when the test calls end:, so the next jobs stay pending.
+    MJInteractorTestInteractor *interactor = [[MJInteractorTestInteractor alloc] init];
+    [interactor begin:^{
+        atomic_store(&_laneBlocked, true);
+    }];
+    
+    XCTAssertTrue([self mjz_waitForCondition:^BOOL{
+        return atomic_load(&_laneBlocked);
+    }]);
+    
+    return interactor;
+}
+
+- (BOOL)mjz_waitForRunCount:(int)count
+{
+    return [self mjz_waitForCondition:^BOOL{
+        return atomic_load(&_runCount) == count;
+    }];
+}
+
+- (BOOL)mjz_waitForResultCount:(NSUInteger)count
+{
+    return [self mjz_waitForCondition:^BOOL{
+        return _results.count == count;
+    }];
+}
+
+- (BOOL)mjz_waitForCondition:(BOOL (^)(void))condition
+{
+    // End blocks are delivered in the main queue, so it keeps running the main run loop.
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+    
+    while (!condition())
+    {
+        if ([timeout timeIntervalSinceNow] < 0)
+            return NO;
+        
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    return YES;
+}
+
+@end
@@ -0,0 +1,307 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJObjectStack.h"
+
+/**
+ * A stack object with a given identity.
+ **/
+@interface MJObjectStackTestObject : NSObject <MJObjectStackIdentity>
+
+- (id)initWithIdentity:(NSString*)identity;
+
+@property (nonatomic, strong, readonly) NSString *identity;
+
+@end
+
+@implementation MJObjectStackTestObject
+
+- (id)initWithIdentity:(NSString*)identity
+{
+    self = [super init];
+    if (self)
+    {
+        _identity = identity;
+    }
+    return self;
+}
+
+- (NSString*)objectStackIdentity
+{
+    return _identity;
+}
+
+@end
+
+#pragma mark -
+
+@interface MJObjectStackTests : XCTestCase
+
+@end
+
+@implementation MJObjectStackTests
+{
+    MJObjectStack *_stack;
+    MJObjectStackTestObject *_a;
+    MJObjectStackTestObject *_b;
+    MJObjectStackTestObject *_c;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _stack = [[MJObjectStack alloc] init];
+    _a = [[MJObjectStackTestObject alloc] initWithIdentity:@"a"];
+    _b = [[MJObjectStackTestObject alloc] initWithIdentity:@"b"];
+    _c = [[MJObjectStackTestObject alloc] initWithIdentity:@"c"];
+}
+
+#pragma mark Stack
+
+- (void)testEmptyStack
+{
+    XCTAssertNil(_stack.top);
+    XCTAssertFalse([_stack contains:_a]);
+    XCTAssertFalse([_stack isTop:_a]);
+    
+    [_stack pop];
+    [_stack remove:_a];
+    
+    XCTAssertNil(_stack.top);
+}
+
+- (void)testPushAndPop
+{
+    [_stack push:_a];
+    [_stack push:_b];
+    [_stack push:_c];
+    
+    XCTAssertEqual(_stack.top, _c);
+    XCTAssertTrue([_stack isTop:_c]);
+    XCTAssertFalse([_stack isTop:_a]);
+    
+    [_stack pop];
+    XCTAssertEqual(_stack.top, _b);
+    XCTAssertFalse([_stack contains:_c]);
+    
+    [_stack pop];
+    [_stack pop];
+    XCTAssertNil(_stack.top);
+}
+
+- (void)testPushingAnObjectInTheStackMovesItToTheTop
+{
+    [_stack push:_a];
+    [_stack push:_b];
+    [_stack push:_c];
+    
+    [_stack push:_a];
+    
+    XCTAssertEqualObjects([self mjz_poppedIdentities], @"acb");
+}
+
+- (void)testPushingTheTopObjectKeepsTheStack
+{
+    [_stack push:_a];
+    [_stack push:_b];
+    [_stack push:_b];
+    
+    XCTAssertEqualObjects([self mjz_poppedIdentities], @"ba");
+}
+
+- (void)testObjectsAreIdentifiedByIdentity
+{
+    MJObjectStackTestObject *otherA = [[MJObjectStackTestObject alloc] initWithIdentity:@"a"];
+    
+    [_stack push:_a];
+    [_stack push:_b];
+    
+    XCTAssertTrue([_stack contains:otherA]);
+    
+    [_stack push:otherA];
+    
+    XCTAssertEqual(_stack.top, otherA);
+    XCTAssertTrue([_stack isTop:_a]);
+    XCTAssertEqualObjects([self mjz_poppedIdentities], @"ab");
+}
+
+- (void)testRemove
+{
+    [_stack push:_a];
+    [_stack push:_b];
+    [_stack push:_c];
+    
+    [_stack remove:_b];
+    XCTAssertFalse([_stack contains:_b]);
+    
+    [_stack remove:_c];
+    XCTAssertEqual(_stack.top, _a);
+    
+    [_stack remove:_a];
+    XCTAssertNil(_stack.top);
+}
+
+- (void)testLargeStackWithChurn
+{
+    NSMutableArray *objects = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 10000; i++)
+    {
+        MJObjectStackTestObject *object = [[MJObjectStackTestObject alloc] initWithIdentity:@(i).stringValue];
+        [objects addObject:object];
+        [_stack push:object];
+    }
+    
+    // Moves the even objects to the top and removes every third one.
+    for (NSUInteger i = 0; i < objects.count; i += 2)
+        [_stack push:objects[i]];
+    
+    for (NSUInteger i = 0; i < objects.count; i += 3)
+        [_stack remove:objects[i]];
+    
+    XCTAssertEqual(_stack.top, objects[9998]);
+    XCTAssertTrue([_stack contains:objects[1]]);
+    XCTAssertFalse([_stack contains:objects[9999]]);
+    
+    NSUInteger count = 0;
+    while (_stack.top)
+    {
+        [_stack pop];
+        count++;
+    }
+    
+    XCTAssertEqual(count, 10000 - 3334);
+}
+
+#pragma mark Deallocation
+
+- (void)testDeallocatedObjectsAreRemoved
+{
+    MJObjectStackTestObject *identity = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+    
+    [_stack push:_a];
+    
+    @autoreleasepool
+    {
+        MJObjectStackTestObject *object = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+        [_stack push:object];
+        [_stack push:_c];
+        
+        XCTAssertTrue([_stack contains:identity]);
+    }
+    
+    XCTAssertFalse([_stack contains:identity]);
+    XCTAssertEqualObjects([self mjz_poppedIdentities], @"ca");
+}
+
+- (void)testDeallocatedTopIsReplaced
+{
+    [_stack push:_a];
+    
+    @autoreleasepool
+    {
+        MJObjectStackTestObject *object = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+        [_stack push:object];
+        
+        XCTAssertFalse([_stack isTop:_a]);
+    }
+    
+    XCTAssertEqual(_stack.top, _a);
+    XCTAssertTrue([_stack isTop:_a]);
+}
+
+- (void)testDeallocatingAReplacedObjectKeepsItsIdentity
+{
+    MJObjectStackTestObject *replacement = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+    
+    @autoreleasepool
+    {
+        MJObjectStackTestObject *object = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+        [_stack push:object];
+        [_stack push:_a];
+        [_stack push:replacement];
+    }
+    
+    XCTAssertTrue([_stack contains:replacement]);
+    XCTAssertEqualObjects([self mjz_poppedIdentities], @"ta");
+}
+
+- (void)testDeallocatingARemovedObjectKeepsItsIdentity
+{
+    MJObjectStackTestObject *replacement = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+    
+    @autoreleasepool
+    {
+        MJObjectStackTestObject *object = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+        [_stack push:object];
+        [_stack remove:object];
+        [_stack push:replacement];
+    }
+    
+    XCTAssertTrue([_stack contains:replacement]);
+}
+
+- (void)testObjectsAreRemovedFromEveryStack
+{
+    MJObjectStack *otherStack = [[MJObjectStack alloc] init];
+    
+    @autoreleasepool
+    {
+        MJObjectStackTestObject *object = [[MJObjectStackTestObject alloc] initWithIdentity:@"t"];
+        [_stack push:object];
+        [otherStack push:object];
+    }
+    
+    XCTAssertNil(_stack.top);
+    XCTAssertNil(otherStack.top);
+}
+
+- (void)testObjectsCanOutliveTheStack
+{
+    __weak MJObjectStack *weakStack = nil;
+    
+    @autoreleasepool
+    {
+        MJObjectStack *stack = [[MJObjectStack alloc] init];
+        weakStack = stack;
+        [stack push:_a];
+    }
+    
+    XCTAssertNil(weakStack);
+    
+    // Releasing the object must not reach the deallocated stack.
+    _a = nil;
+}
+
+#pragma mark Private Methods
+
+- (NSString*)mjz_poppedIdentities
+{
+    NSMutableString *identities = [NSMutableString string];
+    
+    while (_stack.top)
+    {
+        [identities appendString:[_stack.top objectStackIdentity]];
+        [_stack pop];
+    }
+    
+    return identities;
+}
+
+@end
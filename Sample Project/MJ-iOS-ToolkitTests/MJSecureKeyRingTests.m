@@ -0,0 +1,190 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJSecureKey.h"
+#import "MJSecureKeyRing.h"
+#import "NSData+AESKeyRing.h"
+
+/**
+ * File storage with an injectable read error.
+ **/
+@interface MJSecureKeyRingTestStorage : MJFileSecureKeyStorage
+
+@property (nonatomic, strong) NSError *readError;
+
+@end
+
+@implementation MJSecureKeyRingTestStorage
+
+- (NSData*)keyDataForIdentifier:(NSString*)identifier length:(size_t)length error:(NSError**)error
+{
+    if (_readError)
+    {
+        if (error)
+            *error = _readError;
+        return nil;
+    }
+    
+    return [super keyDataForIdentifier:identifier length:length error:error];
+}
+
+@end
+
+#pragma mark -
+
+@interface MJSecureKeyRingTests : XCTestCase
+
+@end
+
+@implementation MJSecureKeyRingTests
+{
+    NSURL *_directoryURL;
+    MJSecureKeyRingTestStorage *_storage;
+    MJSecureKeyRing *_keyRing;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    _directoryURL = [NSURL fileURLWithPath:path isDirectory:YES];
+    _storage = [[MJSecureKeyRingTestStorage alloc] initWithDirectoryURL:_directoryURL];
+    _keyRing = [[MJSecureKeyRing alloc] initWithIdentifier:@"ring" length:32 storage:_storage];
+}
+
+- (void)tearDown
+{
+    [MJSecureKey invalidateCache];
+    [[NSFileManager defaultManager] removeItemAtURL:_directoryURL error:nil];
+    
+    [super tearDown];
+}
+
+#pragma mark Rotation
+
+- (void)testRotationKeepsPreviousVersionsReadable
+{
+    NSData *plaintext = [@"rotation" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *encrypted = [plaintext aes_encryptWithKeyRing:_keyRing domain:@"domain"];
+    
+    XCTAssertEqual([encrypted aes_keyRingVersion], 1);
+    XCTAssertEqual([_keyRing rotate], 2);
+    XCTAssertNotEqualObjects([_keyRing keyForVersion:2], [_keyRing keyForVersion:1]);
+    
+    NSData *reencrypted = nil;
+    XCTAssertEqualObjects([encrypted aes_decryptWithKeyRing:_keyRing domain:@"domain" reencrypted:&reencrypted], plaintext);
+    XCTAssertEqual([reencrypted aes_keyRingVersion], 2);
+    
+    NSData *current = nil;
+    XCTAssertEqualObjects([reencrypted aes_decryptWithKeyRing:_keyRing domain:@"domain" reencrypted:&current], plaintext);
+    XCTAssertNil(current);
+}
+
+- (void)testRotationIsPersisted
+{
+    [_keyRing rotate];
+    [_keyRing rotate];
+    
+    MJSecureKeyRing *keyRing = [[MJSecureKeyRing alloc] initWithIdentifier:@"ring" length:32 storage:_storage];
+    
+    XCTAssertEqual(keyRing.currentVersion, 3);
+    XCTAssertEqualObjects([keyRing key], [_keyRing key]);
+}
+
+- (void)testFailedHeaderDecryptionReturnsNil
+{
+    NSData *plaintext = [@"header" dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *encrypted = [[plaintext aes_encryptWithKeyRing:_keyRing domain:nil] mutableCopy];
+    [_keyRing rotate];
+    
+    // Not a whole number of blocks: the version 1 key fails and no other key is tried.
+    [encrypted appendBytes:"\0" length:1];
+    
+    NSData *reencrypted = nil;
+    XCTAssertNil([encrypted aes_decryptWithKeyRing:_keyRing domain:nil reencrypted:&reencrypted]);
+    XCTAssertNil(reencrypted);
+}
+
+#pragma mark Legacy data
+
+- (void)testLegacyDataIsDecryptedButNotReencrypted
+{
+    NSData *legacyKey = [[[MJSecureKey alloc] initWithIdentifier:@"ring" length:32 storage:_storage] key];
+    NSData *plaintext = [@"legacy" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *encrypted = [plaintext aes_encrypt:legacyKey withPadding:kCCOptionPKCS7Padding];
+    
+    [_keyRing rotate];
+    
+    NSData *reencrypted = nil;
+    XCTAssertEqualObjects([encrypted aes_decryptWithKeyRing:_keyRing domain:@"domain" reencrypted:&reencrypted], plaintext);
+    XCTAssertNil(reencrypted);
+}
+
+- (void)testLegacyDataWithHeaderFormatByteIsDecrypted
+{
+    NSData *legacyKey = [_keyRing keyForVersion:1];
+    NSData *plaintext = nil;
+    NSData *encrypted = nil;
+    
+    // Finds legacy data whose bytes look like a header of a version the key ring doesn't have.
+    for (NSUInteger i = 0; i < 10000; i++)
+    {
+        plaintext = [[NSString stringWithFormat:@"legacy %lu", (unsigned long)i] dataUsingEncoding:NSUTF8StringEncoding];
+        encrypted = [plaintext aes_encrypt:legacyKey withPadding:kCCOptionPKCS7Padding];
+        
+        if ([encrypted aes_keyRingVersion] > _keyRing.currentVersion)
+            break;
+    }
+    
+    XCTAssertGreaterThan([encrypted aes_keyRingVersion], _keyRing.currentVersion);
+    
+    NSData *reencrypted = nil;
+    XCTAssertEqualObjects([encrypted aes_decryptWithKeyRing:_keyRing domain:nil reencrypted:&reencrypted], plaintext);
+    XCTAssertNil(reencrypted);
+}
+
+#pragma mark Errors
+
+- (void)testUnreadableVersionIsNotCached
+{
+    [_keyRing rotate];
+    
+    MJSecureKeyRing *keyRing = [[MJSecureKeyRing alloc] initWithIdentifier:@"ring" length:32 storage:_storage];
+    _storage.readError = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain code:MJSecureKeyStorageFailureErrorCode userInfo:nil];
+    
+    XCTAssertEqual(keyRing.currentVersion, 0);
+    XCTAssertNil([keyRing key]);
+    XCTAssertNil([[NSData data] aes_encryptWithKeyRing:keyRing domain:nil]);
+    XCTAssertEqual([keyRing rotate], 0);
+    
+    _storage.readError = nil;
+    
+    XCTAssertEqual(keyRing.currentVersion, 2);
+}
+
+- (void)testLockedStorageRaises
+{
+    _storage.readError = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain code:MJSecureKeyStorageInteractionNotAllowedErrorCode userInfo:nil];
+    
+    XCTAssertThrows(_keyRing.currentVersion);
+}
+
+@end
@@ -0,0 +1,216 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJSecureKey.h"
+
+/**
+ * File storage with injectable failures, counting its reads.
+ **/
+@interface MJSecureKeyTestStorage : MJFileSecureKeyStorage
+
+@property (nonatomic, strong) NSError *readError;
+@property (nonatomic, assign) BOOL failsToAdd;
+@property (nonatomic, assign) NSUInteger readCount;
+@property (nonatomic, assign) NSUInteger addCount;
+
+@end
+
+@implementation MJSecureKeyTestStorage
+
+- (NSData*)keyDataForIdentifier:(NSString*)identifier length:(size_t)length error:(NSError**)error
+{
+    _readCount++;
+    
+    if (_readError)
+    {
+        if (error)
+            *error = _readError;
+        return nil;
+    }
+    
+    return [super keyDataForIdentifier:identifier length:length error:error];
+}
+
+- (BOOL)addKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier length:(size_t)length
+{
+    _addCount++;
+    
+    if (_failsToAdd)
+        return NO;
+    
+    return [super addKeyData:keyData forIdentifier:identifier length:length];
+}
+
+@end
+
+#pragma mark -
+
+@interface MJSecureKeyTests : XCTestCase
+
+@end
+
+@implementation MJSecureKeyTests
+{
+    NSURL *_directoryURL;
+    MJSecureKeyTestStorage *_storage;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    _directoryURL = [NSURL fileURLWithPath:path isDirectory:YES];
+    _storage = [[MJSecureKeyTestStorage alloc] initWithDirectoryURL:_directoryURL];
+}
+
+- (void)tearDown
+{
+    [MJSecureKey invalidateCache];
+    [[NSFileManager defaultManager] removeItemAtURL:_directoryURL error:nil];
+    
+    [super tearDown];
+}
+
+#pragma mark Generation and cache
+
+- (void)testMissingKeyIsGeneratedAndStored
+{
+    NSData *key = [[self mjz_secureKey] key];
+    
+    XCTAssertEqual(key.length, 32);
+    XCTAssertEqual(_storage.addCount, 1);
+    XCTAssertEqualObjects([_storage keyDataForIdentifier:@"key" length:32 error:nil], key);
+}
+
+- (void)testKeysAreReadOnce
+{
+    NSData *key = [[self mjz_secureKey] key];
+    NSData *otherKey = [[self mjz_secureKey] key];
+    
+    XCTAssertEqualObjects(otherKey, key);
+    XCTAssertEqual(_storage.readCount, 1);
+}
+
+- (void)testKeysAreCachedPerStorage
+{
+    MJFileSecureKeyStorage *otherStorage = [[MJFileSecureKeyStorage alloc] initWithDirectoryURL:[_directoryURL URLByAppendingPathComponent:@"other"]];
+    
+    NSData *key = [[self mjz_secureKey] key];
+    NSData *otherKey = [[[MJSecureKey alloc] initWithIdentifier:@"key" length:32 storage:otherStorage] key];
+    
+    XCTAssertNotNil(otherKey);
+    XCTAssertNotEqualObjects(otherKey, key);
+}
+
+- (void)testInvalidateCacheReadsTheStorageAgain
+{
+    MJSecureKey *secureKey = [self mjz_secureKey];
+    [secureKey key];
+    
+    NSData *externalKey = [NSMutableData dataWithLength:32];
+    [_storage updateKeyData:externalKey forIdentifier:@"key"];
+    [MJSecureKey invalidateCache];
+    
+    XCTAssertEqualObjects([secureKey key], externalKey);
+    XCTAssertEqual(_storage.readCount, 2);
+}
+
+#pragma mark Reset and clear
+
+- (void)testResetInvalidatesEveryInstance
+{
+    MJSecureKey *secureKey = [self mjz_secureKey];
+    MJSecureKey *otherSecureKey = [self mjz_secureKey];
+    
+    NSData *key = [secureKey key];
+    XCTAssertEqualObjects([otherSecureKey key], key);
+    
+    XCTAssertTrue([secureKey reset]);
+    
+    NSData *newKey = [otherSecureKey key];
+    XCTAssertNotEqualObjects(newKey, key);
+    XCTAssertEqualObjects([secureKey key], newKey);
+    XCTAssertEqualObjects([_storage keyDataForIdentifier:@"key" length:32 error:nil], newKey);
+}
+
+- (void)testClearRemovesTheKey
+{
+    MJSecureKey *secureKey = [self mjz_secureKey];
+    NSData *key = [secureKey key];
+    
+    XCTAssertTrue([secureKey clear]);
+    XCTAssertNil([_storage keyDataForIdentifier:@"key" length:32 error:nil]);
+    
+    NSData *newKey = [secureKey key];
+    XCTAssertNotNil(newKey);
+    XCTAssertNotEqualObjects(newKey, key);
+}
+
+#pragma mark Errors
+
+- (void)testReadErrorDoesNotGenerateAKey
+{
+    _storage.readError = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain code:MJSecureKeyStorageFailureErrorCode userInfo:nil];
+    
+    MJSecureKey *secureKey = [self mjz_secureKey];
+    
+    XCTAssertNil([secureKey key]);
+    XCTAssertEqual(_storage.addCount, 0);
+    
+    // Nothing is cached, the next call reads again.
+    _storage.readError = nil;
+    
+    XCTAssertNotNil([secureKey key]);
+    XCTAssertEqual(_storage.readCount, 2);
+}
+
+- (void)testUnsavedKeyIsNotUsed
+{
+    _storage.failsToAdd = YES;
+    
+    MJSecureKey *secureKey = [self mjz_secureKey];
+    
+    XCTAssertNil([secureKey key]);
+    XCTAssertNil([secureKey key]);
+    XCTAssertEqual(_storage.addCount, 2);
+    
+    _storage.failsToAdd = NO;
+    
+    NSData *key = [secureKey key];
+    XCTAssertNotNil(key);
+    XCTAssertEqualObjects([_storage keyDataForIdentifier:@"key" length:32 error:nil], key);
+}
+
+- (void)testLockedStorageRaises
+{
+    _storage.readError = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain code:MJSecureKeyStorageInteractionNotAllowedErrorCode userInfo:nil];
+    
+    XCTAssertThrows([[self mjz_secureKey] key]);
+    XCTAssertEqual(_storage.addCount, 0);
+}
+
+#pragma mark Private Methods
+
+- (MJSecureKey*)mjz_secureKey
+{
+    return [[MJSecureKey alloc] initWithIdentifier:@"key" length:32 storage:_storage];
+}
+
+@end
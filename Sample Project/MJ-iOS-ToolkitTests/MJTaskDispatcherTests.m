@@ -0,0 +1,316 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "MJTaskDispatcher.h"
+
+/**
+ * Records the notifications of a dispatcher.
+ **/
+@interface MJTaskDispatcherTestObserver : NSObject <MJTaskDispatcherObserver>
+
+@property (nonatomic, assign) NSUInteger completionCount;
+@property (nonatomic, strong) NSSet *completedTasks;
+@property (nonatomic, strong) NSSet *failedTasks;
+@property (nonatomic, strong) NSDictionary *objects;
+@property (nonatomic, strong) NSMutableArray <NSArray*> *progress;
+
+@end
+
+@implementation MJTaskDispatcherTestObserver
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _progress = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dispatcher:(MJTaskDispatcher*)dispatcher didCompleteTasks:(NSSet*)completedTasks failedTasks:(NSSet*)failedTasks objects:(NSDictionary*)objects
+{
+    @synchronized(self)
+    {
+        _completionCount++;
+        _completedTasks = completedTasks;
+        _failedTasks = failedTasks;
+        _objects = objects;
+    }
+}
+
+- (void)dispatcher:(MJTaskDispatcher*)dispatcher didUpdateProgressWithCompletedCount:(NSUInteger)completedCount failedCount:(NSUInteger)failedCount pendingCount:(NSUInteger)pendingCount
+{
+    @synchronized(self)
+    {
+        [_progress addObject:@[@(completedCount), @(failedCount), @(pendingCount)]];
+    }
+}
+
+@end
+
+#pragma mark -
+
+@interface MJTaskDispatcherTests : XCTestCase
+
+@end
+
+@implementation MJTaskDispatcherTests
+{
+    MJTaskDispatcher *_dispatcher;
+    MJTaskDispatcherTestObserver *_observer;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _dispatcher = [[MJTaskDispatcher alloc] init];
+    _observer = [[MJTaskDispatcherTestObserver alloc] init];
+    [_dispatcher addObserver:_observer];
+}
+
+#pragma mark Counts
+
+- (void)testCounts
+{
+    [_dispatcher startTaskWithKey:@"a"];
+    [_dispatcher startTaskWithKey:@"b"];
+    [_dispatcher startTaskWithKey:@"c"];
+    [_dispatcher startTaskWithKey:@"a"];
+    
+    XCTAssertEqual(_dispatcher.count, 3);
+    
+    [_dispatcher completeTaskWithKey:@"a" object:@1 succeed:YES];
+    [_dispatcher completeTaskWithKey:@"b" object:nil succeed:NO];
+    
+    XCTAssertEqual(_dispatcher.count, 1);
+    XCTAssertEqual(_dispatcher.completedCount, 1);
+    XCTAssertEqual(_dispatcher.failedCount, 1);
+    XCTAssertEqual(_observer.completionCount, 0);
+    
+    [_dispatcher completeTaskWithKey:@"c" object:nil succeed:YES];
+    
+    XCTAssertEqual(_dispatcher.count, 0);
+    XCTAssertEqual(_dispatcher.completedCount, 2);
+    XCTAssertEqual(_observer.completionCount, 1);
+    
+    NSSet *completedTasks = [NSSet setWithObjects:@"a", @"c", nil];
+    XCTAssertEqualObjects(_observer.completedTasks, completedTasks);
+    XCTAssertEqualObjects(_observer.failedTasks, [NSSet setWithObject:@"b"]);
+    XCTAssertEqualObjects(_observer.objects, @{@"a": @1});
+}
+
+- (void)testCompletingATaskTwiceCountsItOnce
+{
+    [_dispatcher startTaskWithKey:@"a"];
+    [_dispatcher startTaskWithKey:@"b"];
+    
+    [_dispatcher completeTaskWithKey:@"a" object:nil succeed:YES];
+    [_dispatcher completeTaskWithKey:@"a" object:nil succeed:YES];
+    
+    XCTAssertEqual(_dispatcher.count, 1);
+    XCTAssertEqual(_dispatcher.completedCount, 1);
+}
+
+- (void)testCompleteAllPendingTasks
+{
+    for (NSUInteger i = 0; i < 100; i++)
+        [_dispatcher startTaskWithKey:@(i).stringValue];
+    
+    [_dispatcher completeTaskWithKey:@"0" object:nil succeed:NO];
+    [_dispatcher completeAllPendingTasks];
+    
+    XCTAssertEqual(_dispatcher.count, 0);
+    XCTAssertEqual(_dispatcher.completedCount, 99);
+    XCTAssertEqual(_dispatcher.failedCount, 1);
+    XCTAssertEqual(_observer.completionCount, 1);
+    XCTAssertEqual(_observer.completedTasks.count, 99);
+}
+
+- (void)testFailAllPendingTasks
+{
+    [_dispatcher startTaskWithKey:@"a"];
+    [_dispatcher startTaskWithKey:@"b"];
+    
+    [_dispatcher failAllPendingTasks];
+    
+    XCTAssertEqual(_dispatcher.failedCount, 2);
+    XCTAssertEqual(_observer.completionCount, 1);
+    XCTAssertEqual(_observer.completedTasks.count, 0);
+}
+
+- (void)testConcurrentCompletionNotifiesOnce
+{
+    NSUInteger taskCount = 10000;
+    NSUInteger threadCount = 8;
+    
+    for (NSUInteger i = 0; i < taskCount; i++)
+        [_dispatcher startTaskWithKey:@(i).stringValue];
+    
+    MJTaskDispatcher *dispatcher = _dispatcher;
+    dispatch_apply(threadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        for (NSUInteger i = thread; i < taskCount; i += threadCount)
+            [dispatcher completeTaskWithKey:@(i).stringValue object:nil succeed:YES];
+    });
+    
+    XCTAssertEqual(_dispatcher.count, 0);
+    XCTAssertEqual(_dispatcher.completedCount, taskCount);
+    XCTAssertEqual(_observer.completionCount, 1);
+    XCTAssertEqual(_observer.completedTasks.count, taskCount);
+}
+
+#pragma mark Progress
+
+- (void)testProgressIsNotifiedOnEveryCompletionWithoutInterval
+{
+    _dispatcher.progressInterval = 0;
+    
+    [_dispatcher startTaskWithKey:@"a"];
+    [_dispatcher startTaskWithKey:@"b"];
+    [_dispatcher startTaskWithKey:@"c"];
+    
+    [_dispatcher completeTaskWithKey:@"a" object:nil succeed:YES];
+    [_dispatcher completeTaskWithKey:@"b" object:nil succeed:NO];
+    [_dispatcher completeTaskWithKey:@"c" object:nil succeed:YES];
+    
+    NSArray *progress = @[@[@1, @0, @2], @[@1, @1, @1], @[@2, @1, @0]];
+    XCTAssertEqualObjects(_observer.progress, progress);
+}
+
+- (void)testProgressIsThrottled
+{
+    _dispatcher.progressInterval = 60;
+    
+    for (NSUInteger i = 0; i < 100; i++)
+        [_dispatcher startTaskWithKey:@(i).stringValue];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+        [_dispatcher completeTaskWithKey:@(i).stringValue object:nil succeed:YES];
+    
+    NSArray *progress = @[@[@1, @0, @99], @[@100, @0, @0]];
+    XCTAssertEqualObjects(_observer.progress, progress);
+}
+
+#pragma mark Groups
+
+- (void)testGroupCompletesItsParentTask
+{
+    [_dispatcher startTaskWithKey:@"a"];
+    MJTaskDispatcher *group = [_dispatcher startGroupWithKey:@"group"];
+    
+    XCTAssertEqual(group.parentDispatcher, _dispatcher);
+    XCTAssertEqual(_dispatcher.count, 2);
+    
+    [group startTaskWithKey:@"b"];
+    [group startTaskWithKey:@"c"];
+    [_dispatcher completeTaskWithKey:@"a" object:nil succeed:YES];
+    [group completeTaskWithKey:@"b" object:@2 succeed:YES];
+    
+    XCTAssertEqual(_dispatcher.count, 1);
+    
+    [group completeTaskWithKey:@"c" object:@3 succeed:YES];
+    
+    XCTAssertEqual(_dispatcher.count, 0);
+    XCTAssertEqual(_observer.completionCount, 1);
+    
+    NSSet *completedTasks = [NSSet setWithObjects:@"a", @"group", nil];
+    NSDictionary *objects = @{@"group": @{@"b": @2, @"c": @3}};
+    XCTAssertEqualObjects(_observer.completedTasks, completedTasks);
+    XCTAssertEqualObjects(_observer.objects, objects);
+}
+
+- (void)testFailedTaskFailsTheGroupTask
+{
+    MJTaskDispatcher *group = [_dispatcher startGroupWithKey:@"group"];
+    MJTaskDispatcher *nestedGroup = [group startGroupWithKey:@"nested"];
+    
+    [nestedGroup startTaskWithKey:@"a"];
+    [nestedGroup completeTaskWithKey:@"a" object:nil succeed:NO];
+    
+    XCTAssertEqual(_dispatcher.count, 0);
+    XCTAssertEqualObjects(_observer.failedTasks, [NSSet setWithObject:@"group"]);
+}
+
+- (void)testEmptyGroupIsCompletedExplicitly
+{
+    MJTaskDispatcher *group = [_dispatcher startGroupWithKey:@"group"];
+    
+    XCTAssertEqual(_dispatcher.count, 1);
+    
+    [group completeAllPendingTasks];
+    
+    XCTAssertEqual(_dispatcher.count, 0);
+    XCTAssertEqualObjects(_observer.completedTasks, [NSSet setWithObject:@"group"]);
+    XCTAssertNil(group.parentDispatcher);
+}
+
+- (void)testParentDoesNotRetainCompletedGroups
+{
+    __weak MJTaskDispatcher *weakGroup = nil;
+    
+    @autoreleasepool
+    {
+        MJTaskDispatcher *group = [_dispatcher startGroupWithKey:@"group"];
+        weakGroup = group;
+        
+        [group startTaskWithKey:@"a"];
+        [group completeTaskWithKey:@"a" object:nil succeed:YES];
+    }
+    
+    XCTAssertNil(weakGroup);
+}
+
+#pragma mark Reset
+
+- (void)testResetKeepsPendingTasks
+{
+    [_dispatcher startTaskWithKey:@"a"];
+    [_dispatcher startTaskWithKey:@"b"];
+    [_dispatcher completeTaskWithKey:@"a" object:@1 succeed:YES];
+    
+    [_dispatcher reset];
+    
+    XCTAssertEqual(_dispatcher.count, 1);
+    XCTAssertEqual(_dispatcher.completedCount, 0);
+    
+    [_dispatcher completeTaskWithKey:@"b" object:nil succeed:YES];
+    
+    XCTAssertEqualObjects(_observer.completedTasks, [NSSet setWithObject:@"b"]);
+    XCTAssertEqualObjects(_observer.objects, @{});
+}
+
+- (void)testResetsOnCompletion
+{
+    _dispatcher.resetsOnCompletion = YES;
+    
+    [_dispatcher startTaskWithKey:@"a"];
+    [_dispatcher completeTaskWithKey:@"a" object:@1 succeed:YES];
+    
+    XCTAssertEqual(_dispatcher.completedCount, 0);
+    XCTAssertEqualObjects(_observer.objects, @{@"a": @1});
+    
+    [_dispatcher startTaskWithKey:@"b"];
+    [_dispatcher completeTaskWithKey:@"b" object:nil succeed:YES];
+    
+    XCTAssertEqual(_observer.completionCount, 2);
+    XCTAssertEqualObjects(_observer.completedTasks, [NSSet setWithObject:@"b"]);
+}
+
+@end
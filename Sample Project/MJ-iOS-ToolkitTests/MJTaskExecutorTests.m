@@ -0,0 +1,269 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+#import <stdatomic.h>
+
+#import "MJTaskExecutor.h"
+
+/**
+ * Forwards the dispatcher completion to a block.
+ **/
+@interface MJTaskExecutorTestObserver : NSObject <MJTaskDispatcherObserver>
+
+@property (nonatomic, copy) void (^completionBlock)(NSSet *completedTasks, NSSet *failedTasks, NSDictionary *objects);
+
+@end
+
+@implementation MJTaskExecutorTestObserver
+
+- (void)dispatcher:(MJTaskDispatcher*)dispatcher didCompleteTasks:(NSSet*)completedTasks failedTasks:(NSSet*)failedTasks objects:(NSDictionary*)objects
+{
+    if (_completionBlock)
+        _completionBlock(completedTasks, failedTasks, objects);
+}
+
+@end
+
+#pragma mark -
+
+@interface MJTaskExecutorTests : XCTestCase
+
+@end
+
+@implementation MJTaskExecutorTests
+{
+    MJTaskExecutor *_executor;
+    MJTaskExecutorTestObserver *_observer;
+    NSSet *_completedTasks;
+    NSSet *_failedTasks;
+    NSDictionary *_objects;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _executor = [[MJTaskExecutor alloc] init];
+    _executor.queue = dispatch_queue_create("com.mobilejazz.core.task-executor-tests", DISPATCH_QUEUE_CONCURRENT);
+    _executor.retryDelay = 0.01;
+    
+    _observer = [[MJTaskExecutorTestObserver alloc] init];
+    [_executor.dispatcher addObserver:_observer];
+}
+
+#pragma mark Execution
+
+- (void)testTasksAreCompletedInTheDispatcher
+{
+    [self mjz_expectCompletion];
+    
+    // Otherwise the dispatcher could complete before all tasks are submitted.
+    dispatch_suspend(_executor.queue);
+    
+    for (NSUInteger i = 0; i < 20; i++)
+    {
+        [_executor submitTaskWithKey:@(i).stringValue block:^(void (^completion)(id, BOOL)) {
+            completion(@(i), i % 2 == 0);
+        }];
+    }
+    
+    dispatch_resume(_executor.queue);
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertEqual(_completedTasks.count, 10);
+    XCTAssertEqual(_failedTasks.count, 10);
+    XCTAssertEqualObjects(_objects[@"7"], @7);
+}
+
+- (void)testConcurrencyIsLimited
+{
+    _executor.maxConcurrentTasks = 2;
+    
+    __block atomic_int running = 0;
+    __block atomic_int maxRunning = 0;
+    
+    [self mjz_expectCompletion];
+    
+    dispatch_suspend(_executor.queue);
+    
+    for (NSUInteger i = 0; i < 20; i++)
+    {
+        [_executor submitTaskWithKey:@(i).stringValue block:^(void (^completion)(id, BOOL)) {
+            int current = atomic_fetch_add(&running, 1) + 1;
+            int previous = atomic_load(&maxRunning);
+            while (current > previous && !atomic_compare_exchange_weak(&maxRunning, &previous, current));
+            
+            [NSThread sleepForTimeInterval:0.005];
+            
+            atomic_fetch_sub(&running, 1);
+            completion(nil, YES);
+        }];
+    }
+    
+    XCTAssertEqual(_executor.runningCount, 2);
+    
+    dispatch_resume(_executor.queue);
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertLessThanOrEqual(atomic_load(&maxRunning), 2);
+    XCTAssertEqual(_completedTasks.count, 20);
+}
+
+- (void)testCompletingTwiceIsIgnored
+{
+    [self mjz_expectCompletion];
+    
+    [_executor submitTaskWithKey:@"a" block:^(void (^completion)(id, BOOL)) {
+        completion(@1, YES);
+        completion(@2, NO);
+    }];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertEqualObjects(_objects, @{@"a": @1});
+    XCTAssertEqual(_failedTasks.count, 0);
+    XCTAssertEqual(_executor.runningCount, 0);
+}
+
+#pragma mark Retry
+
+- (void)testFailedTasksAreRetried
+{
+    _executor.maxRetryCount = 3;
+    
+    __block atomic_int attempts = 0;
+    
+    [self mjz_expectCompletion];
+    
+    [_executor submitTaskWithKey:@"a" block:^(void (^completion)(id, BOOL)) {
+        int attempt = atomic_fetch_add(&attempts, 1) + 1;
+        completion(@(attempt), attempt == 3);
+    }];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertEqual(atomic_load(&attempts), 3);
+    XCTAssertEqualObjects(_completedTasks, [NSSet setWithObject:@"a"]);
+    XCTAssertEqualObjects(_objects, @{@"a": @3});
+}
+
+- (void)testRetriesAreLimited
+{
+    _executor.maxRetryCount = 2;
+    
+    __block atomic_int attempts = 0;
+    
+    [self mjz_expectCompletion];
+    
+    [_executor submitTaskWithKey:@"a" block:^(void (^completion)(id, BOOL)) {
+        atomic_fetch_add(&attempts, 1);
+        completion(nil, NO);
+    }];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertEqual(atomic_load(&attempts), 3);
+    XCTAssertEqualObjects(_failedTasks, [NSSet setWithObject:@"a"]);
+}
+
+#pragma mark Cancel
+
+- (void)testCancelFailsTasksNotExecutingYet
+{
+    _executor.maxConcurrentTasks = 1;
+    
+    dispatch_semaphore_t started = dispatch_semaphore_create(0);
+    dispatch_semaphore_t resume = dispatch_semaphore_create(0);
+    __block atomic_int executed = 0;
+    
+    [_executor submitTaskWithKey:@"running" block:^(void (^completion)(id, BOOL)) {
+        dispatch_semaphore_signal(started);
+        dispatch_semaphore_wait(resume, DISPATCH_TIME_FOREVER);
+        completion(nil, YES);
+    }];
+    
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        [_executor submitTaskWithKey:@(i).stringValue block:^(void (^completion)(id, BOOL)) {
+            atomic_fetch_add(&executed, 1);
+            completion(nil, YES);
+        }];
+    }
+    
+    dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+    
+    [_executor cancelAllPendingTasks];
+    
+    XCTAssertEqual(_executor.dispatcher.failedCount, 3);
+    XCTAssertEqual(_executor.dispatcher.count, 1);
+    
+    [self mjz_expectCompletion];
+    dispatch_semaphore_signal(resume);
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertEqual(atomic_load(&executed), 0);
+    XCTAssertEqualObjects(_completedTasks, [NSSet setWithObject:@"running"]);
+    XCTAssertEqual(_failedTasks.count, 3);
+}
+
+- (void)testCancelStopsRetries
+{
+    _executor.maxRetryCount = 5;
+    _executor.retryDelay = 10;
+    
+    dispatch_semaphore_t failed = dispatch_semaphore_create(0);
+    __block atomic_int attempts = 0;
+    
+    [_executor submitTaskWithKey:@"a" block:^(void (^completion)(id, BOOL)) {
+        atomic_fetch_add(&attempts, 1);
+        completion(nil, NO);
+        dispatch_semaphore_signal(failed);
+    }];
+    
+    dispatch_semaphore_wait(failed, DISPATCH_TIME_FOREVER);
+    
+    // The task is waiting to be retried.
+    XCTAssertEqual(_executor.dispatcher.count, 1);
+    XCTAssertEqual(_executor.runningCount, 0);
+    
+    [_executor cancelAllPendingTasks];
+    
+    XCTAssertEqual(_executor.dispatcher.count, 0);
+    XCTAssertEqual(_executor.dispatcher.failedCount, 1);
+    XCTAssertEqual(atomic_load(&attempts), 1);
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_expectCompletion
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"completion"];
+    
+    __weak MJTaskExecutorTests *weakSelf = self;
+    _observer.completionBlock = ^(NSSet *completedTasks, NSSet *failedTasks, NSDictionary *objects) {
+        MJTaskExecutorTests *strongSelf = weakSelf;
+        strongSelf->_completedTasks = completedTasks;
+        strongSelf->_failedTasks = failedTasks;
+        strongSelf->_objects = objects;
+        [expectation fulfill];
+    };
+}
+
+@end
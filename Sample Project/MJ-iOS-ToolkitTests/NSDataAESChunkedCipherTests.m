@@ -0,0 +1,166 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#import <XCTest/XCTest.h>
+
+#import "NSDataAESChunkedCipher.h"
+#import "NSDataAESCipher.h"
+
+#define NSDataAESChunkedCipherTestsChunkSize 32
+
+@interface NSDataAESChunkedCipherTests : XCTestCase
+
+@end
+
+@implementation NSDataAESChunkedCipherTests
+{
+    NSData *_key;
+    NSData *_plaintext;
+    NSData *_container;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _key = [@"0123456789abcdef0123456789abcdef" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    // Three full chunks and a partial one.
+    NSMutableData *plaintext = [NSMutableData dataWithLength:3 * NSDataAESChunkedCipherTestsChunkSize + 10];
+    uint8_t *bytes = plaintext.mutableBytes;
+    for (NSUInteger i = 0; i < plaintext.length; i++)
+        bytes[i] = (uint8_t)i;
+    _plaintext = plaintext;
+    
+    _container = [NSDataAESChunkedCipher encryptData:_plaintext key:_key chunkSize:NSDataAESChunkedCipherTestsChunkSize error:nil];
+}
+
+#pragma mark Round trips
+
+- (void)testRoundTrip
+{
+    NSUInteger chunkSize = 0;
+    unsigned long long length = 0;
+    
+    XCTAssertTrue([NSDataAESChunkedCipher readHeaderOfData:_container chunkSize:&chunkSize length:&length]);
+    XCTAssertEqual(chunkSize, NSDataAESChunkedCipherTestsChunkSize);
+    XCTAssertEqual(length, _plaintext.length);
+    XCTAssertEqual([NSDataAESChunkedCipher numberOfChunksOfData:_container], 4);
+    
+    XCTAssertEqualObjects([NSDataAESChunkedCipher decryptData:_container key:_key error:nil], _plaintext);
+}
+
+- (void)testSingleChunkDecryption
+{
+    NSData *chunk = [NSDataAESChunkedCipher decryptChunkAtIndex:3 ofData:_container key:_key error:nil];
+    
+    XCTAssertEqualObjects(chunk, [_plaintext subdataWithRange:NSMakeRange(3 * NSDataAESChunkedCipherTestsChunkSize, 10)]);
+}
+
+- (void)testEmptyDataRoundTrip
+{
+    NSData *container = [NSDataAESChunkedCipher encryptData:[NSData data] key:_key error:nil];
+    
+    XCTAssertEqual(container.length, NSDataAESChunkedCipherHeaderLength + NSDataAESChunkedCipherTagLength);
+    XCTAssertEqualObjects([NSDataAESChunkedCipher decryptData:container key:_key error:nil], [NSData data]);
+}
+
+#pragma mark Tampering
+
+- (void)testTamperedCiphertextIsRejected
+{
+    NSMutableData *container = [_container mutableCopy];
+    ((uint8_t*)container.mutableBytes)[NSDataAESChunkedCipherHeaderLength + 1] ^= 0x01;
+    
+    [self mjz_assertRejected:container];
+    XCTAssertNil([NSDataAESChunkedCipher decryptChunkAtIndex:0 ofData:container key:_key error:nil]);
+    
+    // Other chunks are still authenticated on their own.
+    XCTAssertNotNil([NSDataAESChunkedCipher decryptChunkAtIndex:1 ofData:container key:_key error:nil]);
+}
+
+- (void)testTamperedTagIsRejected
+{
+    NSMutableData *container = [_container mutableCopy];
+    ((uint8_t*)container.mutableBytes)[container.length - 1] ^= 0x01;
+    
+    [self mjz_assertRejected:container];
+}
+
+- (void)testTamperedHeaderIsRejected
+{
+    // Reserved bytes are not validated when reading the header, only authenticated.
+    NSMutableData *container = [_container mutableCopy];
+    ((uint8_t*)container.mutableBytes)[12] ^= 0x01;
+    
+    XCTAssertTrue([NSDataAESChunkedCipher readHeaderOfData:container chunkSize:NULL length:NULL]);
+    [self mjz_assertRejected:container];
+}
+
+- (void)testSwappedChunksAreRejected
+{
+    NSUInteger stride = NSDataAESChunkedCipherTestsChunkSize + NSDataAESChunkedCipherTagLength;
+    NSRange first = NSMakeRange(NSDataAESChunkedCipherHeaderLength, stride);
+    NSRange second = NSMakeRange(NSDataAESChunkedCipherHeaderLength + stride, stride);
+    
+    NSMutableData *container = [_container mutableCopy];
+    [container replaceBytesInRange:first withBytes:[_container subdataWithRange:second].bytes];
+    [container replaceBytesInRange:second withBytes:[_container subdataWithRange:first].bytes];
+    
+    [self mjz_assertRejected:container];
+}
+
+- (void)testChunksOfOtherContainersAreRejected
+{
+    NSData *otherContainer = [NSDataAESChunkedCipher encryptData:_plaintext key:_key chunkSize:NSDataAESChunkedCipherTestsChunkSize error:nil];
+    NSRange chunk = NSMakeRange(NSDataAESChunkedCipherHeaderLength, NSDataAESChunkedCipherTestsChunkSize + NSDataAESChunkedCipherTagLength);
+    
+    NSMutableData *container = [_container mutableCopy];
+    [container replaceBytesInRange:chunk withBytes:[otherContainer subdataWithRange:chunk].bytes];
+    
+    [self mjz_assertRejected:container];
+}
+
+- (void)testTruncatedContainerIsRejected
+{
+    NSData *container = [_container subdataWithRange:NSMakeRange(0, _container.length - 1)];
+    
+    XCTAssertFalse([NSDataAESChunkedCipher readHeaderOfData:container chunkSize:NULL length:NULL]);
+    XCTAssertEqual([NSDataAESChunkedCipher numberOfChunksOfData:container], 0);
+    XCTAssertNil([NSDataAESChunkedCipher decryptData:container key:_key error:nil]);
+}
+
+- (void)testWrongKeyIsRejected
+{
+    NSData *key = [@"fedcba9876543210fedcba9876543210" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    XCTAssertNil([NSDataAESChunkedCipher decryptData:_container key:key error:nil]);
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_assertRejected:(NSData*)container
+{
+    NSError *error = nil;
+    
+    XCTAssertNil([NSDataAESChunkedCipher decryptData:container key:_key error:&error]);
+    XCTAssertEqualObjects(error.domain, NSDataAESCipherErrorDomain);
+    XCTAssertEqual(error.code, NSDataAESCipherDecodeErrorCode);
+}
+
+@end
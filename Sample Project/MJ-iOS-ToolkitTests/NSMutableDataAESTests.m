@@ -0,0 +1,131 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#import <XCTest/XCTest.h>
+
+#import "NSMutableData+AES.h"
+#import "NSDataAESCipher.h"
+
+@interface NSMutableDataAESTests : XCTestCase
+
+@end
+
+@implementation NSMutableDataAESTests
+{
+    NSData *_key;
+    NSData *_plaintext;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _key = [@"0123456789abcdef0123456789abcdef" dataUsingEncoding:NSUTF8StringEncoding];
+    _plaintext = [@"The quick brown fox jumps over the lazy dog" dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+#pragma mark Round trips
+
+- (void)testInPlaceEncryptionMatchesCopyingEncryption
+{
+    NSMutableData *data = [_plaintext mutableCopy];
+    [data aes_encryptInPlace:_key];
+    
+    XCTAssertEqualObjects(data, [_plaintext aes_encrypt:_key]);
+    XCTAssertEqual(data.length % kCCBlockSizeAES128, 0);
+    
+    [data aes_decryptInPlace:_key];
+    
+    XCTAssertEqualObjects(data, _plaintext);
+}
+
+- (void)testBlockAlignedDataGrowsByAPaddingBlock
+{
+    NSMutableData *data = [NSMutableData dataWithLength:2 * kCCBlockSizeAES128];
+    [data aes_encryptInPlace:_key];
+    
+    XCTAssertEqual(data.length, 3 * kCCBlockSizeAES128);
+    
+    [data aes_decryptInPlace:_key];
+    
+    XCTAssertEqualObjects(data, [NSMutableData dataWithLength:2 * kCCBlockSizeAES128]);
+}
+
+- (void)testRoundTripWithoutPadding
+{
+    NSMutableData *data = [NSMutableData dataWithLength:4 * kCCBlockSizeAES128];
+    memset(data.mutableBytes, 'a', data.length);
+    NSData *plaintext = [data copy];
+    
+    [data aes_encryptInPlace:_key withPadding:0];
+    
+    XCTAssertEqual(data.length, plaintext.length);
+    XCTAssertNotEqualObjects(data, plaintext);
+    
+    [data aes_decryptInPlace:_key withPadding:0];
+    
+    XCTAssertEqualObjects(data, plaintext);
+}
+
+- (void)testEmptyDataRoundTrip
+{
+    NSMutableData *data = [NSMutableData data];
+    [data aes_encryptInPlace:_key];
+    
+    XCTAssertEqual(data.length, kCCBlockSizeAES128);
+    
+    [data aes_decryptInPlace:_key];
+    
+    XCTAssertEqual(data.length, 0);
+}
+
+#pragma mark Failures
+
+- (void)testFailedDecryptionEmptiesTheData
+{
+    NSMutableData *data = [_plaintext mutableCopy];
+    [data aes_encryptInPlace:_key];
+    
+    // Not a whole number of blocks.
+    [data setLength:data.length - 1];
+    [data aes_decryptInPlace:_key];
+    
+    XCTAssertEqual(data.length, 0);
+}
+
+- (void)testFailedEncryptionWithoutPaddingEmptiesTheData
+{
+    NSMutableData *data = [_plaintext mutableCopy];
+    [data aes_encryptInPlace:_key withPadding:0];
+    
+    XCTAssertEqual(data.length, 0);
+}
+
+- (void)testFailureIsReported
+{
+    NSMutableData *data = [NSMutableData dataWithLength:kCCBlockSizeAES128 + 1];
+    NSError *error = nil;
+    
+    BOOL succeed = [NSDataAESCipher cipherInPlaceWithKey:_key data:data iv:nil operation:kCCDecrypt options:kCCOptionPKCS7Padding error:&error];
+    
+    XCTAssertFalse(succeed);
+    XCTAssertEqualObjects(error.domain, NSDataAESCipherErrorDomain);
+    XCTAssertEqual(data.length, 0);
+}
+
+@end
@@ -0,0 +1,222 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSUInteger const MJDataProviderCacheDefaultMemoryCapacity;
+extern NSUInteger const MJDataProviderCacheDefaultDiskCapacity;
+
+/**
+ * An entry of a data provider cache.
+ **/
+@interface MJDataProviderCacheEntry : NSObject
+
+/**
+ * The cached object.
+ **/
+@property (nonatomic, strong, readonly) id <NSCoding> object;
+
+/**
+ * The date the object was stored.
+ **/
+@property (nonatomic, strong, readonly) NSDate *date;
+
+/**
+ * The date the object expires. Nil if it never expires.
+ **/
+@property (nonatomic, strong, readonly) NSDate *expirationDate;
+
+/**
+ * The date until the object can still be used while being revalidated. Nil if it never expires.
+ **/
+@property (nonatomic, strong, readonly) NSDate *staleDate;
+
+/**
+ * The memory cost of the object, in bytes.
+ **/
+@property (nonatomic, assign, readonly) NSUInteger cost;
+
+/**
+ * An optional tag identifying the version of the object, as an HTTP ETag.
+ **/
+@property (nonatomic, strong, readonly) NSString *tag;
+
+/**
+ * The SHA256 hash of the archived object.
+ **/
+@property (nonatomic, strong, readonly) NSData *contentHash;
+
+/**
+ * Compares the version of two entries, by tag if both have one, by content hash otherwise.
+ * @param entry The other entry.
+ * @return YES if both entries hold the same version of the object.
+ **/
+- (BOOL)hasSameContentAsEntry:(MJDataProviderCacheEntry*)entry;
+
+/**
+ * YES if the expiration date has passed.
+ **/
+- (BOOL)isExpired;
+
+/**
+ * YES if the stale date has passed. The object should not be used anymore.
+ **/
+- (BOOL)isStale;
+
+@end
+
+/**
+ * Two-tier cache: an in-memory LRU cache limited by a byte budget, backed by a disk store.
+ * @discussion Objects are archived with `NSKeyedArchiver` into one file per key. Objects evicted from memory are still read from disk and promoted back to memory. This class is thread-safe.
+ *
+ * The disk store is limited by `diskCapacity`: files past their stale date are removed first, then the least recently written or promoted ones. The disk is trimmed when created, when the app enters background and when a write exceeds the capacity.
+ **/
+@interface MJDataProviderCache : NSObject
+
+/**
+ * The shared cache.
+ **/
++ (MJDataProviderCache*)sharedCache;
+
+/**
+ * Default initializer.
+ * @param name The name of the cache, used for the disk directory inside the caches directory.
+ * @return The initialized instance.
+ **/
+- (id)initWithName:(NSString*)name;
+
+/**
+ * Initializer with a custom disk directory.
+ * @param directoryURL The disk directory. If nil, the cache is memory only.
+ * @return The initialized instance.
+ **/
+- (id)initWithDirectoryURL:(NSURL*)directoryURL;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The disk directory. Nil if memory only.
+ **/
+@property (nonatomic, strong, readonly) NSURL *directoryURL;
+
+/**
+ * The maximum memory cost of the objects kept in memory, in bytes. Default value is `MJDataProviderCacheDefaultMemoryCapacity`.
+ **/
+@property (nonatomic, assign) NSUInteger memoryCapacity;
+
+/**
+ * The memory cost of the objects currently kept in memory, in bytes.
+ **/
+@property (nonatomic, assign, readonly) NSUInteger memoryUsage;
+
+/**
+ * The maximum size of the disk store, in bytes. Default value is `MJDataProviderCacheDefaultDiskCapacity`.
+ **/
+@property (nonatomic, assign) NSUInteger diskCapacity;
+
+/** *************************************************** **
+ * @name Reading
+ ** *************************************************** **/
+
+/**
+ * Returns the entry of a key, from memory or disk.
+ * @param key The key.
+ * @return The entry, nil if not cached.
+ * @discussion Stale entries are returned too. Check `isExpired` and `isStale`. Entries not in memory are read from disk in the calling thread, without waiting for other disk operations. Use `entryForKey:completion:` to read them in background.
+ **/
+- (MJDataProviderCacheEntry*)entryForKey:(NSString*)key;
+
+/**
+ * Returns asynchronously the entry of a key, from memory or disk.
+ * @param key The key.
+ * @param completion The completion block, called in the main queue with the entry, nil if not cached.
+ * @discussion Stale entries are returned too. Disk reads are done in a background queue.
+ **/
+- (void)entryForKey:(NSString*)key completion:(void (^)(MJDataProviderCacheEntry *entry))completion;
+
+/**
+ * Returns the object of a key, if not expired.
+ * @param key The key.
+ * @return The object, nil if not cached or expired.
+ **/
+- (id)objectForKey:(NSString*)key;
+
+/** *************************************************** **
+ * @name Writing
+ ** *************************************************** **/
+
+/**
+ * Stores an object that never expires.
+ * @param object The object.
+ * @param key The key.
+ **/
+- (void)setObject:(id <NSCoding>)object forKey:(NSString*)key;
+
+/**
+ * Stores an object.
+ * @param object The object.
+ * @param key The key.
+ * @param cost The memory cost in bytes. If 0, the archived size is used.
+ * @param timeToLive The time until the object expires. If 0, it never expires.
+ * @param staleWhileRevalidate The time after expiring the object can still be used while being revalidated.
+ **/
+- (void)setObject:(id <NSCoding>)object
+           forKey:(NSString*)key
+             cost:(NSUInteger)cost
+       timeToLive:(NSTimeInterval)timeToLive
+staleWhileRevalidate:(NSTimeInterval)staleWhileRevalidate;
+
+/**
+ * Stores an object with a version tag.
+ * @param object The object.
+ * @param key The key.
+ * @param cost The memory cost in bytes. If 0, the archived size is used.
+ * @param timeToLive The time until the object expires. If 0, it never expires.
+ * @param staleWhileRevalidate The time after expiring the object can still be used while being revalidated.
+ * @param tag An optional tag identifying the version of the object, as an HTTP ETag.
+ * @return The stored entry.
+ **/
+- (MJDataProviderCacheEntry*)setObject:(id <NSCoding>)object
+                                forKey:(NSString*)key
+                                  cost:(NSUInteger)cost
+                            timeToLive:(NSTimeInterval)timeToLive
+                  staleWhileRevalidate:(NSTimeInterval)staleWhileRevalidate
+                                   tag:(NSString*)tag;
+
+/**
+ * Removes the object of a key from memory and disk.
+ * @param key The key.
+ **/
+- (void)removeObjectForKey:(NSString*)key;
+
+/**
+ * Removes all objects from memory and disk.
+ **/
+- (void)removeAllObjects;
+
+/**
+ * Removes all objects from memory. Disk objects are kept.
+ **/
+- (void)removeAllObjectsFromMemory;
+
+/**
+ * Asynchronously removes the disk files past their stale date. If the disk store still exceeds `diskCapacity`, removes the least recently used ones until it uses three quarters of it.
+ **/
+- (void)trimDisk;
+
+@end
@@ -0,0 +1,726 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJDataProviderCache.h"
+
+#import <UIKit/UIKit.h>
+#import <sys/xattr.h>
+
+#import "NSData+SHA.h"
+
+NSUInteger const MJDataProviderCacheDefaultMemoryCapacity   = 4 * 1024 * 1024;
+NSUInteger const MJDataProviderCacheDefaultDiskCapacity     = 64 * 1024 * 1024;
+
+// Stored as an extended attribute of the files, so the disk can be pruned without unarchiving them.
+static const char * const MJDataProviderCacheStaleDateAttribute = "com.mobilejazz.core.data-provider-cache.stale-date";
+
+static NSString * const MJDataProviderCacheObjectKey            = @"object";
+static NSString * const MJDataProviderCacheDateKey              = @"date";
+static NSString * const MJDataProviderCacheExpirationDateKey    = @"expirationDate";
+static NSString * const MJDataProviderCacheStaleDateKey         = @"staleDate";
+static NSString * const MJDataProviderCacheTagKey               = @"tag";
+static NSString * const MJDataProviderCacheContentHashKey       = @"contentHash";
+static NSString * const MJDataProviderCacheCostKey              = @"cost";
+
+@interface MJDataProviderCacheEntry ()
+
+@property (nonatomic, strong, readwrite) id <NSCoding> object;
+@property (nonatomic, strong, readwrite) NSDate *date;
+@property (nonatomic, strong, readwrite) NSDate *expirationDate;
+@property (nonatomic, strong, readwrite) NSDate *staleDate;
+@property (nonatomic, assign, readwrite) NSUInteger cost;
+@property (nonatomic, strong, readwrite) NSString *tag;
+@property (nonatomic, strong, readwrite) NSData *contentHash;
+
+@end
+
+@implementation MJDataProviderCacheEntry
+
+- (BOOL)hasSameContentAsEntry:(MJDataProviderCacheEntry*)entry
+{
+    if (!entry)
+        return NO;
+    
+    if (_tag && entry.tag)
+        return [_tag isEqualToString:entry.tag];
+    
+    return [_contentHash isEqualToData:entry.contentHash];
+}
+
+- (BOOL)isExpired
+{
+    return _expirationDate && [_expirationDate timeIntervalSinceNow] < 0;
+}
+
+- (BOOL)isStale
+{
+    return _staleDate && [_staleDate timeIntervalSinceNow] < 0;
+}
+
+@end
+
+/**
+ * Node of the LRU list.
+ **/
+@interface MJDataProviderCacheNode : NSObject
+
+@property (nonatomic, strong) NSString *key;
+@property (nonatomic, strong) MJDataProviderCacheEntry *entry;
+@property (nonatomic, weak) MJDataProviderCacheNode *previous;
+@property (nonatomic, strong) MJDataProviderCacheNode *next;
+
+@end
+
+@implementation MJDataProviderCacheNode
+
+@end
+
+#pragma mark -
+
+@implementation MJDataProviderCache
+{
+    NSMutableDictionary <NSString*, MJDataProviderCacheNode*> *_nodes;
+    MJDataProviderCacheNode *_head; // Most recently used
+    MJDataProviderCacheNode *_tail; // Least recently used
+    
+    dispatch_queue_t _diskQueue;
+    
+    // Data being written (or NSNull being removed) by key, so reads don't wait for the disk queue.
+    NSMutableDictionary <NSString*, id> *_pendingDiskWrites;
+    NSUInteger _pendingDiskClears;
+    
+    // Accessed in the disk queue only.
+    unsigned long long _diskUsage;
+}
+
++ (MJDataProviderCache*)sharedCache
+{
+    static MJDataProviderCache *cache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        cache = [[MJDataProviderCache alloc] initWithName:@"shared"];
+    });
+    return cache;
+}
+
+- (id)init
+{
+    return [self initWithDirectoryURL:nil];
+}
+
+- (id)initWithName:(NSString*)name
+{
+    NSURL *cachesURL = [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask].firstObject;
+    NSURL *directoryURL = [[cachesURL URLByAppendingPathComponent:@"com.mobilejazz.core.data-provider-cache"] URLByAppendingPathComponent:name];
+    return [self initWithDirectoryURL:directoryURL];
+}
+
+- (id)initWithDirectoryURL:(NSURL*)directoryURL
+{
+    self = [super init];
+    if (self)
+    {
+        _directoryURL = directoryURL;
+        _memoryCapacity = MJDataProviderCacheDefaultMemoryCapacity;
+        _memoryUsage = 0;
+        _diskCapacity = MJDataProviderCacheDefaultDiskCapacity;
+        _nodes = [NSMutableDictionary dictionary];
+        _pendingDiskWrites = [NSMutableDictionary dictionary];
+        _diskQueue = dispatch_queue_create("com.mobilejazz.core.data-provider-cache.disk", DISPATCH_QUEUE_SERIAL);
+        
+        if (directoryURL)
+        {
+            [[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:nil];
+            
+            // Also computes the initial disk usage.
+            [self trimDisk];
+        }
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(removeAllObjectsFromMemory)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(trimDisk)
+                                                     name:UIApplicationDidEnterBackgroundNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark Properties
+
+- (void)setMemoryCapacity:(NSUInteger)memoryCapacity
+{
+    @synchronized(self)
+    {
+        _memoryCapacity = memoryCapacity;
+        [self mjz_trimMemory];
+    }
+}
+
+- (NSUInteger)memoryUsage
+{
+    @synchronized(self)
+    {
+        return _memoryUsage;
+    }
+}
+
+- (void)setDiskCapacity:(NSUInteger)diskCapacity
+{
+    @synchronized(self)
+    {
+        _diskCapacity = diskCapacity;
+    }
+    
+    [self trimDisk];
+}
+
+- (NSUInteger)diskCapacity
+{
+    @synchronized(self)
+    {
+        return _diskCapacity;
+    }
+}
+
+#pragma mark Public Methods
+
+- (MJDataProviderCacheEntry*)entryForKey:(NSString*)key
+{
+    if (!key)
+        return nil;
+    
+    MJDataProviderCacheEntry *entry = [self mjz_memoryEntryForKey:key];
+    if (entry)
+        return entry;
+    
+    return [self mjz_promoteDiskEntryForKey:key];
+}
+
+- (void)entryForKey:(NSString*)key completion:(void (^)(MJDataProviderCacheEntry *entry))completion
+{
+    MJDataProviderCacheEntry *entry = key ? [self mjz_memoryEntryForKey:key] : nil;
+    
+    if (entry || !key || !_directoryURL)
+    {
+        if (completion)
+        {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(entry);
+            });
+        }
+        return;
+    }
+    
+    // Not the disk queue, so reads don't wait for pending writes.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        MJDataProviderCacheEntry *entry = [self mjz_promoteDiskEntryForKey:key];
+        
+        if (completion)
+        {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(entry);
+            });
+        }
+    });
+}
+
+- (id)objectForKey:(NSString*)key
+{
+    MJDataProviderCacheEntry *entry = [self entryForKey:key];
+    if (!entry || entry.isExpired)
+        return nil;
+    return entry.object;
+}
+
+- (void)setObject:(id <NSCoding>)object forKey:(NSString*)key
+{
+    [self setObject:object forKey:key cost:0 timeToLive:0 staleWhileRevalidate:0];
+}
+
+- (void)setObject:(id <NSCoding>)object
+           forKey:(NSString*)key
+             cost:(NSUInteger)cost
+       timeToLive:(NSTimeInterval)timeToLive
+staleWhileRevalidate:(NSTimeInterval)staleWhileRevalidate
+{
+    [self setObject:object forKey:key cost:cost timeToLive:timeToLive staleWhileRevalidate:staleWhileRevalidate tag:nil];
+}
+
+- (MJDataProviderCacheEntry*)setObject:(id <NSCoding>)object
+                                forKey:(NSString*)key
+                                  cost:(NSUInteger)cost
+                            timeToLive:(NSTimeInterval)timeToLive
+                  staleWhileRevalidate:(NSTimeInterval)staleWhileRevalidate
+                                   tag:(NSString*)tag
+{
+    if (!key)
+        return nil;
+    
+    if (!object)
+    {
+        [self removeObjectForKey:key];
+        return nil;
+    }
+    
+    MJDataProviderCacheEntry *entry = [[MJDataProviderCacheEntry alloc] init];
+    entry.object = object;
+    entry.date = [NSDate date];
+    entry.tag = tag;
+    
+    // The object is archived on its own, so its hash doesn't depend on the entry metadata.
+    NSData *objectData = [NSKeyedArchiver archivedDataWithRootObject:object];
+    entry.contentHash = [objectData sha_SHA256];
+    
+    if (timeToLive > 0)
+    {
+        entry.expirationDate = [entry.date dateByAddingTimeInterval:timeToLive];
+        entry.staleDate = [entry.expirationDate dateByAddingTimeInterval:MAX(staleWhileRevalidate, 0)];
+    }
+    
+    // Only a cost given by the caller is stored, the archived size is known when reading the record.
+    entry.cost = cost;
+    
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:[self mjz_dictionaryWithEntry:entry objectData:objectData]];
+    if (entry.cost == 0)
+        entry.cost = data.length;
+    
+    NSURL *url = [self mjz_fileURLForKey:key];
+    NSDate *staleDate = entry.staleDate;
+    
+    // A single critical section, so concurrent writes of a key reach the memory, the pending writes and the disk queue in the same order.
+    @synchronized(self)
+    {
+        MJDataProviderCacheNode *node = _nodes[key];
+        if (node)
+            [self mjz_removeNode:node];
+        
+        [self mjz_insertEntry:entry forKey:key];
+        
+        if (url)
+        {
+            _pendingDiskWrites[key] = data;
+            
+            dispatch_async(_diskQueue, ^{
+                [self mjz_writeData:data toURL:url staleDate:staleDate];
+                [self mjz_finishPendingDiskWrite:data forKey:key];
+            });
+        }
+    }
+    
+    return entry;
+}
+
+- (void)removeObjectForKey:(NSString*)key
+{
+    if (!key)
+        return;
+    
+    NSURL *url = [self mjz_fileURLForKey:key];
+    id removal = [NSNull null];
+    
+    // Same as setting an object: ordered with concurrent writes of the key.
+    @synchronized(self)
+    {
+        MJDataProviderCacheNode *node = _nodes[key];
+        if (node)
+            [self mjz_removeNode:node];
+        
+        if (url)
+        {
+            _pendingDiskWrites[key] = removal;
+            
+            dispatch_async(_diskQueue, ^{
+                [self mjz_removeFileAtURL:url];
+                [self mjz_finishPendingDiskWrite:removal forKey:key];
+            });
+        }
+    }
+}
+
+- (void)removeAllObjects
+{
+    [self removeAllObjectsFromMemory];
+    
+    NSURL *directoryURL = _directoryURL;
+    if (directoryURL)
+    {
+        // Until the directory is removed, reads only see writes done after this call.
+        @synchronized(self)
+        {
+            [_pendingDiskWrites removeAllObjects];
+            _pendingDiskClears++;
+        }
+        
+        dispatch_async(_diskQueue, ^{
+            NSFileManager *fileManager = [NSFileManager defaultManager];
+            [fileManager removeItemAtURL:directoryURL error:nil];
+            [fileManager createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:nil];
+            _diskUsage = 0;
+            
+            @synchronized(self)
+            {
+                _pendingDiskClears--;
+            }
+        });
+    }
+}
+
+- (void)removeAllObjectsFromMemory
+{
+    @synchronized(self)
+    {
+        [_nodes removeAllObjects];
+        _head = nil;
+        _tail = nil;
+        _memoryUsage = 0;
+    }
+}
+
+- (void)trimDisk
+{
+    if (!_directoryURL)
+        return;
+    
+    dispatch_async(_diskQueue, ^{
+        [self mjz_trimDisk];
+    });
+}
+
+#pragma mark Private Methods
+
+- (MJDataProviderCacheEntry*)mjz_memoryEntryForKey:(NSString*)key
+{
+    @synchronized(self)
+    {
+        MJDataProviderCacheNode *node = _nodes[key];
+        if (!node)
+            return nil;
+        
+        [self mjz_moveNodeToHead:node];
+        return node.entry;
+    }
+}
+
+- (MJDataProviderCacheEntry*)mjz_promoteDiskEntryForKey:(NSString*)key
+{
+    MJDataProviderCacheEntry *entry = [self mjz_diskEntryForKey:key];
+    
+    if (entry)
+    {
+        @synchronized(self)
+        {
+            // Another thread may have stored a newer object meanwhile.
+            MJDataProviderCacheNode *node = _nodes[key];
+            if (node)
+                return node.entry;
+            
+            [self mjz_insertEntry:entry forKey:key];
+        }
+    }
+    
+    return entry;
+}
+
+- (void)mjz_insertEntry:(MJDataProviderCacheEntry*)entry forKey:(NSString*)key
+{
+    MJDataProviderCacheNode *node = [[MJDataProviderCacheNode alloc] init];
+    node.key = key;
+    node.entry = entry;
+    
+    node.next = _head;
+    _head.previous = node;
+    _head = node;
+    if (!_tail)
+        _tail = node;
+    
+    _nodes[key] = node;
+    _memoryUsage += entry.cost;
+    
+    [self mjz_trimMemory];
+}
+
+- (void)mjz_removeNode:(MJDataProviderCacheNode*)node
+{
+    MJDataProviderCacheNode *previous = node.previous;
+    MJDataProviderCacheNode *next = node.next;
+    
+    if (previous)
+        previous.next = next;
+    else
+        _head = next;
+    
+    if (next)
+        next.previous = previous;
+    else
+        _tail = previous;
+    
+    node.next = nil;
+    node.previous = nil;
+    
+    [_nodes removeObjectForKey:node.key];
+    _memoryUsage -= node.entry.cost;
+}
+
+- (void)mjz_moveNodeToHead:(MJDataProviderCacheNode*)node
+{
+    if (node == _head)
+        return;
+    
+    MJDataProviderCacheNode *previous = node.previous;
+    MJDataProviderCacheNode *next = node.next;
+    
+    previous.next = next;
+    if (next)
+        next.previous = previous;
+    else
+        _tail = previous;
+    
+    node.previous = nil;
+    node.next = _head;
+    _head.previous = node;
+    _head = node;
+}
+
+- (void)mjz_trimMemory
+{
+    // Evicts the least recently used objects. They remain on disk.
+    while (_memoryUsage > _memoryCapacity && _tail)
+        [self mjz_removeNode:_tail];
+}
+
+- (NSURL*)mjz_fileURLForKey:(NSString*)key
+{
+    if (!_directoryURL)
+        return nil;
+    
+    // Hashed, so any key is a valid file name.
+    NSData *hash = [[key dataUsingEncoding:NSUTF8StringEncoding] sha_SHA256];
+    const uint8_t *bytes = hash.bytes;
+    
+    NSMutableString *fileName = [NSMutableString stringWithCapacity:hash.length * 2];
+    for (NSUInteger i = 0; i < hash.length; i++)
+        [fileName appendFormat:@"%02x", bytes[i]];
+    
+    return [_directoryURL URLByAppendingPathComponent:fileName];
+}
+
+- (MJDataProviderCacheEntry*)mjz_diskEntryForKey:(NSString*)key
+{
+    NSURL *url = [self mjz_fileURLForKey:key];
+    if (!url)
+        return nil;
+    
+    NSData *data = nil;
+    
+    @synchronized(self)
+    {
+        id pendingData = _pendingDiskWrites[key];
+        if (pendingData == [NSNull null])
+            return nil;
+        
+        data = pendingData;
+        
+        if (!data && _pendingDiskClears > 0)
+            return nil;
+    }
+    
+    if (!data)
+    {
+        // Files are replaced atomically, so reading without the disk queue never sees a partial write.
+        data = [NSData dataWithContentsOfURL:url];
+        
+        if (!data)
+            return nil;
+        
+        // Promoted files are the most recently used when trimming the disk.
+        dispatch_async(_diskQueue, ^{
+            [url setResourceValue:[NSDate date] forKey:NSURLContentModificationDateKey error:nil];
+        });
+    }
+    
+    NSDictionary *dictionary = nil;
+    id object = nil;
+    
+    @try
+    {
+        dictionary = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+        
+        NSData *objectData = [dictionary isKindOfClass:NSDictionary.class] ? dictionary[MJDataProviderCacheObjectKey] : nil;
+        if ([objectData isKindOfClass:NSData.class])
+            object = [NSKeyedUnarchiver unarchiveObjectWithData:objectData];
+    }
+    @catch (NSException *exception)
+    {
+        object = nil;
+    }
+    
+    if (!object)
+        return nil;
+    
+    MJDataProviderCacheEntry *entry = [[MJDataProviderCacheEntry alloc] init];
+    entry.object = object;
+    entry.date = dictionary[MJDataProviderCacheDateKey];
+    entry.expirationDate = dictionary[MJDataProviderCacheExpirationDateKey];
+    entry.staleDate = dictionary[MJDataProviderCacheStaleDateKey];
+    entry.tag = dictionary[MJDataProviderCacheTagKey];
+    entry.contentHash = dictionary[MJDataProviderCacheContentHashKey];
+    
+    // Records written before the hash was stored.
+    if (![entry.contentHash isKindOfClass:NSData.class])
+        entry.contentHash = [dictionary[MJDataProviderCacheObjectKey] sha_SHA256];
+    
+    // Records without a cost use the archived size, as when they were stored.
+    NSNumber *cost = dictionary[MJDataProviderCacheCostKey];
+    entry.cost = [cost isKindOfClass:NSNumber.class] && cost.unsignedIntegerValue > 0 ? cost.unsignedIntegerValue : data.length;
+    
+    return entry;
+}
+
+- (void)mjz_finishPendingDiskWrite:(id)data forKey:(NSString*)key
+{
+    @synchronized(self)
+    {
+        // Newer writes of the same key stay pending.
+        if (_pendingDiskWrites[key] == data)
+            [_pendingDiskWrites removeObjectForKey:key];
+    }
+}
+
+- (unsigned long long)mjz_fileSizeAtURL:(NSURL*)url
+{
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:url.path error:nil];
+    return attributes.fileSize;
+}
+
+- (void)mjz_writeData:(NSData*)data toURL:(NSURL*)url staleDate:(NSDate*)staleDate
+{
+    // Disk queue only.
+    unsigned long long previousSize = [self mjz_fileSizeAtURL:url];
+    
+    if (![data writeToURL:url atomically:YES])
+        return;
+    
+    if (staleDate)
+    {
+        NSTimeInterval staleTime = staleDate.timeIntervalSinceReferenceDate;
+        setxattr(url.fileSystemRepresentation, MJDataProviderCacheStaleDateAttribute, &staleTime, sizeof(staleTime), 0, 0);
+    }
+    
+    _diskUsage = _diskUsage - MIN(previousSize, _diskUsage) + data.length;
+    
+    if (_diskUsage > self.diskCapacity)
+        [self mjz_trimDisk];
+}
+
+- (void)mjz_removeFileAtURL:(NSURL*)url
+{
+    // Disk queue only.
+    unsigned long long size = [self mjz_fileSizeAtURL:url];
+    
+    if ([[NSFileManager defaultManager] removeItemAtURL:url error:nil])
+        _diskUsage -= MIN(size, _diskUsage);
+}
+
+- (void)mjz_trimDisk
+{
+    // Disk queue only.
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSArray *resourceKeys = @[NSURLFileSizeKey, NSURLContentModificationDateKey];
+    NSArray <NSURL*> *urls = [fileManager contentsOfDirectoryAtURL:_directoryURL
+                                        includingPropertiesForKeys:resourceKeys
+                                                           options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                             error:nil];
+    
+    NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+    NSMutableArray <NSDictionary*> *files = [NSMutableArray arrayWithCapacity:urls.count];
+    unsigned long long usage = 0;
+    
+    for (NSURL *url in urls)
+    {
+        NSTimeInterval staleTime = 0;
+        if (getxattr(url.fileSystemRepresentation, MJDataProviderCacheStaleDateAttribute, &staleTime, sizeof(staleTime), 0, 0) == sizeof(staleTime) && staleTime < now)
+        {
+            [fileManager removeItemAtURL:url error:nil];
+            continue;
+        }
+        
+        NSMutableDictionary *values = [[url resourceValuesForKeys:resourceKeys error:nil] mutableCopy];
+        if (!values[NSURLFileSizeKey] || !values[NSURLContentModificationDateKey])
+            continue;
+        
+        values[@"url"] = url;
+        [files addObject:values];
+        usage += [values[NSURLFileSizeKey] unsignedLongLongValue];
+    }
+    
+    unsigned long long capacity = self.diskCapacity;
+    
+    if (usage > capacity)
+    {
+        // Trims below the capacity, so the next writes don't trim again.
+        unsigned long long targetUsage = capacity / 4 * 3;
+        
+        [files sortUsingComparator:^NSComparisonResult(NSDictionary *file1, NSDictionary *file2) {
+            return [file1[NSURLContentModificationDateKey] compare:file2[NSURLContentModificationDateKey]];
+        }];
+        
+        for (NSDictionary *file in files)
+        {
+            if (usage <= targetUsage)
+                break;
+            
+            if ([fileManager removeItemAtURL:file[@"url"] error:nil])
+                usage -= [file[NSURLFileSizeKey] unsignedLongLongValue];
+        }
+    }
+    
+    _diskUsage = usage;
+}
+
+- (NSDictionary*)mjz_dictionaryWithEntry:(MJDataProviderCacheEntry*)entry objectData:(NSData*)objectData
+{
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    dictionary[MJDataProviderCacheObjectKey] = objectData;
+    dictionary[MJDataProviderCacheDateKey] = entry.date;
+    
+    if (entry.expirationDate)
+        dictionary[MJDataProviderCacheExpirationDateKey] = entry.expirationDate;
+    
+    if (entry.staleDate)
+        dictionary[MJDataProviderCacheStaleDateKey] = entry.staleDate;
+    
+    if (entry.tag)
+        dictionary[MJDataProviderCacheTagKey] = entry.tag;
+    
+    if (entry.contentHash)
+        dictionary[MJDataProviderCacheContentHashKey] = entry.contentHash;
+    
+    if (entry.cost > 0)
+        dictionary[MJDataProviderCacheCostKey] = @(entry.cost);
+    
+    return dictionary;
+}
+
+@end
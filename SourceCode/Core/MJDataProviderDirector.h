@@ -16,6 +16,9 @@
 
 #import <Foundation/Foundation.h>
 
+#import "MJDataProviderCache.h"
+#import "MJDataProviderScheduler.h"
+
 typedef NS_ENUM(NSUInteger, MJDataProviderDirectorResolveRoute)
 {
     MJDataProviderDirectorResolveRouteCache,
@@ -42,6 +45,86 @@ typedef NS_ENUM(NSUInteger, MJDataProviderDirectorResolveRoute)
 - (void)resolveWithNetwork;
 - (void)resolveWithCache;
 
+/** *************************************************** **
+ * @name Built-in cache
+ ** *************************************************** **/
+
+/**
+ * The cache entry of the cache key, if the director has a cache. Stale entries are included, so the network block can use them as fallback.
+ **/
+@property (nonatomic, strong, readonly) MJDataProviderCacheEntry *cacheEntry;
+
+/**
+ * The cached object of the cache key, if the director has a cache.
+ **/
+@property (nonatomic, strong, readonly) id cachedObject;
+
+/**
+ * Stores an object in the director cache for the cache key, using the director time to live.
+ * @param object The object.
+ **/
+- (void)storeObject:(id <NSCoding>)object;
+
+/**
+ * Stores an object in the director cache for the cache key, using the director time to live.
+ * @param object The object.
+ * @param cost The memory cost in bytes. If 0, the archived size is used.
+ **/
+- (void)storeObject:(id <NSCoding>)object cost:(NSUInteger)cost;
+
+/**
+ * Stores an object in the director cache for the cache key, using the director time to live.
+ * @param object The object.
+ * @param cost The memory cost in bytes. If 0, the archived size is used.
+ * @param tag An optional tag identifying the version of the object, as an HTTP ETag. If nil, versions are compared by content hash.
+ * @discussion In the stale-while-revalidate route, the update block is executed if the stored object is a new version.
+ **/
+- (void)storeObject:(id <NSCoding>)object cost:(NSUInteger)cost tag:(NSString*)tag;
+
+/**
+ * YES if the network block is revalidating a cached object that has already been delivered.
+ **/
+@property (nonatomic, assign, readonly) BOOL isRevalidating;
+
+/** *************************************************** **
+ * @name Scheduling
+ ** *************************************************** **/
+
+/**
+ * Releases the scheduler slot taken by the network block.
+ * @discussion If not called, the slot is released when the resolver is deallocated.
+ **/
+- (void)finish;
+
+/**
+ * YES if the resolver belongs to a cancelled prefetch group. Network blocks should stop as soon as possible, objects are not stored anymore.
+ **/
+@property (nonatomic, assign, readonly) BOOL isCancelled;
+
+@end
+
+#pragma mark -
+
+/**
+ * A group of prefetch requests.
+ **/
+@interface MJDataProviderPrefetchGroup : NSObject
+
+/**
+ * The keys being prefetched. Keys with a valid cache entry are not included.
+ **/
+@property (nonatomic, strong, readonly) NSArray <NSString*> *keys;
+
+/**
+ * YES if the group has been cancelled.
+ **/
+@property (nonatomic, assign, readonly) BOOL isCancelled;
+
+/**
+ * Cancels all requests of the group. Pending requests are not executed and running ones release their scheduler slot.
+ **/
+- (void)cancel;
+
 @end
 
 #pragma mark -
@@ -57,6 +140,33 @@ typedef NS_ENUM(NSUInteger, MJDataProviderDirectorResolveRoute)
 
 @property (nonatomic, assign) BOOL forceRefresh;
 
+/**
+ * The built-in cache. Default value is nil.
+ * @discussion If set, calls with a cache key read the cache before running the cache block, and are automatically resolved with network when the entry is missing or expired.
+ **/
+@property (nonatomic, strong) MJDataProviderCache *cache;
+
+/**
+ * The time objects stored through the resolver are valid. Default value is 0 (never expires).
+ **/
+@property (nonatomic, assign) NSTimeInterval timeToLive;
+
+/**
+ * The time objects can still be used after expiring, while being revalidated. Default value is 0.
+ **/
+@property (nonatomic, assign) NSTimeInterval staleWhileRevalidate;
+
+/**
+ * The scheduler used to limit concurrent network blocks. Default value is nil (network blocks are executed at once).
+ * @discussion Network blocks executed through a scheduler may run later and in another thread. Each one holds a slot until its resolver is finished or deallocated.
+ **/
+@property (nonatomic, strong) MJDataProviderScheduler *scheduler;
+
+/**
+ * The scheduler lane of the network blocks. Default value is `MJDataProviderSchedulerLaneVisible`.
+ **/
+@property (nonatomic, assign) MJDataProviderSchedulerLane lane;
+
 /** *************************************************** **
  * @name Main methods
  ** *************************************************** **/
@@ -64,4 +174,41 @@ typedef NS_ENUM(NSUInteger, MJDataProviderDirectorResolveRoute)
 - (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock
           cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock;
 
+/**
+ * Executes cache and network blocks using the built-in cache.
+ * @param networkBlock The network block. Store the fetched object with `storeObject:`.
+ * @param cacheBlock The cache block, executed only if the cache has a valid entry. Read it from `cachedObject`.
+ * @param cacheKey The cache key. If nil or if the director has no cache, behaves as `networkBlock:cacheBlock:`.
+ **/
+- (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock
+          cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+            cacheKey:(NSString*)cacheKey;
+
+/**
+ * Executes cache and network blocks using the stale-while-revalidate strategy.
+ * @param networkBlock The network block. Store the fetched object with `storeObject:` instead of delivering it.
+ * @param cacheBlock The cache block, executed at once if the cache has a usable entry, even if expired within the stale window. Read it from `cachedObject`.
+ * @param cacheKey The cache key. Required, as well as the director cache.
+ * @param updateBlock A block executed when the network block stores a new version of the object. Read it from `cachedObject`.
+ * @discussion The network block runs after the cache block, unless the entry hasn't expired yet. If there is no usable entry or `forceRefresh` is set, only the network block runs and the update block delivers the result.
+ **/
+- (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock
+          cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+            cacheKey:(NSString*)cacheKey
+         updateBlock:(void (^)(MJDataProviderDirectorResolver *resolver))updateBlock;
+
+/** *************************************************** **
+ * @name Prefetching
+ ** *************************************************** **/
+
+/**
+ * Warms the cache for a list of keys, executing the network block in the prefetch lane.
+ * @param keys The cache keys.
+ * @param networkBlock The network block, executed once for each key without a valid cache entry. Store the fetched object with `storeObject:`.
+ * @return The prefetch group, nil if the director has no cache.
+ * @discussion No cache nor update blocks are executed. If the director has no scheduler, the shared scheduler is used.
+ **/
+- (MJDataProviderPrefetchGroup*)prefetchKeys:(NSArray <NSString*> *)keys
+                                networkBlock:(void (^)(NSString *key, MJDataProviderDirectorResolver *resolver))networkBlock;
+
 @end
@@ -16,6 +16,35 @@
 
 #import "MJDataProviderDirector.h"
 
+static void MJDataProviderDirectorExecuteNetworkBlock(MJDataProviderScheduler *scheduler,
+                                                      MJDataProviderSchedulerLane lane,
+                                                      void (^networkBlock)(MJDataProviderDirectorResolver *resolver),
+                                                      MJDataProviderDirectorResolver *resolver);
+
+@interface MJDataProviderDirectorResolver ()
+
+@property (nonatomic, strong, readwrite) MJDataProviderCacheEntry *cacheEntry;
+
+@property (nonatomic, strong) MJDataProviderCache *cache;
+@property (nonatomic, strong) NSString *cacheKey;
+@property (nonatomic, assign) NSTimeInterval timeToLive;
+@property (nonatomic, assign) NSTimeInterval staleWhileRevalidate;
+@property (nonatomic, assign, readwrite) BOOL isRevalidating;
+@property (nonatomic, copy) void (^updateBlock)(MJDataProviderDirectorResolver *resolver);
+@property (atomic, strong) MJDataProviderTicket *ticket;
+@property (nonatomic, assign, readwrite) BOOL isCancelled;
+
+@end
+
+@interface MJDataProviderPrefetchGroup ()
+
+@property (nonatomic, strong, readwrite) NSArray <NSString*> *keys;
+@property (nonatomic, assign, readwrite) BOOL isCancelled;
+
+- (void)mjz_addResolver:(MJDataProviderDirectorResolver*)resolver;
+
+@end
+
 @implementation MJDataProviderDirectorResolver
 {
     void (^_block)(MJDataProviderDirectorResolveRoute route);
@@ -36,6 +65,11 @@
     return self;
 }
 
+- (void)dealloc
+{
+    [_ticket finish];
+}
+
 - (void)resolveWithNetwork
 {
     if (_block)
@@ -48,29 +82,138 @@
         _block(MJDataProviderDirectorResolveRouteCache);
 }
 
+- (id)cachedObject
+{
+    return _cacheEntry.object;
+}
+
+- (void)storeObject:(id <NSCoding>)object
+{
+    [self storeObject:object cost:0];
+}
+
+- (void)storeObject:(id <NSCoding>)object cost:(NSUInteger)cost
+{
+    [self storeObject:object cost:cost tag:nil];
+}
+
+- (void)storeObject:(id <NSCoding>)object cost:(NSUInteger)cost tag:(NSString*)tag
+{
+    if (_isCancelled)
+        return;
+    
+    MJDataProviderCacheEntry *previousEntry = _cacheEntry;
+    MJDataProviderCacheEntry *entry = [_cache setObject:object forKey:_cacheKey cost:cost timeToLive:_timeToLive staleWhileRevalidate:_staleWhileRevalidate tag:tag];
+    
+    if (!entry)
+        return;
+    
+    _cacheEntry = entry;
+    
+    if (_updateBlock && ![entry hasSameContentAsEntry:previousEntry])
+        _updateBlock(self);
+}
+
+- (void)finish
+{
+    [self.ticket finish];
+}
+
 @end
 
-@implementation MJDataProviderDirector
+@implementation MJDataProviderPrefetchGroup
+{
+    NSHashTable <MJDataProviderDirectorResolver*> *_resolvers;
+    NSMutableArray <MJDataProviderTicket*> *_tickets;
+}
 
-- (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+- (id)init
 {
-    __block __weak MJDataProviderDirectorResolver *weakResolver = nil;
+    self = [super init];
+    if (self)
+    {
+        _resolvers = [NSHashTable weakObjectsHashTable];
+        _tickets = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)cancel
+{
+    NSArray *resolvers = nil;
+    NSArray *tickets = nil;
     
-    MJDataProviderDirectorResolver *resolver = [MJDataProviderDirectorResolver resolverWithBlock:^(MJDataProviderDirectorResolveRoute route) {
+    @synchronized(self)
+    {
+        if (_isCancelled)
+            return;
         
-        __strong MJDataProviderDirectorResolver *strongResolver = weakResolver;
+        _isCancelled = YES;
         
-        if (route == MJDataProviderDirectorResolveRouteCache)
-        {
-            cacheBlock(strongResolver);
-        }
-        else if (route == MJDataProviderDirectorResolveRouteNetwork)
-        {
-            networkBlock(strongResolver);
-        }
-    }];
+        resolvers = _resolvers.allObjects;
+        tickets = [_tickets copy];
+        
+        [_resolvers removeAllObjects];
+        [_tickets removeAllObjects];
+    }
     
-    weakResolver = resolver;
+    for (MJDataProviderDirectorResolver *resolver in resolvers)
+        resolver.isCancelled = YES;
+    
+    // Latest first: the tickets of a group share a FIFO lane, so cancelling a running ticket
+    // can't free a slot for a pending ticket of the group.
+    for (MJDataProviderTicket *ticket in tickets.reverseObjectEnumerator)
+        [ticket cancel];
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_addResolver:(MJDataProviderDirectorResolver*)resolver
+{
+    @synchronized(self)
+    {
+        [_resolvers addObject:resolver];
+        
+        if (resolver.ticket)
+            [_tickets addObject:resolver.ticket];
+    }
+}
+
+@end
+
+@implementation MJDataProviderDirector
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _lane = MJDataProviderSchedulerLaneVisible;
+    }
+    return self;
+}
+
+- (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+{
+    [self networkBlock:networkBlock cacheBlock:cacheBlock cacheKey:nil];
+}
+
+- (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock
+          cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+            cacheKey:(NSString*)cacheKey
+{
+    MJDataProviderDirectorResolver *resolver = [self mjz_resolverWithNetworkBlock:networkBlock cacheBlock:cacheBlock];
+    
+    MJDataProviderCache *cache = cacheKey ? _cache : nil;
+    
+    if (cache)
+    {
+        resolver.cache = cache;
+        resolver.cacheKey = cacheKey;
+        resolver.timeToLive = _timeToLive;
+        resolver.staleWhileRevalidate = _staleWhileRevalidate;
+        resolver.cacheEntry = [cache entryForKey:cacheKey];
+    }
     
     if (_forceRefresh)
     {
@@ -79,7 +222,7 @@
         if (networkBlock)
         {
             // If network block, execute network block
-            networkBlock(resolver);
+            MJDataProviderDirectorExecuteNetworkBlock(_scheduler, _lane, networkBlock, resolver);
         }
         else
         {
@@ -89,7 +232,12 @@
     else
     {
         // Otherwise, use cache block.
-        if (cacheBlock)
+        if (cache && (!resolver.cacheEntry || resolver.cacheEntry.isExpired))
+        {
+            // If the built-in cache has no valid entry, resolve with network
+            [resolver resolveWithNetwork];
+        }
+        else if (cacheBlock)
         {
             // If cache block is defined, execute cache block
             cacheBlock(resolver);
@@ -102,4 +250,168 @@
     }
 }
 
+- (void)networkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock
+          cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+            cacheKey:(NSString*)cacheKey
+         updateBlock:(void (^)(MJDataProviderDirectorResolver *resolver))updateBlock
+{
+    MJDataProviderCache *cache = cacheKey ? _cache : nil;
+    
+    if (!cache)
+    {
+        // Without cache there is nothing to revalidate.
+        [self networkBlock:networkBlock cacheBlock:cacheBlock cacheKey:nil];
+        return;
+    }
+    
+    MJDataProviderCacheEntry *entry = _forceRefresh ? nil : [cache entryForKey:cacheKey];
+    
+    if (entry && entry.isStale)
+        entry = nil;
+    
+    if (entry && cacheBlock)
+    {
+        // Serve the cached object at once
+        MJDataProviderDirectorResolver *cacheResolver = [self mjz_resolverWithNetworkBlock:networkBlock cacheBlock:cacheBlock];
+        cacheResolver.cache = cache;
+        cacheResolver.cacheKey = cacheKey;
+        cacheResolver.timeToLive = _timeToLive;
+        cacheResolver.staleWhileRevalidate = _staleWhileRevalidate;
+        cacheResolver.cacheEntry = entry;
+        
+        cacheBlock(cacheResolver);
+        
+        // Fresh entries don't need to be revalidated yet
+        if (entry.expirationDate && !entry.isExpired)
+            return;
+    }
+    else
+    {
+        entry = nil;
+    }
+    
+    if (!networkBlock)
+        return;
+    
+    MJDataProviderDirectorResolver *networkResolver = [self mjz_resolverWithNetworkBlock:networkBlock cacheBlock:cacheBlock];
+    networkResolver.cache = cache;
+    networkResolver.cacheKey = cacheKey;
+    networkResolver.timeToLive = _timeToLive;
+    networkResolver.staleWhileRevalidate = _staleWhileRevalidate;
+    networkResolver.cacheEntry = entry;
+    networkResolver.isRevalidating = entry != nil;
+    networkResolver.updateBlock = updateBlock;
+    
+    MJDataProviderDirectorExecuteNetworkBlock(_scheduler, _lane, networkBlock, networkResolver);
+}
+
+- (MJDataProviderPrefetchGroup*)prefetchKeys:(NSArray <NSString*> *)keys
+                                networkBlock:(void (^)(NSString *key, MJDataProviderDirectorResolver *resolver))networkBlock
+{
+    MJDataProviderCache *cache = _cache;
+    
+    if (!cache)
+        return nil;
+    
+    MJDataProviderScheduler *scheduler = _scheduler ?: [MJDataProviderScheduler sharedScheduler];
+    NSMutableArray *prefetchKeys = [NSMutableArray arrayWithCapacity:keys.count];
+    
+    for (NSString *key in keys)
+    {
+        MJDataProviderCacheEntry *entry = [cache entryForKey:key];
+        
+        // Keys with a valid entry are already warm
+        if (!_forceRefresh && entry && !entry.isExpired)
+            continue;
+        
+        [prefetchKeys addObject:key];
+    }
+    
+    MJDataProviderPrefetchGroup *group = [[MJDataProviderPrefetchGroup alloc] init];
+    group.keys = prefetchKeys;
+    
+    if (!networkBlock)
+        return group;
+    
+    for (NSString *key in prefetchKeys)
+    {
+        MJDataProviderDirectorResolver *resolver = [MJDataProviderDirectorResolver resolverWithBlock:nil];
+        resolver.cache = cache;
+        resolver.cacheKey = key;
+        resolver.timeToLive = _timeToLive;
+        resolver.staleWhileRevalidate = _staleWhileRevalidate;
+        resolver.cacheEntry = [cache entryForKey:key];
+        
+        MJDataProviderDirectorExecuteNetworkBlock(scheduler, MJDataProviderSchedulerLanePrefetch, ^(MJDataProviderDirectorResolver *resolver) {
+            // The group may have been cancelled after the request was started asynchronously.
+            if (resolver.isCancelled)
+            {
+                [resolver finish];
+                return;
+            }
+            
+            networkBlock(key, resolver);
+        }, resolver);
+        
+        [group mjz_addResolver:resolver];
+    }
+    
+    return group;
+}
+
+#pragma mark Private Methods
+
+- (MJDataProviderDirectorResolver*)mjz_resolverWithNetworkBlock:(void (^)(MJDataProviderDirectorResolver *resolver))networkBlock
+                                                     cacheBlock:(void (^)(MJDataProviderDirectorResolver *resolver))cacheBlock
+{
+    __block __weak MJDataProviderDirectorResolver *weakResolver = nil;
+    
+    MJDataProviderScheduler *scheduler = _scheduler;
+    MJDataProviderSchedulerLane lane = _lane;
+    
+    MJDataProviderDirectorResolver *resolver = [MJDataProviderDirectorResolver resolverWithBlock:^(MJDataProviderDirectorResolveRoute route) {
+        
+        __strong MJDataProviderDirectorResolver *strongResolver = weakResolver;
+        
+        if (route == MJDataProviderDirectorResolveRouteCache)
+        {
+            if (cacheBlock)
+                cacheBlock(strongResolver);
+        }
+        else if (route == MJDataProviderDirectorResolveRouteNetwork)
+        {
+            if (networkBlock)
+                MJDataProviderDirectorExecuteNetworkBlock(scheduler, lane, networkBlock, strongResolver);
+        }
+    }];
+    
+    weakResolver = resolver;
+    
+    return resolver;
+}
+
 @end
+
+#pragma mark - Functions
+
+static void MJDataProviderDirectorExecuteNetworkBlock(MJDataProviderScheduler *scheduler,
+                                                      MJDataProviderSchedulerLane lane,
+                                                      void (^networkBlock)(MJDataProviderDirectorResolver *resolver),
+                                                      MJDataProviderDirectorResolver *resolver)
+{
+    if (!scheduler || !resolver)
+    {
+        networkBlock(resolver);
+        return;
+    }
+    
+    // The scheduled block retains the resolver until it runs.
+    // Afterwards, the slot is released when the resolver is finished or deallocated.
+    // The block may run in another thread before this call returns, hence the atomic ticket property.
+    MJDataProviderTicket *ticket = [scheduler scheduleBlock:^(MJDataProviderTicket *ticket) {
+        resolver.ticket = ticket;
+        networkBlock(resolver);
+    } lane:lane];
+    
+    resolver.ticket = ticket;
+}
@@ -0,0 +1,128 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSUInteger const MJDataProviderSchedulerDefaultMaxConcurrentRequests;
+
+/**
+ * Priority lanes of the scheduler.
+ **/
+typedef NS_ENUM(NSInteger, MJDataProviderSchedulerLane)
+{
+    /** Requests for the visible user interface. */
+    MJDataProviderSchedulerLaneVisible,
+    
+    /** Requests anticipating the user needs. */
+    MJDataProviderSchedulerLanePrefetch,
+    
+    /** Background synchronization requests. */
+    MJDataProviderSchedulerLaneBackground,
+};
+
+@class MJDataProviderScheduler;
+
+/**
+ * A scheduled request.
+ * @discussion A running request holds a slot of the scheduler until it is finished or cancelled.
+ **/
+@interface MJDataProviderTicket : NSObject
+
+/**
+ * The lane of the request.
+ **/
+@property (nonatomic, assign, readonly) MJDataProviderSchedulerLane lane;
+
+/**
+ * YES if the request has been cancelled.
+ **/
+@property (nonatomic, assign, readonly) BOOL isCancelled;
+
+/**
+ * Marks the request as finished, releasing its slot. Calling it more than once has no effect.
+ **/
+- (void)finish;
+
+/**
+ * Cancels the request. If not started yet, its block won't be executed. If running, its slot is released.
+ **/
+- (void)cancel;
+
+@end
+
+/**
+ * Limits the number of requests in flight and schedules the pending ones by priority lane.
+ * @discussion Lanes are served with weighted round-robin, so requests of lower lanes progress even when higher lanes are busy. This class is thread-safe.
+ **/
+@interface MJDataProviderScheduler : NSObject
+
+/**
+ * The shared scheduler.
+ **/
++ (MJDataProviderScheduler*)sharedScheduler;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The maximum number of requests in flight. Default value is `MJDataProviderSchedulerDefaultMaxConcurrentRequests`.
+ **/
+@property (nonatomic, assign) NSUInteger maxConcurrentRequests;
+
+/**
+ * Returns the weight of a lane: the number of requests started from the lane in each round. Default values are 8 (visible), 2 (prefetch) and 1 (background).
+ * @param lane The lane.
+ * @return The weight.
+ **/
+- (NSUInteger)weightForLane:(MJDataProviderSchedulerLane)lane;
+
+/**
+ * Sets the weight of a lane.
+ * @param weight The weight. Must be greater than 0.
+ * @param lane The lane.
+ **/
+- (void)setWeight:(NSUInteger)weight forLane:(MJDataProviderSchedulerLane)lane;
+
+/** *************************************************** **
+ * @name Scheduling
+ ** *************************************************** **/
+
+/**
+ * Schedules a request.
+ * @param block The request block. Call `finish` on the ticket when the request is done.
+ * @param lane The lane.
+ * @return The ticket of the request.
+ * @discussion If a slot is available the block is executed immediately in the calling thread. Otherwise it is executed later in a global queue with the priority of the lane.
+ **/
+- (MJDataProviderTicket*)scheduleBlock:(void (^)(MJDataProviderTicket *ticket))block lane:(MJDataProviderSchedulerLane)lane;
+
+/** *************************************************** **
+ * @name Statistics
+ ** *************************************************** **/
+
+/**
+ * Returns the statistics of each lane.
+ * @return A dictionary indexed by lane name (`visible`, `prefetch`, `background`). Each value contains the queue depth, requests in flight, started requests, cancelled requests, and the average and maximum wait time in seconds.
+ **/
+- (NSDictionary*)statistics;
+
+/**
+ * Resets the statistics.
+ **/
+- (void)resetStatistics;
+
+@end
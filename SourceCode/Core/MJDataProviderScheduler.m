@@ -0,0 +1,356 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJDataProviderScheduler.h"
+
+#import <mach/mach_time.h>
+
+NSUInteger const MJDataProviderSchedulerDefaultMaxConcurrentRequests = 4;
+
+static NSUInteger const MJDataProviderSchedulerLaneCount = MJDataProviderSchedulerLaneBackground + 1;
+
+typedef NS_ENUM(NSInteger, MJDataProviderTicketState)
+{
+    MJDataProviderTicketStatePending,
+    MJDataProviderTicketStateRunning,
+    MJDataProviderTicketStateFinished,
+};
+
+/**
+ * Returns a monotonic timestamp in nanoseconds, not affected by changes of the system clock.
+ **/
+static uint64_t MJDataProviderSchedulerTimestamp()
+{
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
+    
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+typedef struct
+{
+    NSUInteger weight;
+    NSUInteger credit;
+    NSUInteger running;
+    NSUInteger started;
+    NSUInteger cancelled;
+    CFTimeInterval totalWait;
+    CFTimeInterval maxWait;
+} MJDataProviderSchedulerLaneState;
+
+@interface MJDataProviderScheduler ()
+
+- (void)mjz_finishTicket:(MJDataProviderTicket*)ticket cancelled:(BOOL)cancelled;
+
+@end
+
+@interface MJDataProviderTicket ()
+
+@property (nonatomic, assign, readwrite) MJDataProviderSchedulerLane lane;
+@property (nonatomic, assign, readwrite) BOOL isCancelled;
+@property (nonatomic, assign) MJDataProviderTicketState state;
+@property (nonatomic, assign) uint64_t scheduleTime;
+@property (atomic, copy) void (^block)(MJDataProviderTicket *ticket);
+@property (nonatomic, weak) MJDataProviderScheduler *scheduler;
+
+@end
+
+@implementation MJDataProviderTicket
+
+- (void)finish
+{
+    [_scheduler mjz_finishTicket:self cancelled:NO];
+}
+
+- (void)cancel
+{
+    [_scheduler mjz_finishTicket:self cancelled:YES];
+}
+
+@end
+
+#pragma mark -
+
+@implementation MJDataProviderScheduler
+{
+    NSUInteger _running;
+    NSArray <NSMutableArray <MJDataProviderTicket*>*> *_pendingTickets;
+    MJDataProviderSchedulerLaneState _lanes[MJDataProviderSchedulerLaneCount];
+}
+
++ (MJDataProviderScheduler*)sharedScheduler
+{
+    static MJDataProviderScheduler *scheduler = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        scheduler = [[MJDataProviderScheduler alloc] init];
+    });
+    return scheduler;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _maxConcurrentRequests = MJDataProviderSchedulerDefaultMaxConcurrentRequests;
+        _running = 0;
+        
+        NSMutableArray *pendingTickets = [NSMutableArray arrayWithCapacity:MJDataProviderSchedulerLaneCount];
+        NSUInteger weights[] = {8, 2, 1};
+        
+        for (NSUInteger lane = 0; lane < MJDataProviderSchedulerLaneCount; lane++)
+        {
+            [pendingTickets addObject:[NSMutableArray array]];
+            
+            memset(&_lanes[lane], 0, sizeof(MJDataProviderSchedulerLaneState));
+            _lanes[lane].weight = weights[lane];
+            _lanes[lane].credit = weights[lane];
+        }
+        
+        _pendingTickets = pendingTickets;
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (void)setMaxConcurrentRequests:(NSUInteger)maxConcurrentRequests
+{
+    NSArray *tickets = nil;
+    
+    @synchronized(self)
+    {
+        _maxConcurrentRequests = maxConcurrentRequests;
+        tickets = [self mjz_dequeueTickets];
+    }
+    
+    [self mjz_startTickets:tickets synchronously:NO];
+}
+
+- (NSUInteger)weightForLane:(MJDataProviderSchedulerLane)lane
+{
+    @synchronized(self)
+    {
+        return _lanes[lane].weight;
+    }
+}
+
+- (void)setWeight:(NSUInteger)weight forLane:(MJDataProviderSchedulerLane)lane
+{
+    @synchronized(self)
+    {
+        _lanes[lane].weight = MAX(weight, 1);
+        _lanes[lane].credit = MIN(_lanes[lane].credit, _lanes[lane].weight);
+    }
+}
+
+#pragma mark Public Methods
+
+- (MJDataProviderTicket*)scheduleBlock:(void (^)(MJDataProviderTicket *ticket))block lane:(MJDataProviderSchedulerLane)lane
+{
+    MJDataProviderTicket *ticket = [[MJDataProviderTicket alloc] init];
+    ticket.lane = lane;
+    ticket.block = block;
+    ticket.scheduler = self;
+    ticket.state = MJDataProviderTicketStatePending;
+    ticket.scheduleTime = MJDataProviderSchedulerTimestamp();
+    
+    NSArray *tickets = nil;
+    
+    @synchronized(self)
+    {
+        [_pendingTickets[lane] addObject:ticket];
+        tickets = [self mjz_dequeueTickets];
+    }
+    
+    // The scheduled ticket starts in the calling thread, any other one asynchronously.
+    NSMutableArray *otherTickets = [tickets mutableCopy];
+    if ([otherTickets indexOfObjectIdenticalTo:ticket] != NSNotFound)
+    {
+        [otherTickets removeObjectIdenticalTo:ticket];
+        [self mjz_startTickets:otherTickets synchronously:NO];
+        [self mjz_startTickets:@[ticket] synchronously:YES];
+    }
+    else
+    {
+        [self mjz_startTickets:otherTickets synchronously:NO];
+    }
+    
+    return ticket;
+}
+
+- (NSDictionary*)statistics
+{
+    NSArray *names = @[@"visible", @"prefetch", @"background"];
+    NSMutableDictionary *statistics = [NSMutableDictionary dictionary];
+    
+    @synchronized(self)
+    {
+        for (NSUInteger lane = 0; lane < MJDataProviderSchedulerLaneCount; lane++)
+        {
+            MJDataProviderSchedulerLaneState state = _lanes[lane];
+            
+            statistics[names[lane]] = @{@"queue_depth": @(_pendingTickets[lane].count),
+                                        @"in_flight": @(state.running),
+                                        @"started": @(state.started),
+                                        @"cancelled": @(state.cancelled),
+                                        @"average_wait": @(state.started > 0 ? state.totalWait / state.started : 0),
+                                        @"max_wait": @(state.maxWait),
+                                        };
+        }
+    }
+    
+    return statistics;
+}
+
+- (void)resetStatistics
+{
+    @synchronized(self)
+    {
+        for (NSUInteger lane = 0; lane < MJDataProviderSchedulerLaneCount; lane++)
+        {
+            _lanes[lane].started = 0;
+            _lanes[lane].cancelled = 0;
+            _lanes[lane].totalWait = 0;
+            _lanes[lane].maxWait = 0;
+        }
+    }
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_finishTicket:(MJDataProviderTicket*)ticket cancelled:(BOOL)cancelled
+{
+    NSArray *tickets = nil;
+    
+    @synchronized(self)
+    {
+        if (ticket.state == MJDataProviderTicketStateFinished)
+            return;
+        
+        if (ticket.state == MJDataProviderTicketStatePending)
+        {
+            [_pendingTickets[ticket.lane] removeObjectIdenticalTo:ticket];
+        }
+        else
+        {
+            _running--;
+            _lanes[ticket.lane].running--;
+        }
+        
+        if (cancelled)
+        {
+            ticket.isCancelled = YES;
+            _lanes[ticket.lane].cancelled++;
+        }
+        
+        ticket.state = MJDataProviderTicketStateFinished;
+        ticket.block = nil;
+        
+        tickets = [self mjz_dequeueTickets];
+    }
+    
+    [self mjz_startTickets:tickets synchronously:NO];
+}
+
+- (NSArray*)mjz_dequeueTickets
+{
+    NSMutableArray *tickets = [NSMutableArray array];
+    
+    while (_running < _maxConcurrentRequests)
+    {
+        NSInteger lane = [self mjz_nextLane];
+        if (lane == NSNotFound)
+            break;
+        
+        MJDataProviderTicket *ticket = _pendingTickets[lane].firstObject;
+        [_pendingTickets[lane] removeObjectAtIndex:0];
+        
+        CFTimeInterval wait = (CFTimeInterval)(MJDataProviderSchedulerTimestamp() - ticket.scheduleTime) / NSEC_PER_SEC;
+        
+        _lanes[lane].credit--;
+        _lanes[lane].running++;
+        _lanes[lane].started++;
+        _lanes[lane].totalWait += wait;
+        _lanes[lane].maxWait = MAX(_lanes[lane].maxWait, wait);
+        _running++;
+        
+        ticket.state = MJDataProviderTicketStateRunning;
+        [tickets addObject:ticket];
+    }
+    
+    return tickets;
+}
+
+- (NSInteger)mjz_nextLane
+{
+    // Weighted round-robin: lanes with pending tickets are served by priority while they have credit.
+    // Once all of them run out of credit, a new round starts.
+    for (NSInteger round = 0; round < 2; round++)
+    {
+        BOOL pending = NO;
+        
+        for (NSUInteger lane = 0; lane < MJDataProviderSchedulerLaneCount; lane++)
+        {
+            if (_pendingTickets[lane].count == 0)
+                continue;
+            
+            pending = YES;
+            
+            if (_lanes[lane].credit > 0)
+                return lane;
+        }
+        
+        if (!pending)
+            return NSNotFound;
+        
+        for (NSUInteger lane = 0; lane < MJDataProviderSchedulerLaneCount; lane++)
+            _lanes[lane].credit = _lanes[lane].weight;
+    }
+    
+    return NSNotFound;
+}
+
+- (void)mjz_startTickets:(NSArray <MJDataProviderTicket*> *)tickets synchronously:(BOOL)synchronously
+{
+    long priorities[] = {DISPATCH_QUEUE_PRIORITY_HIGH, DISPATCH_QUEUE_PRIORITY_DEFAULT, DISPATCH_QUEUE_PRIORITY_LOW};
+    
+    for (MJDataProviderTicket *ticket in tickets)
+    {
+        void (^block)(MJDataProviderTicket *ticket) = ticket.block;
+        ticket.block = nil;
+        
+        if (!block)
+            continue;
+        
+        if (synchronously)
+        {
+            block(ticket);
+        }
+        else
+        {
+            dispatch_async(dispatch_get_global_queue(priorities[ticket.lane], 0), ^{
+                block(ticket);
+            });
+        }
+    }
+}
+
+@end
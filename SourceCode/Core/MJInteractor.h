@@ -23,25 +23,137 @@
 extern void MJInteractorBegin(MJInteractor *interactor, void (^block)());
 extern void MJInteractorEnd(MJInteractor *interactor, void (^block)());
 
+extern NSString * const MJInteractorErrorDomain;
+extern NSInteger const MJInteractorCancelledErrorCode;
+extern NSInteger const MJInteractorTimeoutErrorCode;
+
+/**
+ * Priorities of interactor jobs.
+ * @discussion Pending jobs with higher priority are started first. Each priority is executed on a queue targeting the global queue of the same priority.
+ **/
+typedef NS_ENUM(NSInteger, MJInteractorPriority)
+{
+    MJInteractorPriorityLow,
+    MJInteractorPriorityDefault,
+    MJInteractorPriorityHigh,
+};
+
+/**
+ * Concurrency policies of interactor jobs.
+ **/
+typedef NS_ENUM(NSInteger, MJInteractorConcurrencyPolicy)
+{
+    /** One job at a time for all instances of the interactor class. */
+    MJInteractorConcurrencyPolicySerial,
+    
+    /** Up to `maxConcurrentJobs` jobs at a time for all instances of the interactor class. */
+    MJInteractorConcurrencyPolicyBoundedParallel,
+    
+    /** One job at a time for each `serialKey`, up to `maxConcurrentJobs` jobs at a time in total. */
+    MJInteractorConcurrencyPolicyKeyedSerial,
+};
+
 /**
  * Interactor superclass
+ * @discussion A job starts with `begin:` and finishes when its `end:` block has been executed in the main queue. Jobs waiting for their turn don't block any thread.
  **/
 @interface MJInteractor : NSObject
 
 /**
- * The dispatch queue.
+ * The concurrency policy of the interactor class. Default value is `MJInteractorConcurrencyPolicySerial`.
+ * @discussion Override it in subclasses to change the policy.
+ **/
++ (MJInteractorConcurrencyPolicy)concurrencyPolicy;
+
+/**
+ * The maximum number of jobs running at the same time for non-serial policies. Default value is 4.
+ * @discussion Override it in subclasses to change the limit.
+ **/
++ (NSUInteger)maxConcurrentJobs;
+
+/**
+ * If YES, `end:` blocks called from background threads are gathered and executed in batches, once per main run loop turn, instead of each one being dispatched to the main queue. Default value is NO.
+ * @discussion Each batch runs for at most `mainThreadDeliveryBudget`. Remaining blocks are executed in the next run loop turn.
+ **/
++ (BOOL)coalescesMainThreadDelivery;
+
+/**
+ * The maximum time spent executing a batch of `end:` blocks. Default value is 4 milliseconds.
+ **/
++ (NSTimeInterval)mainThreadDeliveryBudget;
+
+/**
+ * Sets the maximum time spent executing a batch of `end:` blocks. Shared by all interactor classes.
+ **/
++ (void)setMainThreadDeliveryBudget:(NSTimeInterval)budget;
+
+/**
+ * The key used to serialize jobs with the `MJInteractorConcurrencyPolicyKeyedSerial` policy. Default value is nil.
+ * @discussion Override it in subclasses to return the resource the interactor operates on. Jobs with a nil key are not serialized.
+ **/
+- (NSString*)serialKey;
+
+/**
+ * The dispatch queue where jobs are executed.
+ * @discussion A serial queue for the `MJInteractorConcurrencyPolicySerial` policy, a concurrent queue otherwise. Shared by all instances of the interactor class.
  **/
 @property (nonatomic, strong, readonly) dispatch_queue_t queue;
 
+/**
+ * The priority of the jobs begun from now on. Default value is `MJInteractorPriorityDefault`.
+ **/
+@property (nonatomic, assign) MJInteractorPriority priority;
+
+/**
+ * The maximum time a job can wait before being started. Jobs not started in time are dropped. Default value is 0 (no timeout).
+ **/
+@property (nonatomic, assign) NSTimeInterval timeout;
+
+/**
+ * If YES, beginning a job while another job of this interactor is still pending replaces the block of the pending job instead of enqueueing a new one. Default value is NO.
+ * @discussion Use it together with `setNeedsRefresh`, so several refresh requests result in a single job.
+ **/
+@property (nonatomic, assign) BOOL coalescesPendingJobs;
+
 /**
  * Executes a block in a background queue.
- * @discussion A `begin` call must be in corresponded to a `end` call.
+ * @discussion A `begin` call must be in corresponded to a `end` call. The block is executed when the concurrency policy allows it.
  **/
 - (void)begin:(void (^)())block;
 
+/**
+ * Executes a block in a background queue.
+ * @param block The job block.
+ * @param cancelledBlock A block executed in the main queue if the job is dropped before being started, either by calling `cancel` or because of the `timeout`. The error uses the `MJInteractorErrorDomain` domain.
+ * @discussion A `begin` call must be in corresponded to a `end` call, unless the job is dropped.
+ **/
+- (void)begin:(void (^)())block cancelled:(void (^)(NSError *error))cancelledBlock;
+
+/**
+ * Executes a job shared by all the concurrent callers with the same key (single-flight).
+ * @param block The job block, executed in a background queue. Call `complete` once with the result of the job instead of calling `end:`.
+ * @param key The request key. Callers of the same interactor class with the same key attach to the job in flight instead of starting a new one. If nil, the job is not shared.
+ * @param endBlock A block executed in the main queue with the result of the job. If the caller stops waiting because of `cancel` or the `timeout` of this interactor, the result is nil and the error is set.
+ * @discussion `cancel` and the `timeout` only detach the callers of the interactor they belong to, the other callers keep waiting for the result. The shared job is dropped (or flagged as cancelled, if running) once no caller is left.
+ **/
+- (void)begin:(void (^)(void (^complete)(id result, NSError *error)))block
+       forKey:(NSString*)key
+          end:(void (^)(id result, NSError *error))endBlock;
+
+/**
+ * Cancels the jobs of the interactor.
+ * @discussion Pending jobs are dropped. Running jobs are flagged as cancelled (see `isCancelled`) and must still call `end:`. Callers of shared jobs (see `begin:forKey:end:`) stop waiting for their result.
+ **/
+- (void)cancel;
+
+/**
+ * Returns YES if the running job has been cancelled. Check it from the job block to stop doing unnecessary work.
+ **/
+@property (nonatomic, assign, readonly) BOOL isCancelled;
+
 /**
  * Executes a block in the main queue.
- * @discussion A `begin` call must be in corresponded to a `end` call.
+ * @discussion A `begin` call must be in corresponded to a `end` call. Finishes the oldest running job of the interactor once the block is executed.
  **/
 - (void)end:(void (^)())block;
 
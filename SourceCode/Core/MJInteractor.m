@@ -16,7 +16,18 @@
 
 #import "MJInteractor.h"
 
-static NSMutableDictionary *_interactorDispatchQueues;
+#import <pthread.h>
+
+#import "MJInteractorMetrics.h"
+
+static NSMutableDictionary *_interactorLanes;
+static NSMutableDictionary *_interactorFlights;
+static NSTimeInterval _mainThreadDeliveryBudget = 0.004;
+
+NSString * const MJInteractorErrorDomain = @"com.mobilejazz.core.interactor";
+
+NSInteger const MJInteractorCancelledErrorCode  = 1;
+NSInteger const MJInteractorTimeoutErrorCode    = 2;
 
 void MJInteractorBegin(MJInteractor *interactor, void (^block)())
 {
@@ -32,77 +43,866 @@ void MJInteractorEnd(MJInteractor *interactor, void (^block)())
     }];
 }
 
+typedef NS_ENUM(NSInteger, MJInteractorJobState)
+{
+    MJInteractorJobStatePending,
+    MJInteractorJobStateRunning,
+    MJInteractorJobStateFinished,
+    MJInteractorJobStateDropped,
+};
+
+static NSUInteger const MJInteractorPriorityCount = MJInteractorPriorityHigh + 1;
+
+/**
+ * A job started with `begin:`.
+ **/
+@interface MJInteractorJob : NSObject
+
+@property (nonatomic, copy) void (^block)();
+@property (nonatomic, copy) void (^cancelledBlock)(NSError *error);
+@property (nonatomic, strong) NSString *key;
+@property (nonatomic, assign) MJInteractorPriority priority;
+@property (nonatomic, assign) uint64_t deadline;
+@property (nonatomic, assign) MJInteractorJobState state;
+@property (nonatomic, assign) BOOL cancelled;
+@property (nonatomic, assign) BOOL shared;
+
+@property (nonatomic, assign) uint64_t enqueueTime;
+@property (nonatomic, assign) uint64_t startTime;
+@property (nonatomic, assign) uint64_t endTime;
+@property (nonatomic, assign) uint64_t deliveryTime;
+@property (nonatomic, assign) uint32_t threadIdentifier;
+
+@end
+
+@implementation MJInteractorJob
+
+@end
+
+/**
+ * Admission queue of the jobs of an interactor class.
+ * @discussion Jobs are admitted by priority and then in FIFO order as long as the concurrency policy allows it. Jobs skipped because their key is busy keep their position.
+ **/
+@interface MJInteractorLane : NSObject
+
+- (id)initWithName:(NSString*)name policy:(MJInteractorConcurrencyPolicy)policy maxConcurrentJobs:(NSUInteger)maxConcurrentJobs metrics:(MJInteractorClassMetrics*)metrics;
+
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, assign, readonly) MJInteractorConcurrencyPolicy policy;
+
+- (void)enqueueJob:(MJInteractorJob*)job;
+- (void)finishJob:(MJInteractorJob*)job;
+- (BOOL)coalesceJob:(MJInteractorJob*)job withBlock:(void (^)())block priority:(MJInteractorPriority)priority;
+- (void)dropJob:(MJInteractorJob*)job errorCode:(NSInteger)code;
+
+@end
+
+@implementation MJInteractorLane
+{
+    NSUInteger _maxConcurrentJobs;
+    NSUInteger _runningCount;
+    NSArray <NSMutableArray <MJInteractorJob*>*> *_pendingJobs;
+    NSArray <dispatch_queue_t> *_queues;
+    NSMutableSet <NSString*> *_runningKeys;
+    MJInteractorClassMetrics *_metrics;
+}
+
+- (id)initWithName:(NSString*)name policy:(MJInteractorConcurrencyPolicy)policy maxConcurrentJobs:(NSUInteger)maxConcurrentJobs metrics:(MJInteractorClassMetrics*)metrics
+{
+    self = [super init];
+    if (self)
+    {
+        _policy = policy;
+        _metrics = metrics;
+        _maxConcurrentJobs = policy == MJInteractorConcurrencyPolicySerial ? 1 : MAX(maxConcurrentJobs, 1);
+        _runningCount = 0;
+        _runningKeys = [NSMutableSet set];
+        
+        dispatch_queue_attr_t attributes = policy == MJInteractorConcurrencyPolicySerial ? DISPATCH_QUEUE_SERIAL : DISPATCH_QUEUE_CONCURRENT;
+        long globalPriorities[] = {DISPATCH_QUEUE_PRIORITY_LOW, DISPATCH_QUEUE_PRIORITY_DEFAULT, DISPATCH_QUEUE_PRIORITY_HIGH};
+        
+        NSMutableArray *pendingJobs = [NSMutableArray arrayWithCapacity:MJInteractorPriorityCount];
+        NSMutableArray *queues = [NSMutableArray arrayWithCapacity:MJInteractorPriorityCount];
+        
+        for (NSUInteger priority = 0; priority < MJInteractorPriorityCount; priority++)
+        {
+            NSString *queueName = priority == MJInteractorPriorityDefault ? name : [NSString stringWithFormat:@"%@.%@", name, priority == MJInteractorPriorityHigh ? @"high" : @"low"];
+            dispatch_queue_t queue = dispatch_queue_create([queueName cStringUsingEncoding:NSUTF8StringEncoding], attributes);
+            dispatch_set_target_queue(queue, dispatch_get_global_queue(globalPriorities[priority], 0));
+            
+            [queues addObject:queue];
+            [pendingJobs addObject:[NSMutableArray array]];
+        }
+        
+        _queues = queues;
+        _pendingJobs = pendingJobs;
+        _queue = _queues[MJInteractorPriorityDefault];
+    }
+    return self;
+}
+
+- (void)enqueueJob:(MJInteractorJob*)job
+{
+    job.enqueueTime = MJInteractorMetricsTimestamp();
+    
+    @synchronized(self)
+    {
+        [_pendingJobs[job.priority] addObject:job];
+        [self mjz_dequeueJobs];
+    }
+}
+
+- (void)finishJob:(MJInteractorJob*)job
+{
+    @synchronized(self)
+    {
+        if (job.state != MJInteractorJobStateRunning)
+            return;
+        
+        job.state = MJInteractorJobStateFinished;
+        
+        [_metrics recordJobWithEnqueueTime:job.enqueueTime startTime:job.startTime endTime:job.endTime deliveryTime:job.deliveryTime threadIdentifier:job.threadIdentifier];
+        [_metrics endSignpostWithIdentifier:(__bridge const void*)job];
+        
+        _runningCount--;
+        if (job.key)
+            [_runningKeys removeObject:job.key];
+        
+        [self mjz_dequeueJobs];
+    }
+}
+
+- (BOOL)coalesceJob:(MJInteractorJob*)job withBlock:(void (^)())block priority:(MJInteractorPriority)priority
+{
+    @synchronized(self)
+    {
+        if (job.state != MJInteractorJobStatePending)
+            return NO;
+        
+        job.block = block;
+        
+        // Only raising the priority, so the job doesn't lose its turn.
+        if (priority > job.priority)
+        {
+            [_pendingJobs[job.priority] removeObjectIdenticalTo:job];
+            job.priority = priority;
+            [_pendingJobs[job.priority] addObject:job];
+            [self mjz_dequeueJobs];
+        }
+        
+        return YES;
+    }
+}
+
+- (void)dropJob:(MJInteractorJob*)job errorCode:(NSInteger)code
+{
+    @synchronized(self)
+    {
+        if (job.state != MJInteractorJobStatePending)
+            return;
+        
+        [_pendingJobs[job.priority] removeObjectIdenticalTo:job];
+        [self mjz_dropJob:job errorCode:code];
+    }
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_dequeueJobs
+{
+    // Monotonic, so changes of the wall clock don't expire jobs early or keep them forever.
+    uint64_t now = MJInteractorMetricsTimestamp();
+    
+    for (NSInteger priority = MJInteractorPriorityHigh; priority >= MJInteractorPriorityLow; priority--)
+    {
+        NSMutableArray <MJInteractorJob*> *pendingJobs = _pendingJobs[priority];
+        NSUInteger index = 0;
+        
+        while (_runningCount < _maxConcurrentJobs && index < pendingJobs.count)
+        {
+            MJInteractorJob *job = pendingJobs[index];
+            
+            if (job.deadline > 0 && job.deadline < now)
+            {
+                [pendingJobs removeObjectAtIndex:index];
+                [self mjz_dropJob:job errorCode:MJInteractorTimeoutErrorCode];
+                continue;
+            }
+            
+            if (job.key && [_runningKeys containsObject:job.key])
+            {
+                index++;
+                continue;
+            }
+            
+            [pendingJobs removeObjectAtIndex:index];
+            
+            job.state = MJInteractorJobStateRunning;
+            
+            _runningCount++;
+            if (job.key)
+                [_runningKeys addObject:job.key];
+            
+            void (^block)() = job.block;
+            MJInteractorClassMetrics *metrics = _metrics;
+            
+            dispatch_async(_queues[job.priority], ^{
+                job.startTime = MJInteractorMetricsTimestamp();
+                job.threadIdentifier = pthread_mach_thread_np(pthread_self());
+                [metrics beginSignpostWithIdentifier:(__bridge const void*)job];
+                block();
+            });
+        }
+    }
+}
+
+- (void)mjz_dropJob:(MJInteractorJob*)job errorCode:(NSInteger)code
+{
+    job.state = MJInteractorJobStateDropped;
+    
+    void (^cancelledBlock)(NSError *error) = job.cancelledBlock;
+    job.block = nil;
+    job.cancelledBlock = nil;
+    
+    if (cancelledBlock)
+    {
+        NSError *error = [NSError errorWithDomain:MJInteractorErrorDomain code:code userInfo:nil];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            cancelledBlock(error);
+        });
+    }
+}
+
+@end
+
+/**
+ * Executes blocks in the main thread in batches, one batch per run loop turn.
+ **/
+@interface MJInteractorDeliveryQueue : NSObject
+
++ (MJInteractorDeliveryQueue*)sharedQueue;
+
+- (void)enqueueBlock:(void (^)())block;
+
+@end
+
+@implementation MJInteractorDeliveryQueue
+{
+    NSMutableArray *_blocks;
+    BOOL _scheduled;
+}
+
++ (MJInteractorDeliveryQueue*)sharedQueue
+{
+    static MJInteractorDeliveryQueue *queue = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = [[MJInteractorDeliveryQueue alloc] init];
+    });
+    return queue;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _blocks = [NSMutableArray array];
+        _scheduled = NO;
+    }
+    return self;
+}
+
+- (void)enqueueBlock:(void (^)())block
+{
+    @synchronized(self)
+    {
+        [_blocks addObject:[block copy]];
+        
+        if (!_scheduled)
+        {
+            _scheduled = YES;
+            [self mjz_scheduleDrain];
+        }
+    }
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_scheduleDrain
+{
+    // Blocks performed in the run loop are executed once per turn, unlike the main queue, which is drained
+    // while new blocks keep arriving. Common modes, so deliveries continue while scrolling.
+    CFRunLoopRef runLoop = CFRunLoopGetMain();
+    CFRunLoopPerformBlock(runLoop, kCFRunLoopCommonModes, ^{
+        [self mjz_drain];
+    });
+    CFRunLoopWakeUp(runLoop);
+}
+
+- (void)mjz_drain
+{
+    NSArray *blocks = nil;
+    
+    @synchronized(self)
+    {
+        blocks = [_blocks copy];
+        [_blocks removeAllObjects];
+    }
+    
+    NSTimeInterval budget;
+    @synchronized([MJInteractor class])
+    {
+        budget = _mainThreadDeliveryBudget;
+    }
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSUInteger index = 0;
+    
+    // At least one block is executed on each turn.
+    while (index < blocks.count)
+    {
+        void (^block)() = blocks[index++];
+        block();
+        
+        if (CFAbsoluteTimeGetCurrent() - start > budget)
+            break;
+    }
+    
+    @synchronized(self)
+    {
+        if (index < blocks.count)
+        {
+            // Roll over, keeping the order before blocks enqueued meanwhile.
+            NSRange range = NSMakeRange(index, blocks.count - index);
+            [_blocks insertObjects:[blocks subarrayWithRange:range] atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, range.length)]];
+        }
+        
+        if (_blocks.count > 0)
+            [self mjz_scheduleDrain];
+        else
+            _scheduled = NO;
+    }
+}
+
+@end
+
+@class MJInteractorFlight;
+
+/**
+ * A caller waiting for the result of a flight.
+ **/
+@interface MJInteractorFlightSubscriber : NSObject
+
+@property (nonatomic, copy) void (^endBlock)(id result, NSError *error);
+@property (nonatomic, strong) MJInteractorFlight *flight;
+
+@end
+
+@implementation MJInteractorFlightSubscriber
+
+@end
+
+/**
+ * A job shared by all the callers with the same key.
+ * @discussion Access it synchronized on `_interactorFlights`. Once landed, the flight has no subscribers and the key is free for a new flight.
+ **/
+@interface MJInteractorFlight : NSObject
+
+- (id)initWithKey:(NSString*)key;
+
+@property (nonatomic, strong, readonly) NSString *key;
+@property (nonatomic, strong) MJInteractorJob *job;
+@property (nonatomic, strong) MJInteractorLane *lane;
+@property (nonatomic, assign, readonly) BOOL landed;
+@property (nonatomic, assign) BOOL completed;
+
+- (MJInteractorFlightSubscriber*)addSubscriberWithEndBlock:(void (^)(id result, NSError *error))endBlock;
+- (BOOL)removeSubscriber:(MJInteractorFlightSubscriber*)subscriber;
+- (NSArray <MJInteractorFlightSubscriber*>*)land;
+
+@end
+
+@implementation MJInteractorFlight
+{
+    NSMutableArray <MJInteractorFlightSubscriber*> *_subscribers;
+}
+
+- (id)initWithKey:(NSString*)key
+{
+    self = [super init];
+    if (self)
+    {
+        _key = key;
+        _subscribers = [NSMutableArray array];
+        _landed = NO;
+        _completed = NO;
+    }
+    return self;
+}
+
+- (MJInteractorFlightSubscriber*)addSubscriberWithEndBlock:(void (^)(id result, NSError *error))endBlock
+{
+    MJInteractorFlightSubscriber *subscriber = [[MJInteractorFlightSubscriber alloc] init];
+    subscriber.endBlock = endBlock;
+    subscriber.flight = self;
+    
+    [_subscribers addObject:subscriber];
+    
+    return subscriber;
+}
+
+- (BOOL)removeSubscriber:(MJInteractorFlightSubscriber*)subscriber
+{
+    subscriber.flight = nil;
+    [_subscribers removeObjectIdenticalTo:subscriber];
+    
+    if (_subscribers.count > 0)
+        return NO;
+    
+    // Nobody waits for the result anymore.
+    [self land];
+    return YES;
+}
+
+- (NSArray <MJInteractorFlightSubscriber*>*)land
+{
+    if (_landed)
+        return @[];
+    
+    _landed = YES;
+    
+    // Later callers start a new flight. The key may already belong to a newer flight.
+    if (_key && _interactorFlights[_key] == self)
+        [_interactorFlights removeObjectForKey:_key];
+    
+    NSArray *subscribers = [_subscribers copy];
+    [_subscribers removeAllObjects];
+    
+    // The job blocks retain the flight.
+    _job = nil;
+    
+    for (MJInteractorFlightSubscriber *subscriber in subscribers)
+        subscriber.flight = nil;
+    
+    return subscribers;
+}
+
+@end
+
+/**
+ * Stops waiting for the result of a flight, calling the end block of the subscriber with an error. The shared job is dropped if it was the last subscriber.
+ **/
+static void MJInteractorFlightDetach(MJInteractorFlightSubscriber *subscriber, NSInteger code)
+{
+    MJInteractorFlight *flight = nil;
+    MJInteractorJob *abandonedJob = nil;
+    
+    @synchronized(_interactorFlights)
+    {
+        flight = subscriber.flight;
+        if (!flight)
+            return;
+        
+        // As for any job, the timeout only applies until the job is started.
+        if (code == MJInteractorTimeoutErrorCode && flight.job.state != MJInteractorJobStatePending)
+            return;
+        
+        MJInteractorJob *job = flight.job;
+        if ([flight removeSubscriber:subscriber])
+            abandonedJob = job;
+    }
+    
+    void (^endBlock)(id result, NSError *error) = subscriber.endBlock;
+    subscriber.endBlock = nil;
+    
+    if (endBlock)
+    {
+        NSError *error = [NSError errorWithDomain:MJInteractorErrorDomain code:code userInfo:nil];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            endBlock(nil, error);
+        });
+    }
+    
+    if (abandonedJob)
+    {
+        abandonedJob.cancelled = YES;
+        [flight.lane dropJob:abandonedJob errorCode:code];
+    }
+}
+
 @implementation MJInteractor
 {
-    dispatch_semaphore_t _semaphore;
+    MJInteractorLane *_lane;
+    NSMutableArray <MJInteractorJob*> *_jobs;
+    NSMutableArray <MJInteractorFlightSubscriber*> *_subscribers;
 }
 
 + (void)initialize
 {
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        _interactorDispatchQueues = [[NSMutableDictionary alloc] init];
+        _interactorLanes = [[NSMutableDictionary alloc] init];
+        _interactorFlights = [[NSMutableDictionary alloc] init];
     });
 }
 
++ (MJInteractorConcurrencyPolicy)concurrencyPolicy
+{
+    return MJInteractorConcurrencyPolicySerial;
+}
+
++ (NSUInteger)maxConcurrentJobs
+{
+    return 4;
+}
+
++ (BOOL)coalescesMainThreadDelivery
+{
+    return NO;
+}
+
++ (NSTimeInterval)mainThreadDeliveryBudget
+{
+    @synchronized([MJInteractor class])
+    {
+        return _mainThreadDeliveryBudget;
+    }
+}
+
++ (void)setMainThreadDeliveryBudget:(NSTimeInterval)budget
+{
+    @synchronized([MJInteractor class])
+    {
+        _mainThreadDeliveryBudget = budget;
+    }
+}
+
 - (id)init
 {
     self = [super init];
     if (self)
     {
         _refresh = NO;
+        _priority = MJInteractorPriorityDefault;
+        _timeout = 0;
+        _coalescesPendingJobs = NO;
+        _jobs = [NSMutableArray array];
+        _subscribers = [NSMutableArray array];
         
         NSString *className = NSStringFromClass(self.class);
         NSString *queueName = [NSString stringWithFormat:@"com.mobilejazz.core.interacor.%@", className];
         
-        @synchronized(_interactorDispatchQueues)
+        @synchronized(_interactorLanes)
         {
-            dispatch_queue_t queue = _interactorDispatchQueues[queueName];
-            if (!queue)
+            MJInteractorLane *lane = _interactorLanes[queueName];
+            if (!lane)
             {
-                queue = dispatch_queue_create([queueName cStringUsingEncoding:NSUTF8StringEncoding], DISPATCH_QUEUE_SERIAL);
-                _interactorDispatchQueues[queueName] = queue;
+                lane = [[MJInteractorLane alloc] initWithName:queueName
+                                                       policy:[self.class concurrencyPolicy]
+                                            maxConcurrentJobs:[self.class maxConcurrentJobs]
+                                                      metrics:[[MJInteractorMetrics sharedMetrics] metricsForClassName:className]];
+                _interactorLanes[queueName] = lane;
             }
             
-            _queue = queue;
+            _lane = lane;
         }
     }
     return self;
 }
 
+- (dispatch_queue_t)queue
+{
+    return _lane.queue;
+}
+
+- (NSString*)serialKey
+{
+    return nil;
+}
 
 - (void)begin:(void (^)())block
 {
-    dispatch_async(self.queue, ^{
-        _semaphore = dispatch_semaphore_create(0);
-        block();
-        dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
-    });
+    [self begin:block cancelled:nil];
+}
+
+- (void)begin:(void (^)())block cancelled:(void (^)(NSError *error))cancelledBlock
+{
+    [self mjz_begin:block cancelled:cancelledBlock coalesce:_coalescesPendingJobs shared:NO];
 }
 
 - (void)end:(void (^)())block
 {
+    MJInteractorJob *job = nil;
+    
+    @synchronized(_jobs)
+    {
+        [self mjz_removeDroppedJobs];
+        
+        for (MJInteractorJob *runningJob in _jobs)
+        {
+            if (runningJob.state == MJInteractorJobStateRunning)
+            {
+                job = runningJob;
+                [_jobs removeObject:runningJob];
+                break;
+            }
+        }
+    }
+    
+    MJInteractorLane *lane = _lane;
+    job.endTime = MJInteractorMetricsTimestamp();
+    
     if ([NSThread isMainThread])
     {
+        job.deliveryTime = job.endTime;
         block();
-        if (_semaphore != NULL)
-            dispatch_semaphore_signal(_semaphore);
+        if (job)
+            [lane finishJob:job];
     }
     else
     {
-        dispatch_async(dispatch_get_main_queue(), ^{
+        void (^delivery)() = ^{
+            job.deliveryTime = MJInteractorMetricsTimestamp();
             block();
-            if (_semaphore != NULL)
-                dispatch_semaphore_signal(_semaphore);
-        });
+            if (job)
+                [lane finishJob:job];
+        };
+        
+        if ([self.class coalescesMainThreadDelivery])
+            [[MJInteractorDeliveryQueue sharedQueue] enqueueBlock:delivery];
+        else
+            dispatch_async(dispatch_get_main_queue(), delivery);
     }
     
     _refresh = NO;
 }
 
+- (void)begin:(void (^)(void (^complete)(id result, NSError *error)))block
+       forKey:(NSString*)key
+          end:(void (^)(id result, NSError *error))endBlock
+{
+    NSString *flightKey = key ? [NSString stringWithFormat:@"%@.%@", NSStringFromClass(self.class), key] : nil;
+    MJInteractorFlight *flight = nil;
+    MJInteractorFlightSubscriber *subscriber = nil;
+    BOOL attached = NO;
+    
+    @synchronized(_interactorFlights)
+    {
+        [self mjz_removeLandedSubscribers];
+        
+        flight = flightKey ? _interactorFlights[flightKey] : nil;
+        attached = flight != nil;
+        
+        if (!flight)
+        {
+            flight = [[MJInteractorFlight alloc] initWithKey:flightKey];
+            flight.lane = _lane;
+            
+            if (flightKey)
+                _interactorFlights[flightKey] = flight;
+        }
+        
+        subscriber = [flight addSubscriberWithEndBlock:endBlock];
+        [_subscribers addObject:subscriber];
+    }
+    
+    if (!attached)
+    {
+        MJInteractorJob *job = [self mjz_begin:^{
+            block(^(id result, NSError *error) {
+                NSArray *subscribers = nil;
+                
+                @synchronized(_interactorFlights)
+                {
+                    // Only the first completion ends the job, further calls are ignored.
+                    if (flight.completed)
+                        return;
+                    
+                    flight.completed = YES;
+                    subscribers = [flight land];
+                }
+                
+                // Also without subscribers, so the job is finished.
+                [self end:^{
+                    for (MJInteractorFlightSubscriber *subscriber in subscribers)
+                    {
+                        if (subscriber.endBlock)
+                            subscriber.endBlock(result, error);
+                    }
+                }];
+            });
+        } cancelled:^(NSError *error) {
+            NSArray *subscribers = nil;
+            
+            @synchronized(_interactorFlights)
+            {
+                subscribers = [flight land];
+            }
+            
+            for (MJInteractorFlightSubscriber *subscriber in subscribers)
+            {
+                if (subscriber.endBlock)
+                    subscriber.endBlock(nil, error);
+            }
+        } coalesce:NO shared:YES];
+        
+        BOOL abandoned = NO;
+        
+        @synchronized(_interactorFlights)
+        {
+            if (flight.landed)
+                abandoned = !flight.completed;
+            else
+                flight.job = job;
+        }
+        
+        // All the subscribers left before the job was known.
+        if (abandoned)
+        {
+            job.cancelled = YES;
+            [_lane dropJob:job errorCode:MJInteractorCancelledErrorCode];
+        }
+    }
+    
+    if (_timeout > 0)
+    {
+        // Each subscriber times out on its own, the job is dropped when none is left.
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_timeout * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            MJInteractorFlightDetach(subscriber, MJInteractorTimeoutErrorCode);
+        });
+    }
+}
+
+- (void)cancel
+{
+    NSArray *jobs = nil;
+    
+    @synchronized(_jobs)
+    {
+        jobs = [_jobs copy];
+        
+        for (MJInteractorJob *job in jobs)
+        {
+            // Shared jobs are dropped by their flight, once no subscriber is left.
+            if (!job.shared)
+                job.cancelled = YES;
+        }
+    }
+    
+    for (MJInteractorJob *job in jobs)
+    {
+        if (!job.shared)
+            [_lane dropJob:job errorCode:MJInteractorCancelledErrorCode];
+    }
+    
+    NSArray *subscribers = nil;
+    
+    @synchronized(_interactorFlights)
+    {
+        subscribers = [_subscribers copy];
+        [_subscribers removeAllObjects];
+    }
+    
+    for (MJInteractorFlightSubscriber *subscriber in subscribers)
+        MJInteractorFlightDetach(subscriber, MJInteractorCancelledErrorCode);
+}
+
+- (BOOL)isCancelled
+{
+    @synchronized(_jobs)
+    {
+        for (MJInteractorJob *job in _jobs)
+        {
+            if (job.state == MJInteractorJobStateRunning)
+                return job.cancelled;
+        }
+    }
+    
+    return NO;
+}
+
 - (void)setNeedsRefresh
 {
     _refresh = YES;
 }
 
+#pragma mark Private Methods
+
+- (MJInteractorJob*)mjz_begin:(void (^)())block cancelled:(void (^)(NSError *error))cancelledBlock coalesce:(BOOL)coalesce shared:(BOOL)shared
+{
+    MJInteractorPriority priority = _priority;
+    
+    if (coalesce)
+    {
+        MJInteractorJob *pendingJob = nil;
+        
+        @synchronized(_jobs)
+        {
+            for (MJInteractorJob *job in _jobs)
+            {
+                if (job.state == MJInteractorJobStatePending)
+                {
+                    pendingJob = job;
+                    break;
+                }
+            }
+        }
+        
+        if (pendingJob && [_lane coalesceJob:pendingJob withBlock:block priority:priority])
+            return pendingJob;
+    }
+    
+    MJInteractorJob *job = [[MJInteractorJob alloc] init];
+    job.block = block;
+    job.cancelledBlock = cancelledBlock;
+    job.priority = priority;
+    job.state = MJInteractorJobStatePending;
+    job.shared = shared;
+    
+    if (_lane.policy == MJInteractorConcurrencyPolicyKeyedSerial)
+        job.key = [self serialKey];
+    
+    // The subscribers of a shared job time out on their own.
+    NSTimeInterval timeout = shared ? 0 : _timeout;
+    
+    if (timeout > 0)
+        job.deadline = MJInteractorMetricsTimestamp() + (uint64_t)(timeout * NSEC_PER_SEC);
+    
+    @synchronized(_jobs)
+    {
+        [self mjz_removeDroppedJobs];
+        [_jobs addObject:job];
+    }
+    
+    [_lane enqueueJob:job];
+    
+    if (timeout > 0)
+    {
+        // Drops the job as soon as it expires, instead of waiting for its turn.
+        MJInteractorLane *lane = _lane;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [lane dropJob:job errorCode:MJInteractorTimeoutErrorCode];
+        });
+    }
+    
+    return job;
+}
+
+- (void)mjz_removeDroppedJobs
+{
+    NSIndexSet *indexes = [_jobs indexesOfObjectsPassingTest:^BOOL(MJInteractorJob *job, NSUInteger idx, BOOL *stop) {
+        return job.state == MJInteractorJobStateDropped;
+    }];
+    [_jobs removeObjectsAtIndexes:indexes];
+}
+
+- (void)mjz_removeLandedSubscribers
+{
+    NSIndexSet *indexes = [_subscribers indexesOfObjectsPassingTest:^BOOL(MJInteractorFlightSubscriber *subscriber, NSUInteger idx, BOOL *stop) {
+        return subscriber.flight == nil;
+    }];
+    [_subscribers removeObjectsAtIndexes:indexes];
+}
+
 @end
@@ -0,0 +1,147 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSUInteger const MJInteractorMetricsDefaultTraceCapacity;
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ **/
+extern uint64_t MJInteractorMetricsTimestamp();
+
+/**
+ * Latency metrics of the jobs of an interactor class.
+ * @discussion Recording is lock-free: histograms use atomic counters with power-of-two buckets in microseconds.
+ **/
+@interface MJInteractorClassMetrics : NSObject
+
+/**
+ * The interactor class name.
+ **/
+@property (nonatomic, strong, readonly) NSString *name;
+
+/**
+ * Records a finished job.
+ * @param enqueueTime The time the job was begun.
+ * @param startTime The time the job started executing.
+ * @param endTime The time `end:` was called.
+ * @param deliveryTime The time the `end:` block started executing in the main queue.
+ * @discussion Times are timestamps returned by `MJInteractorMetricsTimestamp`.
+ **/
+- (void)recordJobWithEnqueueTime:(uint64_t)enqueueTime startTime:(uint64_t)startTime endTime:(uint64_t)endTime deliveryTime:(uint64_t)deliveryTime;
+
+/**
+ * Records a finished job executed in a given thread.
+ * @param enqueueTime The time the job was begun.
+ * @param startTime The time the job started executing.
+ * @param endTime The time `end:` was called.
+ * @param deliveryTime The time the `end:` block started executing in the main queue.
+ * @param threadIdentifier The mach thread identifier of the thread the job executed in. It is the thread of the trace events.
+ * @discussion Times are timestamps returned by `MJInteractorMetricsTimestamp`. The method above uses the current thread.
+ **/
+- (void)recordJobWithEnqueueTime:(uint64_t)enqueueTime startTime:(uint64_t)startTime endTime:(uint64_t)endTime deliveryTime:(uint64_t)deliveryTime threadIdentifier:(uint32_t)threadIdentifier;
+
+/**
+ * Marks the beginning of a job in the signposts, if available.
+ * @param identifier A pointer identifying the job.
+ **/
+- (void)beginSignpostWithIdentifier:(const void*)identifier;
+
+/**
+ * Marks the end of a job in the signposts, if available.
+ * @param identifier A pointer identifying the job.
+ **/
+- (void)endSignpostWithIdentifier:(const void*)identifier;
+
+/**
+ * Returns the histograms of queue wait, execution and main queue delivery.
+ * @return A dictionary with the `queue_wait`, `execution` and `delivery` histograms. Each histogram includes the count, mean, maximum and percentiles in microseconds, and the bucket counts.
+ **/
+- (NSDictionary*)dictionaryRepresentation;
+
+@end
+
+/**
+ * Instrumentation of interactor jobs.
+ * @discussion `MJInteractor` records every job in the shared instance. Export the metrics as JSON or as a trace in the Chrome trace event format (chrome://tracing).
+ **/
+@interface MJInteractorMetrics : NSObject
+
+/**
+ * The shared metrics, used by `MJInteractor`.
+ **/
++ (MJInteractorMetrics*)sharedMetrics;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * Enables recording histograms. Default value is YES.
+ **/
+@property (nonatomic, assign) BOOL enabled;
+
+/**
+ * Enables recording trace events and signposts. Default value is NO.
+ **/
+@property (nonatomic, assign) BOOL tracingEnabled;
+
+/**
+ * The maximum number of trace events kept. Older events are overwritten. Value is `MJInteractorMetricsDefaultTraceCapacity`.
+ **/
+@property (nonatomic, assign, readonly) NSUInteger traceCapacity;
+
+/** *************************************************** **
+ * @name Recording
+ ** *************************************************** **/
+
+/**
+ * Returns the metrics of an interactor class, creating them if needed.
+ * @param name The interactor class name.
+ * @return The class metrics.
+ **/
+- (MJInteractorClassMetrics*)metricsForClassName:(NSString*)name;
+
+/**
+ * Removes all recorded metrics and trace events.
+ **/
+- (void)reset;
+
+/** *************************************************** **
+ * @name Exporting
+ ** *************************************************** **/
+
+/**
+ * Returns the histograms of all interactor classes.
+ * @return A dictionary of class metrics dictionary representations, indexed by class name.
+ **/
+- (NSDictionary*)dictionaryRepresentation;
+
+/**
+ * Returns the histograms of all interactor classes as JSON.
+ * @return The JSON data.
+ **/
+- (NSData*)JSONData;
+
+/**
+ * Returns the recorded trace events in the Chrome trace event format.
+ * @return The JSON data.
+ * @discussion Events are copied under the trace lock, so recording can continue while the JSON is built.
+ **/
+- (NSData*)chromeTraceData;
+
+@end
@@ -0,0 +1,396 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJInteractorMetrics.h"
+
+#import <mach/mach_time.h>
+#import <pthread.h>
+#import <stdatomic.h>
+
+#if __has_include(<os/signpost.h>)
+#import <os/signpost.h>
+#define MJ_INTERACTOR_METRICS_SIGNPOSTS 1
+#endif
+
+NSUInteger const MJInteractorMetricsDefaultTraceCapacity = 4096;
+
+#define MJInteractorHistogramBucketCount 32
+
+uint64_t MJInteractorMetricsTimestamp()
+{
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
+    
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+typedef struct
+{
+    atomic_llong count;
+    atomic_llong sum;
+    atomic_llong max;
+    atomic_llong buckets[MJInteractorHistogramBucketCount];
+} MJInteractorHistogram;
+
+static void MJInteractorHistogramRecord(MJInteractorHistogram *histogram, uint64_t nanoseconds)
+{
+    int64_t microseconds = (int64_t)(nanoseconds / 1000);
+    
+    // Bucket i contains values in [2^(i-1), 2^i) microseconds, bucket 0 contains values below 1 microsecond.
+    int bucket = microseconds == 0 ? 0 : MIN(64 - __builtin_clzll((uint64_t)microseconds), MJInteractorHistogramBucketCount - 1);
+    
+    atomic_fetch_add(&histogram->buckets[bucket], 1);
+    atomic_fetch_add(&histogram->count, 1);
+    atomic_fetch_add(&histogram->sum, microseconds);
+    
+    // On failure, max is reloaded with the current value.
+    long long max = atomic_load(&histogram->max);
+    while (microseconds > max && !atomic_compare_exchange_weak(&histogram->max, &max, microseconds));
+}
+
+static void MJInteractorHistogramReset(MJInteractorHistogram *histogram)
+{
+    for (int i = 0; i < MJInteractorHistogramBucketCount; i++)
+        atomic_store(&histogram->buckets[i], 0);
+    atomic_store(&histogram->count, 0);
+    atomic_store(&histogram->sum, 0);
+    atomic_store(&histogram->max, 0);
+}
+
+static NSDictionary* MJInteractorHistogramDictionary(MJInteractorHistogram *histogram)
+{
+    int64_t buckets[MJInteractorHistogramBucketCount];
+    int64_t count = 0;
+    
+    NSMutableArray *bucketCounts = [NSMutableArray arrayWithCapacity:MJInteractorHistogramBucketCount];
+    for (int i = 0; i < MJInteractorHistogramBucketCount; i++)
+    {
+        buckets[i] = atomic_load(&histogram->buckets[i]);
+        count += buckets[i];
+        [bucketCounts addObject:@(buckets[i])];
+    }
+    
+    // Percentiles are reported as the upper bound of the bucket containing them.
+    double percentiles[] = {0.5, 0.9, 0.99};
+    int64_t values[3] = {0, 0, 0};
+    
+    for (int p = 0; p < 3; p++)
+    {
+        int64_t target = (int64_t)ceil(count * percentiles[p]);
+        int64_t accumulated = 0;
+        
+        for (int i = 0; i < MJInteractorHistogramBucketCount; i++)
+        {
+            accumulated += buckets[i];
+            if (accumulated >= target && target > 0)
+            {
+                values[p] = 1LL << i;
+                break;
+            }
+        }
+    }
+    
+    int64_t sum = atomic_load(&histogram->sum);
+    int64_t max = atomic_load(&histogram->max);
+    
+    return @{@"count": @(count),
+             @"mean_us": @(count > 0 ? (double)sum / count : 0),
+             @"max_us": @(max),
+             @"p50_us": @(values[0]),
+             @"p90_us": @(values[1]),
+             @"p99_us": @(values[2]),
+             @"buckets": bucketCounts,
+             };
+}
+
+typedef struct
+{
+    __unsafe_unretained NSString *name;
+    uint64_t enqueueTime;
+    uint64_t startTime;
+    uint64_t endTime;
+    uint64_t deliveryTime;
+    uint32_t threadIdentifier;
+} MJInteractorTraceEvent;
+
+@interface MJInteractorMetrics ()
+
+- (void)mjz_traceJobWithName:(NSString*)name enqueueTime:(uint64_t)enqueueTime startTime:(uint64_t)startTime endTime:(uint64_t)endTime deliveryTime:(uint64_t)deliveryTime threadIdentifier:(uint32_t)threadIdentifier;
+
+@end
+
+#pragma mark -
+
+@implementation MJInteractorClassMetrics
+{
+    __weak MJInteractorMetrics *_metrics;
+    
+    MJInteractorHistogram _queueWait;
+    MJInteractorHistogram _execution;
+    MJInteractorHistogram _delivery;
+
+#if MJ_INTERACTOR_METRICS_SIGNPOSTS
+    os_log_t _log;
+#endif
+}
+
+- (id)initWithName:(NSString*)name metrics:(MJInteractorMetrics*)metrics
+{
+    self = [super init];
+    if (self)
+    {
+        _name = name;
+        _metrics = metrics;
+        
+        [self reset];
+
+#if MJ_INTERACTOR_METRICS_SIGNPOSTS
+        if (@available(iOS 12.0, *))
+            _log = os_log_create("com.mobilejazz.core.interactor", name.UTF8String);
+#endif
+    }
+    return self;
+}
+
+- (void)recordJobWithEnqueueTime:(uint64_t)enqueueTime startTime:(uint64_t)startTime endTime:(uint64_t)endTime deliveryTime:(uint64_t)deliveryTime
+{
+    [self recordJobWithEnqueueTime:enqueueTime startTime:startTime endTime:endTime deliveryTime:deliveryTime threadIdentifier:pthread_mach_thread_np(pthread_self())];
+}
+
+- (void)recordJobWithEnqueueTime:(uint64_t)enqueueTime startTime:(uint64_t)startTime endTime:(uint64_t)endTime deliveryTime:(uint64_t)deliveryTime threadIdentifier:(uint32_t)threadIdentifier
+{
+    MJInteractorMetrics *metrics = _metrics;
+    
+    if (metrics.enabled)
+    {
+        MJInteractorHistogramRecord(&_queueWait, startTime - enqueueTime);
+        MJInteractorHistogramRecord(&_execution, endTime - startTime);
+        MJInteractorHistogramRecord(&_delivery, deliveryTime - endTime);
+    }
+    
+    if (metrics.tracingEnabled)
+        [metrics mjz_traceJobWithName:_name enqueueTime:enqueueTime startTime:startTime endTime:endTime deliveryTime:deliveryTime threadIdentifier:threadIdentifier];
+}
+
+- (void)beginSignpostWithIdentifier:(const void*)identifier
+{
+#if MJ_INTERACTOR_METRICS_SIGNPOSTS
+    if (@available(iOS 12.0, *))
+    {
+        if (_metrics.tracingEnabled && os_signpost_enabled(_log))
+            os_signpost_interval_begin(_log, os_signpost_id_make_with_pointer(_log, identifier), "Job");
+    }
+#endif
+}
+
+- (void)endSignpostWithIdentifier:(const void*)identifier
+{
+#if MJ_INTERACTOR_METRICS_SIGNPOSTS
+    if (@available(iOS 12.0, *))
+    {
+        if (_metrics.tracingEnabled && os_signpost_enabled(_log))
+            os_signpost_interval_end(_log, os_signpost_id_make_with_pointer(_log, identifier), "Job");
+    }
+#endif
+}
+
+- (void)reset
+{
+    MJInteractorHistogramReset(&_queueWait);
+    MJInteractorHistogramReset(&_execution);
+    MJInteractorHistogramReset(&_delivery);
+}
+
+- (NSDictionary*)dictionaryRepresentation
+{
+    return @{@"queue_wait": MJInteractorHistogramDictionary(&_queueWait),
+             @"execution": MJInteractorHistogramDictionary(&_execution),
+             @"delivery": MJInteractorHistogramDictionary(&_delivery),
+             };
+}
+
+@end
+
+#pragma mark -
+
+@implementation MJInteractorMetrics
+{
+    NSMutableDictionary <NSString*, MJInteractorClassMetrics*> *_classMetrics;
+    
+    // Trace events are written and read under the lock, so no event is seen half written.
+    pthread_mutex_t _traceLock;
+    MJInteractorTraceEvent *_events;
+    int64_t _eventCount;
+}
+
++ (MJInteractorMetrics*)sharedMetrics
+{
+    static MJInteractorMetrics *metrics = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        metrics = [[MJInteractorMetrics alloc] init];
+    });
+    return metrics;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _enabled = YES;
+        _tracingEnabled = NO;
+        _traceCapacity = MJInteractorMetricsDefaultTraceCapacity;
+        
+        _classMetrics = [NSMutableDictionary dictionary];
+        pthread_mutex_init(&_traceLock, NULL);
+        _events = calloc(_traceCapacity, sizeof(MJInteractorTraceEvent));
+        _eventCount = 0;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_traceLock);
+    free(_events);
+}
+
+#pragma mark Public Methods
+
+- (MJInteractorClassMetrics*)metricsForClassName:(NSString*)name
+{
+    @synchronized(_classMetrics)
+    {
+        MJInteractorClassMetrics *classMetrics = _classMetrics[name];
+        if (!classMetrics)
+        {
+            classMetrics = [[MJInteractorClassMetrics alloc] initWithName:name metrics:self];
+            _classMetrics[name] = classMetrics;
+        }
+        return classMetrics;
+    }
+}
+
+- (void)reset
+{
+    @synchronized(_classMetrics)
+    {
+        [_classMetrics enumerateKeysAndObjectsUsingBlock:^(NSString *name, MJInteractorClassMetrics *classMetrics, BOOL *stop) {
+            [classMetrics reset];
+        }];
+    }
+    
+    pthread_mutex_lock(&_traceLock);
+    _eventCount = 0;
+    pthread_mutex_unlock(&_traceLock);
+}
+
+- (NSDictionary*)dictionaryRepresentation
+{
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    
+    @synchronized(_classMetrics)
+    {
+        [_classMetrics enumerateKeysAndObjectsUsingBlock:^(NSString *name, MJInteractorClassMetrics *classMetrics, BOOL *stop) {
+            dictionary[name] = [classMetrics dictionaryRepresentation];
+        }];
+    }
+    
+    return dictionary;
+}
+
+- (NSData*)JSONData
+{
+    return [NSJSONSerialization dataWithJSONObject:[self dictionaryRepresentation] options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+- (NSData*)chromeTraceData
+{
+    pthread_mutex_lock(&_traceLock);
+    
+    int64_t eventCount = _eventCount;
+    int64_t first = MAX(eventCount - (int64_t)_traceCapacity, 0);
+    
+    // Copy the events in order, so the JSON is built outside the lock.
+    NSUInteger count = (NSUInteger)(eventCount - first);
+    MJInteractorTraceEvent *events = malloc(MAX(count, 1) * sizeof(MJInteractorTraceEvent));
+    for (int64_t i = first; i < eventCount; i++)
+        events[i - first] = _events[i % _traceCapacity];
+    
+    pthread_mutex_unlock(&_traceLock);
+    
+    NSMutableArray *traceEvents = [NSMutableArray arrayWithCapacity:count * 6];
+    int processIdentifier = [NSProcessInfo processInfo].processIdentifier;
+    
+    for (int64_t i = first; i < eventCount; i++)
+    {
+        MJInteractorTraceEvent event = events[i - first];
+        if (!event.name)
+            continue;
+        
+        // Each job is traced as three async events, as jobs overlap. Timestamps in microseconds.
+        NSArray *phases = @[@[@"queue_wait", @(event.enqueueTime), @(event.startTime)],
+                            @[@"execution", @(event.startTime), @(event.endTime)],
+                            @[@"delivery", @(event.endTime), @(event.deliveryTime)],
+                            ];
+        
+        for (NSArray *phase in phases)
+        {
+            for (NSString *type in @[@"b", @"e"])
+            {
+                uint64_t time = [type isEqualToString:@"b"] ? [phase[1] unsignedLongLongValue] : [phase[2] unsignedLongLongValue];
+                
+                [traceEvents addObject:@{@"name": phase[0],
+                                         @"cat": event.name,
+                                         @"ph": type,
+                                         @"id": @(i),
+                                         @"ts": @(time / 1000.0),
+                                         @"pid": @(processIdentifier),
+                                         @"tid": @(event.threadIdentifier),
+                                         }];
+            }
+        }
+    }
+    
+    free(events);
+    
+    return [NSJSONSerialization dataWithJSONObject:@{@"traceEvents": traceEvents, @"displayTimeUnit": @"ms"} options:0 error:nil];
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_traceJobWithName:(NSString*)name enqueueTime:(uint64_t)enqueueTime startTime:(uint64_t)startTime endTime:(uint64_t)endTime deliveryTime:(uint64_t)deliveryTime threadIdentifier:(uint32_t)threadIdentifier
+{
+    pthread_mutex_lock(&_traceLock);
+    
+    // Names are retained by their class metrics, which are never released.
+    MJInteractorTraceEvent *event = &_events[_eventCount % _traceCapacity];
+    event->name = name;
+    event->enqueueTime = enqueueTime;
+    event->startTime = startTime;
+    event->endTime = endTime;
+    event->deliveryTime = deliveryTime;
+    event->threadIdentifier = threadIdentifier;
+    _eventCount++;
+    
+    pthread_mutex_unlock(&_traceLock);
+}
+
+@end
@@ -18,9 +18,11 @@
 
 @protocol MJTaskDispatcherObserver;
 
+extern NSTimeInterval const MJTaskDispatcherDefaultProgressInterval;
+
 /**
  * A MJTaskDispatcher is an object that stores multiple task keys and once those are finished, notifies the observers.
- * This class is thread-safe.
+ * This class is thread-safe. Observers are notified in the thread completing the last task, without holding any lock.
  **/
 @interface MJTaskDispatcher : NSObject
 
@@ -29,6 +31,16 @@
  **/
 @property (nonatomic, strong) id completionBlock;
 
+/**
+ * The minimum time between progress notifications. Default value is `MJTaskDispatcherDefaultProgressInterval`.
+ **/
+@property (nonatomic, assign) NSTimeInterval progressInterval;
+
+/**
+ * If YES, the dispatcher is reset after notifying its completion, so it can be reused. Default value is NO.
+ **/
+@property (nonatomic, assign) BOOL resetsOnCompletion;
+
 /** ************************************************************ **
  * @name Handling tasks
  ** ************************************************************ **/
@@ -36,9 +48,20 @@
 /**
 * The number of pending tasks.
 * @return The number of pending tasks.
+* @discussion Reading the count doesn't take any lock.
 **/
 - (NSUInteger)count;
 
+/**
+ * The number of succeed tasks since the last reset.
+ **/
+- (NSUInteger)completedCount;
+
+/**
+ * The number of failed tasks since the last reset.
+ **/
+- (NSUInteger)failedCount;
+
 /**
  * Defines a task start.
  * @param key   The key of the task that is starting. Cannot be nil.
@@ -63,6 +86,30 @@
  **/
 - (void)failAllPendingTasks;
 
+/**
+ * Releases the completed and failed task keys and their objects, so the dispatcher can be reused. Pending tasks are kept.
+ **/
+- (void)reset;
+
+/** ************************************************************ **
+ * @name Groups
+ ** ************************************************************ **/
+
+/**
+ * The parent dispatcher, if the dispatcher is a group.
+ **/
+@property (nonatomic, weak, readonly) MJTaskDispatcher *parentDispatcher;
+
+/**
+ * Starts a task that is a group of tasks.
+ * @param key The key of the task. Cannot be nil.
+ * @return The group dispatcher. Its tasks are started and completed as in any dispatcher.
+ * @discussion When all tasks of the group have completed, the task is completed in the parent with the group objects as object. The task succeeds if no task of the group has failed. The parent retains the group until then.
+ *
+ * A group without tasks never completes by itself. If no task is started in the group, call `completeAllPendingTasks` on it to complete it immediately.
+ **/
+- (MJTaskDispatcher*)startGroupWithKey:(NSString*)key;
+
 /** ************************************************************ **
  * @name Observation
  ** ************************************************************ **/
@@ -119,4 +166,14 @@
  **/
 - (void)dispatcher:(MJTaskDispatcher *)dispatcher didFailTasks:(NSSet*)tasks objects:(NSDictionary*)objects;;
 
+/**
+ * Method called when tasks complete, at most once per progress interval of the dispatcher.
+ * @param dispatcher        The dispatcher object.
+ * @param completedCount    The number of succeed tasks.
+ * @param failedCount       The number of failed tasks.
+ * @param pendingCount      The number of pending tasks.
+ * @discussion Called in the thread completing the task. The last update is always notified, before the completion methods.
+ **/
+- (void)dispatcher:(MJTaskDispatcher *)dispatcher didUpdateProgressWithCompletedCount:(NSUInteger)completedCount failedCount:(NSUInteger)failedCount pendingCount:(NSUInteger)pendingCount;
+
 @end
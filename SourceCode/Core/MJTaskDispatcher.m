@@ -16,19 +16,48 @@
 
 #import "MJTaskDispatcher.h"
 
-@interface MJTaskDispatcher ()
+#import <pthread.h>
+#import <stdatomic.h>
+#import <mach/mach_time.h>
 
-@end
+NSTimeInterval const MJTaskDispatcherDefaultProgressInterval = 0.1;
 
-@implementation MJTaskDispatcher
+#define MJTaskDispatcherShardCount 16
+
+/**
+ * Returns a monotonic timestamp in nanoseconds, not affected by changes of the system clock.
+ **/
+static int64_t MJTaskDispatcherTimestamp()
 {
-    NSMutableDictionary *_objects;
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
     
+    return (int64_t)(mach_absolute_time() * timebase.numer / timebase.denom);
+}
+
+/**
+ * A shard of the task table. Keys are distributed by hash, so concurrent tasks rarely share a lock.
+ **/
+@interface MJTaskDispatcherShard : NSObject
+{
+@public
     NSMutableSet *_pendingTasks;
     NSMutableSet *_completedTasks;
     NSMutableSet *_failedTasks;
-    
-    NSHashTable *_observers;
+    NSMutableDictionary *_objects;
+}
+
+- (void)lock;
+- (void)unlock;
+
+@end
+
+@implementation MJTaskDispatcherShard
+{
+    pthread_mutex_t _mutex;
 }
 
 - (id)init
@@ -36,109 +65,366 @@
     self = [super init];
     if (self)
     {
+        pthread_mutex_init(&_mutex, NULL);
+        
         _pendingTasks = [NSMutableSet set];
         _completedTasks = [NSMutableSet set];
         _failedTasks = [NSMutableSet set];
-        
         _objects = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_mutex);
+}
+
+- (void)lock
+{
+    pthread_mutex_lock(&_mutex);
+}
+
+- (void)unlock
+{
+    pthread_mutex_unlock(&_mutex);
+}
+
+@end
+
+#pragma mark -
+
+@interface MJTaskDispatcher ()
+
+@property (nonatomic, weak, readwrite) MJTaskDispatcher *parentDispatcher;
+@property (nonatomic, strong) NSString *parentKey;
+
+@end
+
+@implementation MJTaskDispatcher
+{
+    // Retained shards, created on first use, so dispatchers with few tasks (as groups) stay small.
+    void * _Atomic _shards[MJTaskDispatcherShardCount];
+    atomic_int _pendingCount;
+    atomic_int _completedCount;
+    atomic_int _failedCount;
+    atomic_llong _lastProgressTime;
+    
+    NSHashTable *_observers;
+    NSMutableDictionary <NSString*, MJTaskDispatcher*> *_groups;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        for (NSUInteger i = 0; i < MJTaskDispatcherShardCount; i++)
+            atomic_init(&_shards[i], NULL);
+        
+        atomic_init(&_pendingCount, 0);
+        atomic_init(&_completedCount, 0);
+        atomic_init(&_failedCount, 0);
+        atomic_init(&_lastProgressTime, 0);
+        _progressInterval = MJTaskDispatcherDefaultProgressInterval;
         
         _observers = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory];
+        _groups = [NSMutableDictionary dictionary];
     }
     return self;
 }
 
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < MJTaskDispatcherShardCount; i++)
+    {
+        void *shard = atomic_load(&_shards[i]);
+        if (shard)
+            CFRelease(shard);
+    }
+}
+
 #pragma mark Public Methods
 
 - (NSUInteger)count
 {
-    return _pendingTasks.count;
+    return (NSUInteger)MAX(atomic_load(&_pendingCount), 0);
 }
 
 - (void)startTaskWithKey:(NSString*)key
 {
-    @synchronized(self)
-    {
-        [_pendingTasks addObject:key];
-    }
+    MJTaskDispatcherShard *shard = [self mjz_shardForKey:key];
+    
+    [shard lock];
+    BOOL added = ![shard->_pendingTasks containsObject:key];
+    if (added)
+        [shard->_pendingTasks addObject:key];
+    [shard unlock];
+    
+    if (added)
+        atomic_fetch_add(&_pendingCount, 1);
 }
 
 - (void)completeTaskWithKey:(NSString*)key object:(id)object succeed:(BOOL)succeed
 {
-    @synchronized(self)
-    {
-        [_pendingTasks removeObject:key];
-        
-        if (succeed)
-            [_completedTasks addObject:key];
-        else
-            [_failedTasks addObject:key];
-        
-        if (object)
-            [_objects setObject:object forKey:key];
-        
-        [self mjz_checkTaskDispatchCompletion];
-    }
+    MJTaskDispatcherShard *shard = [self mjz_shardForKey:key];
+    
+    [shard lock];
+    BOOL removed = [shard->_pendingTasks containsObject:key];
+    if (removed)
+        [shard->_pendingTasks removeObject:key];
+    
+    NSMutableSet *tasks = succeed ? shard->_completedTasks : shard->_failedTasks;
+    BOOL added = ![tasks containsObject:key];
+    if (added)
+        [tasks addObject:key];
+    
+    if (object)
+        [shard->_objects setObject:object forKey:key];
+    [shard unlock];
+    
+    if (added)
+        atomic_fetch_add(succeed ? &_completedCount : &_failedCount, 1);
+    
+    int32_t pendingCount = removed ? atomic_fetch_sub(&_pendingCount, 1) - 1 : (int32_t)self.count;
+    
+    if (pendingCount == 0)
+        [self mjz_notifyTaskDispatchCompletion];
+    else
+        [self mjz_notifyProgressIfNeeded:NO];
 }
 
 - (void)completeAllPendingTasks
 {
-    @synchronized(self)
+    [self mjz_finishAllPendingTasksWithSuccess:YES];
+}
+
+- (void)failAllPendingTasks
+{
+    [self mjz_finishAllPendingTasksWithSuccess:NO];
+}
+
+- (NSUInteger)completedCount
+{
+    return (NSUInteger)MAX(atomic_load(&_completedCount), 0);
+}
+
+- (NSUInteger)failedCount
+{
+    return (NSUInteger)MAX(atomic_load(&_failedCount), 0);
+}
+
+- (MJTaskDispatcher*)startGroupWithKey:(NSString*)key
+{
+    MJTaskDispatcher *group = [[MJTaskDispatcher alloc] init];
+    group.parentDispatcher = self;
+    group.parentKey = key;
+    group.progressInterval = _progressInterval;
+    
+    @synchronized(_groups)
     {
-        [_pendingTasks.allObjects enumerateObjectsUsingBlock:^(id  _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-            [_completedTasks addObject:obj];
-        }];
-        [_pendingTasks removeAllObjects];
-        
-        [self mjz_checkTaskDispatchCompletion];
+        _groups[key] = group;
     }
+    
+    [self startTaskWithKey:key];
+    
+    return group;
 }
 
-- (void)failAllPendingTasks
+- (void)reset
 {
-    @synchronized(self)
+    for (NSUInteger i = 0; i < MJTaskDispatcherShardCount; i++)
     {
-        [_pendingTasks.allObjects enumerateObjectsUsingBlock:^(id  _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-            [_failedTasks addObject:obj];
-        }];
-        [_pendingTasks removeAllObjects];
+        MJTaskDispatcherShard *shard = [self mjz_existingShardAtIndex:i];
+        if (!shard)
+            continue;
         
-        [self mjz_checkTaskDispatchCompletion];
+        [shard lock];
+        [shard->_completedTasks removeAllObjects];
+        [shard->_failedTasks removeAllObjects];
+        [shard->_objects removeAllObjects];
+        [shard unlock];
     }
+    
+    atomic_store(&_completedCount, 0);
+    atomic_store(&_failedCount, 0);
 }
 
 - (void)addObserver:(id <MJTaskDispatcherObserver>)observer
 {
-    [_observers addObject:observer];
+    @synchronized(_observers)
+    {
+        [_observers addObject:observer];
+    }
 }
 
 - (void)removeObserver:(id <MJTaskDispatcherObserver>)observer
 {
-    [_observers removeObject:observer];
+    @synchronized(_observers)
+    {
+        [_observers removeObject:observer];
+    }
 }
 
 #pragma mark Private Methods
 
-- (void)mjz_checkTaskDispatchCompletion
+- (MJTaskDispatcherShard*)mjz_shardForKey:(NSString*)key
+{
+    NSUInteger index = key.hash % MJTaskDispatcherShardCount;
+    
+    MJTaskDispatcherShard *shard = [self mjz_existingShardAtIndex:index];
+    if (shard)
+        return shard;
+    
+    // Threads racing for the same shard publish it with a swap; the losers release theirs.
+    void *expected = NULL;
+    void *newShard = (void*)CFBridgingRetain([[MJTaskDispatcherShard alloc] init]);
+    
+    if (atomic_compare_exchange_strong(&_shards[index], &expected, newShard))
+        return (__bridge MJTaskDispatcherShard*)newShard;
+    
+    CFRelease(newShard);
+    return (__bridge MJTaskDispatcherShard*)expected;
+}
+
+- (MJTaskDispatcherShard*)mjz_existingShardAtIndex:(NSUInteger)index
+{
+    return (__bridge MJTaskDispatcherShard*)atomic_load(&_shards[index]);
+}
+
+- (void)mjz_finishAllPendingTasksWithSuccess:(BOOL)succeed
+{
+    int32_t finishedCount = 0;
+    int32_t addedCount = 0;
+    
+    for (NSUInteger i = 0; i < MJTaskDispatcherShardCount; i++)
+    {
+        MJTaskDispatcherShard *shard = [self mjz_existingShardAtIndex:i];
+        if (!shard)
+            continue;
+        
+        [shard lock];
+        NSMutableSet *tasks = succeed ? shard->_completedTasks : shard->_failedTasks;
+        NSUInteger previousCount = tasks.count;
+        [tasks unionSet:shard->_pendingTasks];
+        
+        addedCount += (int32_t)(tasks.count - previousCount);
+        finishedCount += (int32_t)shard->_pendingTasks.count;
+        [shard->_pendingTasks removeAllObjects];
+        [shard unlock];
+    }
+    
+    atomic_fetch_add(succeed ? &_completedCount : &_failedCount, addedCount);
+    int32_t pendingCount = atomic_fetch_sub(&_pendingCount, finishedCount) - finishedCount;
+    
+    if (pendingCount == 0)
+        [self mjz_notifyTaskDispatchCompletion];
+    else
+        [self mjz_notifyProgressIfNeeded:NO];
+}
+
+- (NSArray*)mjz_observers
 {
+    @synchronized(_observers)
+    {
+        return _observers.allObjects;
+    }
+}
+
+- (void)mjz_notifyProgressIfNeeded:(BOOL)force
+{
+    int64_t now = MJTaskDispatcherTimestamp();
+    long long lastProgressTime = atomic_load(&_lastProgressTime);
+    
+    if (!force)
+    {
+        // Only the thread winning the swap notifies, at most once per interval.
+        if (now - lastProgressTime < (int64_t)(_progressInterval * NSEC_PER_SEC))
+            return;
+        
+        if (!atomic_compare_exchange_strong(&_lastProgressTime, &lastProgressTime, now))
+            return;
+    }
+    else
+    {
+        atomic_store(&_lastProgressTime, now);
+    }
+    
+    NSUInteger completedCount = self.completedCount;
+    NSUInteger failedCount = self.failedCount;
+    NSUInteger pendingCount = self.count;
+    
+    for (id <MJTaskDispatcherObserver> observer in [self mjz_observers])
+    {
+        if ([observer respondsToSelector:@selector(dispatcher:didUpdateProgressWithCompletedCount:failedCount:pendingCount:)])
+            [observer dispatcher:self didUpdateProgressWithCompletedCount:completedCount failedCount:failedCount pendingCount:pendingCount];
+    }
+}
+
+- (void)mjz_notifyTaskDispatchCompletion
+{
+    NSMutableSet *completedTasks = [NSMutableSet set];
+    NSMutableSet *failedTasks = [NSMutableSet set];
+    NSMutableDictionary *objects = [NSMutableDictionary dictionary];
+    
+    for (NSUInteger i = 0; i < MJTaskDispatcherShardCount; i++)
+    {
+        MJTaskDispatcherShard *shard = [self mjz_existingShardAtIndex:i];
+        if (!shard)
+            continue;
+        
+        [shard lock];
+        [completedTasks unionSet:shard->_completedTasks];
+        [failedTasks unionSet:shard->_failedTasks];
+        [objects addEntriesFromDictionary:shard->_objects];
+        [shard unlock];
+    }
+    
+    // The last progress update is never throttled.
+    [self mjz_notifyProgressIfNeeded:YES];
+    
+    // Observers are notified without holding any lock, so they can start or complete tasks.
+    for (id <MJTaskDispatcherObserver> observer in [self mjz_observers])
+    {
+        if ([observer respondsToSelector:@selector(dispatcher:didCompleteTasks:failedTasks:objects:)])
+            [observer dispatcher:self didCompleteTasks:completedTasks failedTasks:failedTasks objects:objects];
+        
+        if ([observer respondsToSelector:@selector(dispatcher:didFailTasks:objects:)])
+            [observer dispatcher:self didFailTasks:failedTasks objects:objects];
+        
+        if ([observer respondsToSelector:@selector(dispatcher:didCompleteTasks:objects:)])
+            [observer dispatcher:self didCompleteTasks:completedTasks objects:objects];
+    }
+    
+    if (_resetsOnCompletion)
+        [self reset];
+    
+    // A group completes as a single task of its parent, with the group objects as object.
+    // The parent is taken under the lock, so concurrent completions complete it only once.
+    MJTaskDispatcher *parentDispatcher = nil;
+    NSString *parentKey = nil;
+    
     @synchronized(self)
     {
-        if (_pendingTasks.count == 0)
-        {
-            NSSet *completedTasks = [_completedTasks copy];
-            NSSet *failedTasks = [_failedTasks copy];
-            NSDictionary *objects = [_objects copy];
-            
-            [_observers.allObjects enumerateObjectsUsingBlock:^(id<MJTaskDispatcherObserver> _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-                if ([obj respondsToSelector:@selector(dispatcher:didCompleteTasks:failedTasks:objects:)])
-                    [obj dispatcher:self didCompleteTasks:completedTasks failedTasks:failedTasks objects:objects];
-                
-                if ([obj respondsToSelector:@selector(dispatcher:didFailTasks:objects:)])
-                    [obj dispatcher:self didFailTasks:failedTasks objects:objects];
-                
-                if ([obj respondsToSelector:@selector(dispatcher:didCompleteTasks:objects:)])
-                    [obj dispatcher:self didCompleteTasks:completedTasks objects:objects];
-            }];
-        }
+        parentDispatcher = _parentDispatcher;
+        parentKey = _parentKey;
+        _parentDispatcher = nil;
+    }
+    
+    if (parentDispatcher)
+    {
+        [parentDispatcher completeTaskWithKey:parentKey object:(objects.count > 0 ? objects : nil) succeed:(failedTasks.count == 0)];
+        
+        // The parent may hold the last reference to the group.
+        [parentDispatcher mjz_removeGroupWithKey:parentKey];
+    }
+}
+
+- (void)mjz_removeGroupWithKey:(NSString*)key
+{
+    @synchronized(_groups)
+    {
+        [_groups removeObjectForKey:key];
     }
 }
 
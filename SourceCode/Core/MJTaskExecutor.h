@@ -0,0 +1,106 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MJTaskDispatcher.h"
+
+extern NSTimeInterval const MJTaskExecutorDefaultRetryDelay;
+extern NSTimeInterval const MJTaskExecutorDefaultMaxRetryDelay;
+
+/**
+ * Block executed by the executor. Call the completion block once the task finishes, from any thread.
+ * @param completion The completion block, with the task object (can be nil) and a flag indicating if the task has succeed.
+ **/
+typedef void (^MJTaskExecutorBlock)(void (^completion)(id object, BOOL succeed));
+
+/**
+ * Executes task blocks with a limited concurrency, reporting them through a task dispatcher.
+ * @discussion Submitted tasks are started in the dispatcher at once and executed in submission order as soon as a slot is available. Failed tasks are retried with exponential backoff; a retrying task doesn't hold a slot while waiting. Once finished, tasks are completed in the dispatcher, which notifies its observers as usual. This class is thread-safe.
+ **/
+@interface MJTaskExecutor : NSObject
+
+/** *************************************************** **
+ * @name Initializers
+ ** *************************************************** **/
+
+/**
+ * Default initializer, using a new dispatcher.
+ **/
+- (id)init;
+
+/**
+ * Initializes the executor with a dispatcher.
+ * @param dispatcher The dispatcher reporting the tasks.
+ **/
+- (id)initWithDispatcher:(MJTaskDispatcher*)dispatcher;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The dispatcher reporting the tasks.
+ **/
+@property (nonatomic, strong, readonly) MJTaskDispatcher *dispatcher;
+
+/**
+ * The maximum number of tasks executing at the same time. Default value is the number of active processors.
+ **/
+@property (nonatomic, assign) NSUInteger maxConcurrentTasks;
+
+/**
+ * The number of times a failed task is retried. Default value is 0.
+ **/
+@property (nonatomic, assign) NSUInteger maxRetryCount;
+
+/**
+ * The delay before the first retry. Each retry doubles it, up to `maxRetryDelay`. Default value is `MJTaskExecutorDefaultRetryDelay`.
+ **/
+@property (nonatomic, assign) NSTimeInterval retryDelay;
+
+/**
+ * The maximum delay between retries. Default value is `MJTaskExecutorDefaultMaxRetryDelay`.
+ **/
+@property (nonatomic, assign) NSTimeInterval maxRetryDelay;
+
+/**
+ * The queue where task blocks are executed. Default value is the default priority global queue.
+ **/
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+/** *************************************************** **
+ * @name Executing tasks
+ ** *************************************************** **/
+
+/**
+ * Submits a task.
+ * @param key The key of the task. Cannot be nil.
+ * @param block The task block.
+ **/
+- (void)submitTaskWithKey:(NSString*)key block:(MJTaskExecutorBlock)block;
+
+/**
+ * The number of tasks executing.
+ **/
+- (NSUInteger)runningCount;
+
+/**
+ * Fails all tasks not executing yet, including the ones waiting to be retried.
+ **/
+- (void)cancelAllPendingTasks;
+
+@end
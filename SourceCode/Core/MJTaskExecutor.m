@@ -0,0 +1,218 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJTaskExecutor.h"
+
+#import <stdatomic.h>
+
+NSTimeInterval const MJTaskExecutorDefaultRetryDelay    = 0.5;
+NSTimeInterval const MJTaskExecutorDefaultMaxRetryDelay = 30.0;
+
+/**
+ * A submitted task.
+ **/
+@interface MJTaskExecutorTask : NSObject
+
+@property (nonatomic, strong) NSString *key;
+@property (nonatomic, copy) MJTaskExecutorBlock block;
+@property (nonatomic, assign) NSUInteger attempt;
+@property (nonatomic, assign) BOOL cancelled;
+
+@end
+
+@implementation MJTaskExecutorTask
+
+@end
+
+#pragma mark -
+
+@implementation MJTaskExecutor
+{
+    NSMutableArray <MJTaskExecutorTask*> *_pendingTasks;
+    NSMutableSet <MJTaskExecutorTask*> *_retryingTasks;
+    NSUInteger _runningCount;
+}
+
+- (id)init
+{
+    return [self initWithDispatcher:[[MJTaskDispatcher alloc] init]];
+}
+
+- (id)initWithDispatcher:(MJTaskDispatcher*)dispatcher
+{
+    self = [super init];
+    if (self)
+    {
+        _dispatcher = dispatcher;
+        _maxConcurrentTasks = MAX([NSProcessInfo processInfo].activeProcessorCount, 1);
+        _maxRetryCount = 0;
+        _retryDelay = MJTaskExecutorDefaultRetryDelay;
+        _maxRetryDelay = MJTaskExecutorDefaultMaxRetryDelay;
+        _queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        
+        _pendingTasks = [NSMutableArray array];
+        _retryingTasks = [NSMutableSet set];
+        _runningCount = 0;
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (void)setMaxConcurrentTasks:(NSUInteger)maxConcurrentTasks
+{
+    @synchronized(self)
+    {
+        _maxConcurrentTasks = MAX(maxConcurrentTasks, 1);
+    }
+    
+    [self mjz_executePendingTasks];
+}
+
+#pragma mark Public Methods
+
+- (void)submitTaskWithKey:(NSString*)key block:(MJTaskExecutorBlock)block
+{
+    MJTaskExecutorTask *task = [[MJTaskExecutorTask alloc] init];
+    task.key = key;
+    task.block = block;
+    task.attempt = 0;
+    
+    [_dispatcher startTaskWithKey:key];
+    
+    @synchronized(self)
+    {
+        [_pendingTasks addObject:task];
+    }
+    
+    [self mjz_executePendingTasks];
+}
+
+- (NSUInteger)runningCount
+{
+    @synchronized(self)
+    {
+        return _runningCount;
+    }
+}
+
+- (void)cancelAllPendingTasks
+{
+    NSMutableArray *tasks = nil;
+    
+    @synchronized(self)
+    {
+        tasks = [_pendingTasks mutableCopy];
+        [tasks addObjectsFromArray:_retryingTasks.allObjects];
+        
+        [_pendingTasks removeAllObjects];
+        [_retryingTasks removeAllObjects];
+        
+        for (MJTaskExecutorTask *task in tasks)
+            task.cancelled = YES;
+    }
+    
+    for (MJTaskExecutorTask *task in tasks)
+        [_dispatcher completeTaskWithKey:task.key object:nil succeed:NO];
+}
+
+#pragma mark Private Methods
+
+- (void)mjz_executePendingTasks
+{
+    NSMutableArray *tasks = [NSMutableArray array];
+    
+    @synchronized(self)
+    {
+        while (_runningCount < _maxConcurrentTasks && _pendingTasks.count > 0)
+        {
+            [tasks addObject:_pendingTasks.firstObject];
+            [_pendingTasks removeObjectAtIndex:0];
+            _runningCount++;
+        }
+    }
+    
+    for (MJTaskExecutorTask *task in tasks)
+    {
+        dispatch_async(_queue, ^{
+            [self mjz_executeTask:task];
+        });
+    }
+}
+
+- (void)mjz_executeTask:(MJTaskExecutorTask*)task
+{
+    __block atomic_bool completed = NO;
+    
+    task.block(^(id object, BOOL succeed) {
+        // Completion blocks called more than once are ignored
+        if (atomic_exchange(&completed, YES))
+            return;
+        
+        [self mjz_finishTask:task object:object succeed:succeed];
+    });
+}
+
+- (void)mjz_finishTask:(MJTaskExecutorTask*)task object:(id)object succeed:(BOOL)succeed
+{
+    BOOL retry = NO;
+    NSTimeInterval delay = 0;
+    
+    @synchronized(self)
+    {
+        _runningCount--;
+        
+        if (!succeed && task.attempt < _maxRetryCount && !task.cancelled)
+        {
+            retry = YES;
+            delay = MIN(_retryDelay * pow(2.0, task.attempt), _maxRetryDelay);
+            
+            // Random jitter, so tasks failing together don't retry together.
+            delay *= 0.5 + arc4random_uniform(1000) / 2000.0;
+            
+            task.attempt++;
+            [_retryingTasks addObject:task];
+        }
+    }
+    
+    if (retry)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), _queue, ^{
+            BOOL enqueued = NO;
+            
+            @synchronized(self)
+            {
+                if ([_retryingTasks containsObject:task])
+                {
+                    [_retryingTasks removeObject:task];
+                    [_pendingTasks addObject:task];
+                    enqueued = YES;
+                }
+            }
+            
+            if (enqueued)
+                [self mjz_executePendingTasks];
+        });
+    }
+    else
+    {
+        [_dispatcher completeTaskWithKey:task.key object:object succeed:succeed];
+    }
+    
+    [self mjz_executePendingTasks];
+}
+
+@end
@@ -10,6 +10,8 @@
 #define MJ_iOS_Toolkit_h
 
 #import "MJSecureKey.h"
+#import "MJSecureKeyRing.h"
+#import "MJEncryptedPageStore.h"
 #import "MJAppLinkRecognizer.h"
 #import "MJCloudinaryInterface.h"
 #import "UIImageView+MJCloudinaryInterface.h"
@@ -17,8 +19,12 @@
 #import "MJObjectStack.h"
 
 #import "MJTaskDispatcher.h"
+#import "MJTaskExecutor.h"
 #import "MJInteractor.h"
+#import "MJInteractorMetrics.h"
 #import "MJDataProviderDirector.h"
+#import "MJDataProviderCache.h"
+#import "MJDataProviderScheduler.h"
 
 #import "MJTextViewCell.h"
 #import "MJMultiToggleControl.h"
@@ -53,7 +53,8 @@ extern NSString * const MJAppLinkPatternAlphanumericAndDash;
 @protocol MJAppLinkRecognizerDelegate;
 
 /**
- *
+ * Recognizes app links matching the configured patterns.
+ * @discussion Patterns are compiled once, when the recognizer is initialized. If the options include both anchors, patterns made of literal path segments (metacharacters escaped, as `\\.`) and `MJAppLinkPattern` captures (except `MJAppLinkPatternNonNumeric`) are matched with a routing trie instead of one regular expression per pattern. Each path segment is tried against its literal child and then up to three capture children, backtracking when a branch fails or the delegate refuses the match. The cost is bounded by the size of the trie rather than by the number of patterns, and stays close to the path length when literal segments tell the routes apart. Other patterns are matched with their regular expression.
  **/
 @interface MJAppLinkRecognizer : NSObject
 
@@ -21,6 +21,46 @@ NSString * const MJAppLinkPatternNonNumeric             = @"(\\D+)";
 NSString * const MJAppLinkPatternAlphanumeric           = @"(\\w+)";
 NSString * const MJAppLinkPatternAlphanumericAndDash    = @"([\\w,-]+)";
 
+typedef NS_ENUM(NSUInteger, MJAppLinkCapture)
+{
+    MJAppLinkCaptureNumeric,
+    MJAppLinkCaptureAlphanumeric,
+    MJAppLinkCaptureAlphanumericAndDash,
+};
+
+static NSUInteger const MJAppLinkCaptureCount = MJAppLinkCaptureAlphanumericAndDash + 1;
+
+/**
+ * A pattern compiled into a regular expression.
+ **/
+@interface MJAppLinkRoute : NSObject
+
+@property (nonatomic, strong) NSString *key;
+@property (nonatomic, strong) NSRegularExpression *regex;
+
+@end
+
+@implementation MJAppLinkRoute
+
+@end
+
+/**
+ * A node of the routing trie. Children are indexed by literal path segment or by capture type.
+ **/
+@interface MJAppLinkRouteNode : NSObject
+{
+@public
+    NSMutableDictionary <NSString*, MJAppLinkRouteNode*> *_literals;
+    MJAppLinkRouteNode *_captures[MJAppLinkCaptureCount];
+    NSMutableArray <NSString*> *_keys;
+}
+
+@end
+
+@implementation MJAppLinkRouteNode
+
+@end
+
 @interface MJAppLinkRecognizerConfiguration ()
 
 - (NSDictionary*)patterns;
@@ -71,6 +111,10 @@ NSString * const MJAppLinkPatternAlphanumericAndDash    = @"([\\w,-]+)";
     NSDictionary <NSString*,NSString*> *_patterns;
     MJAppLinkOptions _options;
     
+    MJAppLinkRouteNode *_rootNode;
+    NSArray <MJAppLinkRoute*> *_routes;
+    NSArray <NSRegularExpression*> *_captureRegexes;
+    
     NSHashTable <id<MJAppLinkRecognizerObserver>>*_observers;
 }
 
@@ -93,6 +137,8 @@ NSString * const MJAppLinkPatternAlphanumericAndDash    = @"([\\w,-]+)";
         _patterns = [configuration patterns];
         _options = configuration.options;
         
+        [self mjz_compilePatterns];
+        
         _observers = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory];
     }
     return self;
@@ -149,25 +195,25 @@ NSString * const MJAppLinkPatternAlphanumericAndDash    = @"([\\w,-]+)";
     
     NSString *linkString = [url resourceSpecifier];
     
-    NSRegularExpressionOptions regularExpressionOptions = 0;
-    
-    if ((_options & MJAppLinkOptionsCaseInsensitive) != 0)
-        regularExpressionOptions |= NSRegularExpressionCaseInsensitive;
-    
-    for (NSString *patternKey in _patterns)
+    // Routes of the trie are tried first, each one only once its path matches.
+    if (_rootNode && linkString)
     {
-        NSString *pattern = _patterns[patternKey];
-        
-        if ((_options & MJAppLinkOptionsAnchoredStart) != 0)
-            pattern = [@"^" stringByAppendingString:pattern];
+        NSArray *segments = [linkString componentsSeparatedByString:@"/"];
+        __block BOOL recognized = NO;
         
-        if ((_options & MJAppLinkOptionsAnchoredEnd) != 0)
-            pattern = [pattern stringByAppendingString:@"$"];
+        [self mjz_matchSegments:segments index:0 node:_rootNode captures:[NSMutableArray array] block:^BOOL(NSString *patternKey, NSArray *components) {
+            recognized = [self mjz_recognizeURLForKey:patternKey components:components];
+            return recognized;
+        }];
         
-        NSError *error = nil;
-        NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:pattern
-                                                                               options:regularExpressionOptions
-                                                                                 error:&error];
+        if (recognized)
+            return MJAppLinkRecognizerResultValid;
+    }
+    
+    for (MJAppLinkRoute *route in _routes)
+    {
+        NSString *patternKey = route.key;
+        NSRegularExpression *regex = route.regex;
         
         NSTextCheckingResult *result = [regex firstMatchInString:linkString
                                                          options:0
@@ -184,22 +230,8 @@ NSString * const MJAppLinkPatternAlphanumericAndDash    = @"([\\w,-]+)";
                 [captures addObject:capture];
             }
             
-            NSArray *compontents = [captures copy];
-            
-            BOOL canRecognizePattern = YES;
-            
-            if ([_delegate respondsToSelector:@selector(appLinkRecognizer:willRecognizeURLForKey:components:)])
-                canRecognizePattern = [_delegate appLinkRecognizer:self willRecognizeURLForKey:patternKey components:compontents];
-            
-            if (canRecognizePattern)
-            {
-                [self mjz_enumerateObservers:^(id<MJAppLinkRecognizerObserver>  _Nonnull obj) {
-                    if ([obj respondsToSelector:@selector(appLinkRecognizer:didRecognizeURLForKey:components:)])
-                        [obj appLinkRecognizer:self didRecognizeURLForKey:patternKey components:compontents];
-                }];
-                
+            if ([self mjz_recognizeURLForKey:patternKey components:[captures copy]])
                 return MJAppLinkRecognizerResultValid;
-            }
         }
     }
     
@@ -211,4 +243,270 @@ NSString * const MJAppLinkPatternAlphanumericAndDash    = @"([\\w,-]+)";
     return MJAppLinkRecognizerResultUnsupportedLink;
 }
 
+- (BOOL)mjz_recognizeURLForKey:(NSString*)patternKey components:(NSArray*)compontents
+{
+    BOOL canRecognizePattern = YES;
+    
+    if ([_delegate respondsToSelector:@selector(appLinkRecognizer:willRecognizeURLForKey:components:)])
+        canRecognizePattern = [_delegate appLinkRecognizer:self willRecognizeURLForKey:patternKey components:compontents];
+    
+    if (canRecognizePattern)
+    {
+        [self mjz_enumerateObservers:^(id<MJAppLinkRecognizerObserver>  _Nonnull obj) {
+            if ([obj respondsToSelector:@selector(appLinkRecognizer:didRecognizeURLForKey:components:)])
+                [obj appLinkRecognizer:self didRecognizeURLForKey:patternKey components:compontents];
+        }];
+    }
+    
+    return canRecognizePattern;
+}
+
+#pragma mark Routing
+
+- (void)mjz_compilePatterns
+{
+    BOOL caseInsensitive = (_options & MJAppLinkOptionsCaseInsensitive) != 0;
+    BOOL anchored = (_options & MJAppLinkOptionsAnchoredStart) != 0 && (_options & MJAppLinkOptionsAnchoredEnd) != 0;
+    
+    NSRegularExpressionOptions regularExpressionOptions = 0;
+    
+    if (caseInsensitive)
+        regularExpressionOptions |= NSRegularExpressionCaseInsensitive;
+    
+    NSMutableArray *routes = [NSMutableArray array];
+    MJAppLinkRouteNode *rootNode = nil;
+    
+    // Patterns are sorted, so the trie and the route order don't depend on the dictionary order.
+    for (NSString *patternKey in [_patterns.allKeys sortedArrayUsingSelector:@selector(compare:)])
+    {
+        NSString *pattern = _patterns[patternKey];
+        
+        // Anchored patterns made of literal and capture segments go to the trie. Other ones are matched with their regular expression.
+        if (anchored)
+        {
+            if (!rootNode)
+                rootNode = [self mjz_newNode];
+            
+            if ([self mjz_addPattern:pattern forKey:patternKey toNode:rootNode caseInsensitive:caseInsensitive])
+                continue;
+        }
+        
+        if ((_options & MJAppLinkOptionsAnchoredStart) != 0)
+            pattern = [@"^" stringByAppendingString:pattern];
+        
+        if ((_options & MJAppLinkOptionsAnchoredEnd) != 0)
+            pattern = [pattern stringByAppendingString:@"$"];
+        
+        NSError *error = nil;
+        NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:pattern
+                                                                               options:regularExpressionOptions
+                                                                                 error:&error];
+        
+        if (!regex)
+            continue;
+        
+        MJAppLinkRoute *route = [[MJAppLinkRoute alloc] init];
+        route.key = patternKey;
+        route.regex = regex;
+        [routes addObject:route];
+    }
+    
+    _rootNode = rootNode;
+    _routes = [routes copy];
+    
+    // Used to validate non-ASCII captures, matching exactly the capture patterns.
+    _captureRegexes = @[[NSRegularExpression regularExpressionWithPattern:@"^\\d+$" options:0 error:nil],
+                        [NSRegularExpression regularExpressionWithPattern:@"^\\w+$" options:0 error:nil],
+                        [NSRegularExpression regularExpressionWithPattern:@"^[\\w,-]+$" options:0 error:nil],
+                        ];
+}
+
+- (MJAppLinkRouteNode*)mjz_newNode
+{
+    MJAppLinkRouteNode *node = [[MJAppLinkRouteNode alloc] init];
+    node->_literals = [NSMutableDictionary dictionary];
+    node->_keys = [NSMutableArray array];
+    return node;
+}
+
+- (BOOL)mjz_addPattern:(NSString*)pattern forKey:(NSString*)patternKey toNode:(MJAppLinkRouteNode*)rootNode caseInsensitive:(BOOL)caseInsensitive
+{
+    NSArray *captures = @[MJAppLinkPatternNumeric, MJAppLinkPatternAlphanumeric, MJAppLinkPatternAlphanumericAndDash];
+    NSArray *segments = [pattern componentsSeparatedByString:@"/"];
+    NSMutableArray *literals = [NSMutableArray arrayWithCapacity:segments.count]; // Literal strings or capture numbers
+    
+    // Validate all segments before modifying the trie.
+    for (NSString *segment in segments)
+    {
+        NSUInteger capture = [captures indexOfObject:segment];
+        
+        if (capture != NSNotFound)
+        {
+            [literals addObject:@(capture)];
+            continue;
+        }
+        
+        NSString *literal = [self mjz_literalForPatternSegment:segment];
+        
+        if (!literal)
+            return NO;
+        
+        // Case folding is only replicated for ASCII literals.
+        if (caseInsensitive && ![literal canBeConvertedToEncoding:NSASCIIStringEncoding])
+            return NO;
+        
+        [literals addObject:literal];
+    }
+    
+    MJAppLinkRouteNode *node = rootNode;
+    
+    for (id segment in literals)
+    {
+        MJAppLinkRouteNode *child = nil;
+        
+        if ([segment isKindOfClass:NSNumber.class])
+        {
+            NSUInteger capture = [segment unsignedIntegerValue];
+            child = node->_captures[capture];
+            if (!child)
+            {
+                child = [self mjz_newNode];
+                node->_captures[capture] = child;
+            }
+        }
+        else
+        {
+            NSString *literal = caseInsensitive ? [segment lowercaseString] : segment;
+            child = node->_literals[literal];
+            if (!child)
+            {
+                child = [self mjz_newNode];
+                node->_literals[literal] = child;
+            }
+        }
+        
+        node = child;
+    }
+    
+    [node->_keys addObject:patternKey];
+    return YES;
+}
+
+- (NSString*)mjz_literalForPatternSegment:(NSString*)segment
+{
+    static NSCharacterSet *metacharacters = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        metacharacters = [NSCharacterSet characterSetWithCharactersInString:@"\\^$.|?*+()[]{}"];
+    });
+    
+    NSMutableString *literal = [NSMutableString stringWithCapacity:segment.length];
+    NSUInteger length = segment.length;
+    
+    for (NSUInteger i = 0; i < length; i++)
+    {
+        unichar c = [segment characterAtIndex:i];
+        
+        // Escaped metacharacters, as "\.", are literals. Any other escape is a pattern.
+        if (c == '\\' && i + 1 < length && [metacharacters characterIsMember:[segment characterAtIndex:i + 1]])
+        {
+            c = [segment characterAtIndex:++i];
+        }
+        else if ([metacharacters characterIsMember:c])
+        {
+            return nil;
+        }
+        
+        [literal appendFormat:@"%C", c];
+    }
+    
+    return literal;
+}
+
+- (BOOL)mjz_matchSegments:(NSArray <NSString*> *)segments
+                    index:(NSUInteger)index
+                     node:(MJAppLinkRouteNode*)node
+                 captures:(NSMutableArray*)captures
+                    block:(BOOL (^)(NSString *patternKey, NSArray *components))block
+{
+    if (index == segments.count)
+    {
+        for (NSString *patternKey in node->_keys)
+        {
+            if (block(patternKey, [captures copy]))
+                return YES;
+        }
+        return NO;
+    }
+    
+    NSString *segment = segments[index];
+    
+    // Literals first, then captures from the most specific.
+    NSString *literal = (_options & MJAppLinkOptionsCaseInsensitive) != 0 ? segment.lowercaseString : segment;
+    MJAppLinkRouteNode *child = node->_literals[literal];
+    
+    if (child && [self mjz_matchSegments:segments index:index + 1 node:child captures:captures block:block])
+        return YES;
+    
+    for (NSUInteger capture = 0; capture < MJAppLinkCaptureCount; capture++)
+    {
+        child = node->_captures[capture];
+        
+        if (!child || ![self mjz_segment:segment matchesCapture:capture])
+            continue;
+        
+        [captures addObject:segment];
+        
+        if ([self mjz_matchSegments:segments index:index + 1 node:child captures:captures block:block])
+            return YES;
+        
+        [captures removeLastObject];
+    }
+    
+    return NO;
+}
+
+- (BOOL)mjz_segment:(NSString*)segment matchesCapture:(MJAppLinkCapture)capture
+{
+    NSUInteger length = segment.length;
+    
+    if (length == 0)
+        return NO;
+    
+    for (NSUInteger i = 0; i < length; i++)
+    {
+        unichar c = [segment characterAtIndex:i];
+        
+        if (c >= 128)
+        {
+            // Unicode digits and word characters are validated by the capture pattern itself.
+            NSRegularExpression *regex = _captureRegexes[capture];
+            return [regex numberOfMatchesInString:segment options:0 range:NSMakeRange(0, length)] > 0;
+        }
+        
+        BOOL digit = c >= '0' && c <= '9';
+        BOOL word = digit || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        
+        switch (capture)
+        {
+            case MJAppLinkCaptureNumeric:
+                if (!digit)
+                    return NO;
+                break;
+            
+            case MJAppLinkCaptureAlphanumeric:
+                if (!word)
+                    return NO;
+                break;
+            
+            case MJAppLinkCaptureAlphanumericAndDash:
+                if (!word && c != ',' && c != '-')
+                    return NO;
+                break;
+        }
+    }
+    
+    return YES;
+}
+
 @end
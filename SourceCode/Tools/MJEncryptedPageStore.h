@@ -0,0 +1,132 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MJSecureKey;
+
+extern NSUInteger const MJEncryptedPageStoreDefaultPageSize;
+extern NSUInteger const MJEncryptedPageStoreDefaultPageCacheLimit;
+
+/**
+ * Read access to an encrypted file, page by page.
+ * @discussion The file is stored as a `NSDataAESChunkedCipher` container where each chunk is a page. The file is memory-mapped and pages are decrypted lazily, when accessed, and kept in a small plaintext page cache. This class is thread-safe.
+ **/
+@interface MJEncryptedPageStore : NSObject
+
+/** *************************************************** **
+ * @name Writing
+ ** *************************************************** **/
+
+/**
+ * Encrypts and writes data to a file using the default page size.
+ * @param data The data to write.
+ * @param url The file URL.
+ * @param secureKey The secure key used to encrypt.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ **/
++ (BOOL)writeData:(NSData*)data toURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey error:(NSError**)error;
+
+/**
+ * Encrypts and writes data to a file.
+ * @param data The data to write.
+ * @param url The file URL.
+ * @param secureKey The secure key used to encrypt.
+ * @param pageSize The page size. Must be a multiple of 16.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ * @discussion If the secure key cannot provide a key, nothing is written and the error is `kCCParamError`.
+ **/
++ (BOOL)writeData:(NSData*)data toURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey pageSize:(NSUInteger)pageSize error:(NSError**)error;
+
+/** *************************************************** **
+ * @name Initializers
+ ** *************************************************** **/
+
+/**
+ * Default static initializer.
+ * @param url The URL of a file written with `writeData:toURL:secureKey:error:`.
+ * @param secureKey The secure key used to decrypt.
+ * @return An initialized instance, nil if the file cannot be mapped or is not a valid store.
+ **/
++ (instancetype)storeWithURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey;
+
+/**
+ * Default initializer.
+ * @param url The URL of a file written with `writeData:toURL:secureKey:error:`.
+ * @param secureKey The secure key used to decrypt.
+ * @return The initialized instance, nil if the file cannot be mapped or is not a valid store.
+ **/
+- (id)initWithURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The plaintext length.
+ **/
+@property (nonatomic, assign, readonly) unsigned long long length;
+
+/**
+ * The page size.
+ **/
+@property (nonatomic, assign, readonly) NSUInteger pageSize;
+
+/**
+ * The number of pages.
+ **/
+@property (nonatomic, assign, readonly) NSUInteger numberOfPages;
+
+/**
+ * The maximum number of decrypted pages kept in memory. Default value is `MJEncryptedPageStoreDefaultPageCacheLimit`.
+ **/
+@property (nonatomic, assign) NSUInteger pageCacheLimit;
+
+/** *************************************************** **
+ * @name Reading
+ ** *************************************************** **/
+
+/**
+ * Returns a decrypted page.
+ * @param index The page index.
+ * @param error An error pointer.
+ * @return The plaintext of the page, nil if error.
+ **/
+- (NSData*)pageAtIndex:(NSUInteger)index error:(NSError**)error;
+
+/**
+ * Returns the plaintext in the given range. Only the pages that overlap the range are decrypted.
+ * @param range The plaintext range.
+ * @param error An error pointer.
+ * @return The plaintext, nil if error.
+ **/
+- (NSData*)dataInRange:(NSRange)range error:(NSError**)error;
+
+/**
+ * Decrypts the whole store.
+ * @param error An error pointer.
+ * @return The plaintext, nil if error.
+ **/
+- (NSData*)dataWithError:(NSError**)error;
+
+/**
+ * Removes all pages from the page cache.
+ **/
+- (void)purgePageCache;
+
+@end
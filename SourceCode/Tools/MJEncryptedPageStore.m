@@ -0,0 +1,173 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJEncryptedPageStore.h"
+
+#import "MJSecureKey.h"
+#import "NSDataAESCipher.h"
+#import "NSDataAESChunkedCipher.h"
+
+NSUInteger const MJEncryptedPageStoreDefaultPageSize        = 16 * 1024;
+NSUInteger const MJEncryptedPageStoreDefaultPageCacheLimit  = 16;
+
+@implementation MJEncryptedPageStore
+{
+    NSData *_container;
+    NSData *_key;
+    NSCache *_pageCache;
+}
+
++ (BOOL)writeData:(NSData*)data toURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey error:(NSError**)error
+{
+    return [self writeData:data toURL:url secureKey:secureKey pageSize:MJEncryptedPageStoreDefaultPageSize error:error];
+}
+
++ (BOOL)writeData:(NSData*)data toURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey pageSize:(NSUInteger)pageSize error:(NSError**)error
+{
+    NSData *key = [secureKey key];
+    
+    if (!key)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return NO;
+    }
+    
+    NSData *container = [NSDataAESChunkedCipher encryptData:data key:key chunkSize:pageSize error:error];
+    
+    if (!container)
+        return NO;
+    
+    return [container writeToURL:url options:NSDataWritingAtomic error:error];
+}
+
++ (instancetype)storeWithURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey
+{
+    return [[self alloc] initWithURL:url secureKey:secureKey];
+}
+
+- (id)initWithURL:(NSURL*)url secureKey:(MJSecureKey*)secureKey
+{
+    self = [super init];
+    if (self)
+    {
+        // Mapped, so only the pages being decrypted are read from disk.
+        _container = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedAlways error:nil];
+        
+        NSUInteger pageSize = 0;
+        unsigned long long length = 0;
+        
+        if (!_container || ![NSDataAESChunkedCipher readHeaderOfData:_container chunkSize:&pageSize length:&length])
+            return nil;
+        
+        _key = [secureKey key];
+        
+        if (!_key)
+            return nil;
+        
+        _pageSize = pageSize;
+        _length = length;
+        _numberOfPages = [NSDataAESChunkedCipher numberOfChunksOfData:_container];
+        
+        _pageCache = [[NSCache alloc] init];
+        _pageCache.countLimit = MJEncryptedPageStoreDefaultPageCacheLimit;
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (NSUInteger)pageCacheLimit
+{
+    return _pageCache.countLimit;
+}
+
+- (void)setPageCacheLimit:(NSUInteger)pageCacheLimit
+{
+    _pageCache.countLimit = pageCacheLimit;
+}
+
+#pragma mark Public Methods
+
+- (NSData*)pageAtIndex:(NSUInteger)index error:(NSError**)error
+{
+    NSNumber *cacheKey = @(index);
+    
+    NSData *page = [_pageCache objectForKey:cacheKey];
+    if (page)
+        return page;
+    
+    page = [NSDataAESChunkedCipher decryptChunkAtIndex:index ofData:_container key:_key error:error];
+    
+    if (page)
+        [_pageCache setObject:page forKey:cacheKey];
+    
+    return page;
+}
+
+- (NSData*)dataInRange:(NSRange)range error:(NSError**)error
+{
+    if ((unsigned long long)NSMaxRange(range) > _length)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return nil;
+    }
+    
+    if (range.length == 0)
+        return [NSData data];
+    
+    NSUInteger firstPage = range.location / _pageSize;
+    NSUInteger lastPage = (NSMaxRange(range) - 1) / _pageSize;
+    
+    if (firstPage == lastPage)
+    {
+        NSData *page = [self pageAtIndex:firstPage error:error];
+        if (!page)
+            return nil;
+        
+        return [page subdataWithRange:NSMakeRange(range.location - firstPage * _pageSize, range.length)];
+    }
+    
+    NSMutableData *data = [NSMutableData dataWithCapacity:range.length];
+    
+    for (NSUInteger index = firstPage; index <= lastPage; index++)
+    {
+        NSData *page = [self pageAtIndex:index error:error];
+        if (!page)
+            return nil;
+        
+        NSUInteger pageStart = index * _pageSize;
+        NSUInteger start = MAX(range.location, pageStart) - pageStart;
+        NSUInteger end = MIN(NSMaxRange(range), pageStart + page.length) - pageStart;
+        
+        [data appendBytes:(const uint8_t*)page.bytes + start length:end - start];
+    }
+    
+    return data;
+}
+
+- (NSData*)dataWithError:(NSError**)error
+{
+    return [NSDataAESChunkedCipher decryptData:_container key:_key error:error];
+}
+
+- (void)purgePageCache
+{
+    [_pageCache removeAllObjects];
+}
+
+@end
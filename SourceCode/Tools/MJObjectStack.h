@@ -20,6 +20,7 @@
 
 /**
  * An object stack.
+ * @discussion Objects are held weakly and identified by their `objectStackIdentity`. Pushing an object already in the stack moves it to the top. All operations run in constant time. Entries are removed as soon as their object is deallocated, using an associated object. `top` and `isTop:` don't take the stack lock unless the top object has been deallocated. This class is thread-safe.
  **/
 @interface MJObjectStack : NSObject
 
@@ -14,13 +14,68 @@
 // limitations under the License.
 //
 
-
 #import "MJObjectStack.h"
 
+#import <objc/runtime.h>
+
+@class MJObjectStackNode;
+
+@interface MJObjectStack ()
+
+- (void)mjz_removeNodeOfDeallocatedObject:(MJObjectStackNode*)node;
+
+@end
+
+/**
+ * A node of the stack, linked to the nodes below and above.
+ * @discussion Nodes are retained by the index only, so releasing a long stack doesn't release nodes recursively.
+ **/
+@interface MJObjectStackNode : NSObject
+
+@property (nonatomic, strong) NSString *key;
+@property (nonatomic, weak) id <MJObjectStackIdentity> object;
+@property (nonatomic, weak) MJObjectStackNode *below;
+@property (nonatomic, weak) MJObjectStackNode *above;
+
+@end
+
+@implementation MJObjectStackNode
+
+@end
+
+/**
+ * Object associated to the pushed objects. It is deallocated with the object, removing its node from the stack.
+ **/
+@interface MJObjectStackSentinel : NSObject
+
+@property (nonatomic, weak) MJObjectStack *stack;
+@property (nonatomic, weak) MJObjectStackNode *node;
+
+@end
+
+@implementation MJObjectStackSentinel
+
+- (void)dealloc
+{
+    MJObjectStackNode *node = _node;
+    
+    if (node)
+        [_stack mjz_removeNodeOfDeallocatedObject:node];
+}
+
+@end
+
+#pragma mark -
+
 @implementation MJObjectStack
 {
-    NSMutableArray <NSString*> *_stack;
-    NSMapTable <NSString*, id <MJObjectStackIdentity>> *_mapTable;
+    NSMutableDictionary <NSString*, MJObjectStackNode*> *_index;
+    MJObjectStackNode *_bottomNode;
+    MJObjectStackNode *_topNode;
+    
+    // Published top object, read without taking the lock.
+    __weak id <MJObjectStackIdentity> _top;
+    volatile BOOL _empty;
 }
 
 - (id)init
@@ -28,70 +83,87 @@
     self = [super init];
     if (self)
     {
-        _stack = [NSMutableArray array];
-        _mapTable = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory valueOptions:NSPointerFunctionsWeakMemory];
+        _index = [NSMutableDictionary dictionary];
+        _empty = YES;
     }
     return self;
 }
 
+- (void)dealloc
+{
+    // Sentinels of objects outliving the stack are detached.
+    [_index enumerateKeysAndObjectsUsingBlock:^(NSString *key, MJObjectStackNode *node, BOOL *stop) {
+        [self mjz_detachSentinelOfNode:node];
+    }];
+}
+
 #pragma mark Public Methods
 
 - (void)push:(nonnull id <MJObjectStackIdentity>)object
 {
-    [self mjz_updateStackFromDeallocatedObjects];
-    
     @synchronized(self)
     {
         NSString *key = [object objectStackIdentity];
         
-        [_stack addObject:key];
-        [_mapTable setObject:object forKey:key];
+        // Pushing an object already in the stack moves it to the top.
+        MJObjectStackNode *node = _index[key];
+        if (node)
+            [self mjz_unlinkNode:node];
+        
+        node = [[MJObjectStackNode alloc] init];
+        node.key = key;
+        node.object = object;
+        
+        MJObjectStackSentinel *sentinel = [[MJObjectStackSentinel alloc] init];
+        sentinel.stack = self;
+        sentinel.node = node;
+        
+        // The node address identifies the association, so an object can be in several stacks.
+        objc_setAssociatedObject(object, (__bridge const void *)node, sentinel, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+        
+        [self mjz_linkNodeOnTop:node];
+        [self mjz_publishTop];
     }
 }
 
 - (void)pop
 {
-    [self mjz_updateStackFromDeallocatedObjects];
-    
     @synchronized(self)
     {
-        NSString *key = [_stack lastObject];
+        [self mjz_removeDeallocatedTopNodes];
         
-        if (key)
-        {
-            [_mapTable removeObjectForKey:key];
-            [_stack removeLastObject];
-        }
+        if (_topNode)
+            [self mjz_unlinkNode:_topNode];
+        
+        [self mjz_publishTop];
     }
 }
 
 - (nullable id <MJObjectStackIdentity>)top
 {
-    [self mjz_updateStackFromDeallocatedObjects];
+    id <MJObjectStackIdentity> top = _top;
+    
+    if (top || _empty)
+        return top;
     
+    // The published top has been deallocated, find the new one.
     @synchronized(self)
     {
-        NSString *key = [_stack lastObject];
-        
-        if (key)
-            return [_mapTable objectForKey:key];
+        [self mjz_publishTop];
+        return _topNode.object;
     }
-    
-    return nil;
 }
 
 - (void)remove:(nonnull id <MJObjectStackIdentity>)object
 {
-    [self mjz_updateStackFromDeallocatedObjects];
-    
     @synchronized(self)
     {
-        NSString *key = [object objectStackIdentity];
+        MJObjectStackNode *node = _index[[object objectStackIdentity]];
         
-        if ([_mapTable objectForKey:key])
+        if (node)
         {
-            [_stack removeObject:key];
-            [_mapTable removeObjectForKey:key];
+            [self mjz_unlinkNode:node];
+            [self mjz_publishTop];
         }
     }
 }
@@ -107,29 +179,99 @@
 
 - (BOOL)contains:(nonnull id <MJObjectStackIdentity>)object
 {
-    NSString *key = [object objectStackIdentity];
-    return [_stack containsObject:key];
+    @synchronized(self)
+    {
+        NSString *key = [object objectStackIdentity];
+        MJObjectStackNode *node = _index[key];
+        
+        // Objects being deallocated are still in the index until their sentinel is released.
+        return node.object != nil;
+    }
 }
 
 #pragma mark Private Methods
 
-- (void)mjz_updateStackFromDeallocatedObjects
+- (void)mjz_removeNodeOfDeallocatedObject:(MJObjectStackNode*)node
 {
     @synchronized(self)
     {
-        if (_stack.count == _mapTable.count)
+        // The node could have been removed or replaced since.
+        if (_index[node.key] != node)
             return;
         
-        NSArray <NSString*> *stack = [_stack copy];
-        [stack  enumerateObjectsUsingBlock:^(NSString * _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-            if (![_mapTable objectForKey:obj])
-                [_stack removeObject:obj];
-        }];
+        [self mjz_unlinkNode:node];
+        [self mjz_publishTop];
     }
 }
 
-@end
+- (void)mjz_linkNodeOnTop:(MJObjectStackNode*)node
+{
+    node.below = _topNode;
+    node.above = nil;
+    
+    if (_topNode)
+        _topNode.above = node;
+    else
+        _bottomNode = node;
+    
+    _topNode = node;
+    _index[node.key] = node;
+}
+
+- (void)mjz_unlinkNode:(MJObjectStackNode*)node
+{
+    MJObjectStackNode *below = node.below;
+    MJObjectStackNode *above = node.above;
+    
+    if (below)
+        below.above = above;
+    else
+        _bottomNode = above;
+    
+    if (above)
+        above.below = below;
+    else
+        _topNode = below;
+    
+    node.below = nil;
+    node.above = nil;
+    
+    [self mjz_detachSentinelOfNode:node];
+    
+    if (_index[node.key] == node)
+        [_index removeObjectForKey:node.key];
+}
 
+- (void)mjz_detachSentinelOfNode:(MJObjectStackNode*)node
+{
+    id object = node.object;
+    
+    if (!object)
+        return;
+    
+    // The detached sentinel must not remove the node when released.
+    MJObjectStackSentinel *sentinel = objc_getAssociatedObject(object, (__bridge const void *)node);
+    sentinel.node = nil;
+    
+    objc_setAssociatedObject(object, (__bridge const void *)node, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (void)mjz_removeDeallocatedTopNodes
+{
+    // Sentinels remove the nodes of deallocated objects. This only covers objects still deallocating.
+    while (_topNode && !_topNode.object)
+        [self mjz_unlinkNode:_topNode];
+}
+
+- (void)mjz_publishTop
+{
+    [self mjz_removeDeallocatedTopNodes];
+    
+    _top = _topNode.object;
+    _empty = (_topNode == nil);
+}
+
+@end
 
 @implementation NSString (MJObjectStack)
 
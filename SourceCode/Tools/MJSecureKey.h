@@ -16,11 +16,31 @@
 
 #import <Foundation/Foundation.h>
 
+#import "MJSecureKeyStorage.h"
+
 /**
  * Secure key generation (keychain storage).
+ * @discussion Keys are cached in memory once read, per storage instance, so subsequent calls to `key` don't access the storage. The cache is invalidated when calling `reset` or `clear`. Key bytes are zeroed when the cached key data is released.
  **/
 @interface MJSecureKey : NSObject
 
+/**
+ * The storage used by secure keys created without an explicit storage. Default value is the shared `MJKeychainSecureKeyStorage`.
+ **/
++ (id <MJSecureKeyStorage>)defaultStorage;
+
+/**
+ * Sets the default storage.
+ * @param storage The storage. Passing nil restores the keychain storage.
+ **/
++ (void)setDefaultStorage:(id <MJSecureKeyStorage>)storage;
+
+/**
+ * Removes all the keys cached in memory.
+ * @discussion Use it if stored keys are modified externally.
+ **/
++ (void)invalidateCache;
+
 /**
  * Default static initializer.
  * @param identifier The identifier of the key.
@@ -37,6 +57,20 @@
  **/
 - (id)initWithIdentifier:(NSString*)identifier length:(size_t)length;
 
+/**
+ * Initializer with a custom storage.
+ * @param identifier The identifier of the key.
+ * @param length The length of the key.
+ * @param storage The storage where the key is persisted.
+ * @return The initialized instance.
+ **/
+- (id)initWithIdentifier:(NSString*)identifier length:(size_t)length storage:(id <MJSecureKeyStorage>)storage;
+
+/**
+ * The storage where the key is persisted.
+ **/
+@property (nonatomic, strong, readonly) id <MJSecureKeyStorage> storage;
+
 /**
  * Resets the stored key to a new random key.
  * @return YES if succeed, NO otherwise.
@@ -52,7 +86,7 @@
 /**
  * Returns the stored key or generates a new one if not stored.
  * @return The random key.
- * @discussion If error, the returned key is nil.
+ * @discussion A new key is generated only if the storage has no key for the identifier. If the storage cannot be read or the new key cannot be saved, the returned key is nil and nothing is cached, so the next call tries again.
  **/
 - (NSData*)key;
 
@@ -16,10 +16,118 @@
 
 #import "MJSecureKey.h"
 
+#import <Security/Security.h>
+#import <stdatomic.h>
+
+// Cached keys of each storage. Storages are weak keys compared by identity, so a new storage never sees the keys of a released one.
+static NSMapTable <id <MJSecureKeyStorage>, NSMutableDictionary <NSString*, NSData*>*> *_keyCache = nil;
+static atomic_llong _keyCacheGeneration = 0;
+static id <MJSecureKeyStorage> _defaultStorage = nil;
+
+static void MJSecureKeyZeroBytes(void *bytes, size_t length)
+{
+    // Volatile writes, so the compiler cannot drop them before the buffer is freed.
+    volatile uint8_t *pointer = bytes;
+    while (length--)
+        *pointer++ = 0;
+}
+
+static NSData* MJSecureKeyZeroingData(const void *bytes, size_t length)
+{
+    void *buffer = malloc(length);
+    memcpy(buffer, bytes, length);
+    
+    return [[NSData alloc] initWithBytesNoCopy:buffer length:length deallocator:^(void *bytes, NSUInteger length) {
+        MJSecureKeyZeroBytes(bytes, length);
+        free(bytes);
+    }];
+}
+
+static NSData* MJSecureKeyRandomData(size_t length)
+{
+    uint8_t buffer[length];
+    SecRandomCopyBytes(kSecRandomDefault, length, buffer);
+    NSData *keyData = MJSecureKeyZeroingData(buffer, length);
+    MJSecureKeyZeroBytes(buffer, length);
+    return keyData;
+}
+
+static int64_t MJSecureKeyCacheGeneration()
+{
+    return atomic_load(&_keyCacheGeneration);
+}
+
+/**
+ * A cached key along with the cache generation it was read in.
+ **/
+@interface MJSecureKeyCacheEntry : NSObject
+
+@property (nonatomic, strong, readonly) NSData *key;
+@property (nonatomic, assign, readonly) int64_t generation;
+
+@end
+
+@implementation MJSecureKeyCacheEntry
+
+- (id)initWithKey:(NSData*)key generation:(int64_t)generation
+{
+    self = [super init];
+    if (self)
+    {
+        _key = key;
+        _generation = generation;
+    }
+    return self;
+}
+
+@end
+
+@interface MJSecureKey ()
+
+// Atomic, so the fast path in `key` can read it without locking.
+@property (atomic, strong) MJSecureKeyCacheEntry *mjz_cacheEntry;
+
+@end
+
 @implementation MJSecureKey
 {
     NSString *_identifier;
     size_t _length;
+    NSString *_cacheKey;
+}
+
++ (void)initialize
+{
+    if (self == [MJSecureKey class])
+    {
+        _keyCache = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                          valueOptions:NSPointerFunctionsStrongMemory];
+    }
+}
+
++ (id <MJSecureKeyStorage>)defaultStorage
+{
+    @synchronized(self)
+    {
+        return _defaultStorage ?: [MJKeychainSecureKeyStorage sharedStorage];
+    }
+}
+
++ (void)setDefaultStorage:(id <MJSecureKeyStorage>)storage
+{
+    @synchronized(self)
+    {
+        _defaultStorage = storage;
+    }
+}
+
++ (void)invalidateCache
+{
+    @synchronized(_keyCache)
+    {
+        [_keyCache removeAllObjects];
+        atomic_fetch_add(&_keyCacheGeneration, 1);
+    }
 }
 
 + (MJSecureKey*)secureKeyWithIdentifier:(NSString*)identifier length:(size_t)length
@@ -29,74 +137,119 @@
 }
 
 - (id)initWithIdentifier:(NSString*)identifier length:(size_t)length
+{
+    return [self initWithIdentifier:identifier length:length storage:[MJSecureKey defaultStorage]];
+}
+
+- (id)initWithIdentifier:(NSString*)identifier length:(size_t)length storage:(id <MJSecureKeyStorage>)storage
 {
     self = [super init];
     if (self)
     {
         _identifier = identifier;
         _length = length;
+        _storage = storage;
+        
+        // Keys are shared between instances with the same identifier, length and storage.
+        _cacheKey = [NSString stringWithFormat:@"%zu.%@", length, identifier];
     }
     return self;
 }
 
 - (BOOL)reset
 {
-    NSData *tag = [_identifier dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *keyData = MJSecureKeyRandomData(_length);
     
-    uint8_t buffer[_length];
-    SecRandomCopyBytes(kSecRandomDefault, _length, buffer);
-    NSData *keyData = [[NSData alloc] initWithBytes:buffer length:sizeof(buffer)];
-    
-    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
-                            (__bridge id)kSecAttrApplicationTag: tag,
-                            };
-    
-    NSDictionary *attributesToUpdate = @{(__bridge id)kSecValueData: keyData};
-    
-    OSStatus status = SecItemUpdate((__bridge CFDictionaryRef)query, (__bridge CFDictionaryRef)attributesToUpdate);
-    
-    if (status == errSecSuccess)
-        return YES;
-    
-    return NO;
+    @synchronized(_keyCache)
+    {
+        BOOL succeed = [_storage updateKeyData:keyData forIdentifier:_identifier];
+        
+        if (succeed)
+            [self mjz_cachedKeys][_cacheKey] = keyData;
+        else
+            [[self mjz_cachedKeys] removeObjectForKey:_cacheKey];
+        
+        self.mjz_cacheEntry = nil;
+        atomic_fetch_add(&_keyCacheGeneration, 1);
+        
+        return succeed;
+    }
 }
 
 - (BOOL)clear
 {
-    NSData *tag = [_identifier dataUsingEncoding:NSUTF8StringEncoding];
-    
-    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
-                            (__bridge id)kSecAttrApplicationTag: tag,
-                            };
-    
-    OSStatus status = SecItemDelete((__bridge CFDictionaryRef)query);
-    
-    if (status == errSecSuccess)
-        return YES;
-    
-    return NO;
+    @synchronized(_keyCache)
+    {
+        BOOL succeed = [_storage removeKeyDataForIdentifier:_identifier];
+        
+        [[self mjz_cachedKeys] removeObjectForKey:_cacheKey];
+        
+        self.mjz_cacheEntry = nil;
+        atomic_fetch_add(&_keyCacheGeneration, 1);
+        
+        return succeed;
+    }
 }
 
 - (NSData*)key
 {
-    NSData *tag = [_identifier dataUsingEncoding:NSUTF8StringEncoding];
+    // Fast path: the key read by this instance is valid until any key is reset or cleared.
+    MJSecureKeyCacheEntry *entry = self.mjz_cacheEntry;
+    if (entry && entry.generation == MJSecureKeyCacheGeneration())
+        return entry.key;
     
-    // First check in the keychain for an existing key
-    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
-                            (__bridge id)kSecAttrApplicationTag: tag,
-                            (__bridge id)kSecAttrKeySizeInBits: @(_length),
-                            (__bridge id)kSecReturnData: @YES};
+    @synchronized(_keyCache)
+    {
+        int64_t generation = MJSecureKeyCacheGeneration();
+        
+        NSMutableDictionary *cachedKeys = [self mjz_cachedKeys];
+        NSData *keyData = cachedKeys[_cacheKey];
+        
+        if (!keyData)
+        {
+            // Only keys read from or saved to the storage are cached.
+            keyData = [self mjz_storedKey];
+            
+            if (keyData)
+                cachedKeys[_cacheKey] = keyData;
+        }
+        
+        if (keyData)
+            self.mjz_cacheEntry = [[MJSecureKeyCacheEntry alloc] initWithKey:keyData generation:generation];
+        
+        return keyData;
+    }
+}
+
+#pragma mark Private Methods
+
+- (NSMutableDictionary <NSString*, NSData*> *)mjz_cachedKeys
+{
+    // Called while locking the cache.
+    NSMutableDictionary *cachedKeys = [_keyCache objectForKey:_storage];
     
-    CFTypeRef dataRef = NULL;
-    OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)query, &dataRef);
+    if (!cachedKeys)
+    {
+        cachedKeys = [NSMutableDictionary dictionary];
+        [_keyCache setObject:cachedKeys forKey:_storage];
+    }
+    
+    return cachedKeys;
+}
+
+- (NSData*)mjz_storedKey
+{
+    // First check in the storage for an existing key
+    NSError *error = nil;
+    NSData *data = [_storage keyDataForIdentifier:_identifier length:_length error:&error];
     
-    if (status == errSecSuccess)
+    if (data)
     {
         // If reading is successful
-        NSData *data = (__bridge NSData *)dataRef;
-        return data;
+        NSData *keyData = MJSecureKeyZeroingData(data.bytes, data.length);
+        return keyData;
     }
-    else if (status == -25308 /*errKCInteractionNotAllowed*/)
+    else if (error.code == MJSecureKeyStorageInteractionNotAllowedErrorCode && [error.domain isEqualToString:MJSecureKeyStorageErrorDomain])
     {
         // If reading fails because app is not allowed
         // Fix cannot be applied because we cannot read the current keychain item.
@@ -108,29 +261,23 @@
         
         return nil;
     }
+    else if (error)
+    {
+        // The storage cannot be read: a new key would replace one that may exist.
+        return nil;
+    }
     else
     {
         // If no pre-existing key from this application
         
-        uint8_t buffer[_length];
-        SecRandomCopyBytes(kSecRandomDefault, _length, buffer);
-        NSData *keyData = [[NSData alloc] initWithBytes:buffer length:sizeof(buffer)];
+        NSData *keyData = MJSecureKeyRandomData(_length);
         
-        // Store the key in the keychain
-        query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
-                  (__bridge id)kSecAttrApplicationTag: tag,
-                  (__bridge id)kSecAttrKeySizeInBits: @(_length),
-                  (__bridge id)kSecAttrAccessible: (__bridge id)kSecAttrAccessibleAlways,
-                  (__bridge id)kSecValueData: keyData};
-        
-        status = SecItemAdd((__bridge CFDictionaryRef)query, NULL);
-        
-        NSAssert(status == errSecSuccess, @"Failed to insert new key in the keychain with OSStatus (%d)", (int)status);
+        // Store the key in the storage. A key that couldn't be saved must not be used.
+        if (![_storage addKeyData:keyData forIdentifier:_identifier length:_length])
+            return nil;
         
         return keyData;
     }
-    
-    return nil;
 }
 
 @end
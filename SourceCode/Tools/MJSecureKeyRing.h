@@ -0,0 +1,131 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MJSecureKeyStorage.h"
+
+/**
+ * Versioned set of secure keys.
+ * @discussion Rotating the key ring creates a new current key while keeping the previous ones, so data encrypted with older versions stays readable and can be re-encrypted lazily (see `NSData+AESKeyRing`).
+ *
+ * Version 1 is the key stored by `MJSecureKey` with the same identifier, so existing data remains readable when adopting a key ring. Further versions are stored as `<identifier>.v<version>` and the current version as `<identifier>.current`.
+ *
+ * Subkeys for each data domain are derived with HKDF-SHA256 from the key of a version, so they don't need extra storage items.
+ *
+ * This class is thread-safe. Use a single instance per identifier, as the current version is cached in memory.
+ **/
+@interface MJSecureKeyRing : NSObject
+
+/**
+ * Default static initializer.
+ * @param identifier The identifier of the key ring.
+ * @param length The length of the keys.
+ * @return An initialized instance.
+ **/
++ (MJSecureKeyRing*)keyRingWithIdentifier:(NSString*)identifier length:(size_t)length;
+
+/**
+ * Default initializer. Uses the `MJSecureKey` default storage.
+ * @param identifier The identifier of the key ring.
+ * @param length The length of the keys.
+ * @return The initialized instance.
+ **/
+- (id)initWithIdentifier:(NSString*)identifier length:(size_t)length;
+
+/**
+ * Initializer with a custom storage.
+ * @param identifier The identifier of the key ring.
+ * @param length The length of the keys.
+ * @param storage The storage where keys are persisted.
+ * @return The initialized instance.
+ **/
+- (id)initWithIdentifier:(NSString*)identifier length:(size_t)length storage:(id <MJSecureKeyStorage>)storage;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The identifier of the key ring.
+ **/
+@property (nonatomic, strong, readonly) NSString *identifier;
+
+/**
+ * The length of the keys.
+ **/
+@property (nonatomic, assign, readonly) size_t length;
+
+/**
+ * The storage where keys are persisted.
+ **/
+@property (nonatomic, strong, readonly) id <MJSecureKeyStorage> storage;
+
+/**
+ * The current key version. Versions start at 1.
+ * @discussion 0 if the version couldn't be read from the storage. It is read again on the next access.
+ **/
+@property (nonatomic, assign, readonly) uint32_t currentVersion;
+
+/** *************************************************** **
+ * @name Keys
+ ** *************************************************** **/
+
+/**
+ * Returns the key of the current version.
+ * @return The key.
+ **/
+- (NSData*)key;
+
+/**
+ * Returns the key of a version.
+ * @param version The version.
+ * @return The key, nil if the version is not valid.
+ **/
+- (NSData*)keyForVersion:(uint32_t)version;
+
+/**
+ * Returns the subkey of a data domain for the current version.
+ * @param domain The domain name.
+ * @return The subkey.
+ **/
+- (NSData*)keyForDomain:(NSString*)domain;
+
+/**
+ * Returns the subkey of a data domain for a version.
+ * @param domain The domain name. If nil, the key of the version is returned.
+ * @param version The version.
+ * @return The subkey, nil if the version is not valid.
+ **/
+- (NSData*)keyForDomain:(NSString*)domain version:(uint32_t)version;
+
+/** *************************************************** **
+ * @name Rotation
+ ** *************************************************** **/
+
+/**
+ * Creates a new random key and makes it the current one. Keys of previous versions are kept.
+ * @return The new current version, 0 if error.
+ **/
+- (uint32_t)rotate;
+
+/**
+ * Removes all the keys of the key ring, including version 1.
+ * @return YES if succeed, NO otherwise (also if the current version couldn't be read).
+ **/
+- (BOOL)clear;
+
+@end
@@ -0,0 +1,252 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJSecureKeyRing.h"
+
+#import <CommonCrypto/CommonHMAC.h>
+
+#import "MJSecureKey.h"
+
+static NSData* MJSecureKeyRingHKDF(NSData *inputKey, NSData *info, size_t length)
+{
+    // Extract, with an all-zero salt.
+    uint8_t salt[CC_SHA256_DIGEST_LENGTH] = {0};
+    uint8_t prk[CC_SHA256_DIGEST_LENGTH];
+    CCHmac(kCCHmacAlgSHA256, salt, sizeof(salt), inputKey.bytes, inputKey.length, prk);
+    
+    // Expand: T(i) = HMAC(PRK, T(i-1) | info | i)
+    NSMutableData *output = [NSMutableData dataWithCapacity:length];
+    uint8_t block[CC_SHA256_DIGEST_LENGTH];
+    size_t blockLength = 0;
+    
+    for (uint8_t counter = 1; output.length < length; counter++)
+    {
+        CCHmacContext context;
+        CCHmacInit(&context, kCCHmacAlgSHA256, prk, sizeof(prk));
+        CCHmacUpdate(&context, block, blockLength);
+        CCHmacUpdate(&context, info.bytes, info.length);
+        CCHmacUpdate(&context, &counter, 1);
+        CCHmacFinal(&context, block);
+        blockLength = sizeof(block);
+        
+        [output appendBytes:block length:MIN(blockLength, length - output.length)];
+    }
+    
+    memset(prk, 0, sizeof(prk));
+    memset(block, 0, sizeof(block));
+    
+    return output;
+}
+
+@implementation MJSecureKeyRing
+{
+    uint32_t _currentVersion;
+    NSMutableDictionary <NSNumber*, MJSecureKey*> *_secureKeys;
+    NSCache <NSString*, NSData*> *_domainKeys;
+}
+
++ (MJSecureKeyRing*)keyRingWithIdentifier:(NSString*)identifier length:(size_t)length
+{
+    MJSecureKeyRing *keyRing = [[MJSecureKeyRing alloc] initWithIdentifier:identifier length:length];
+    return keyRing;
+}
+
+- (id)initWithIdentifier:(NSString*)identifier length:(size_t)length
+{
+    return [self initWithIdentifier:identifier length:length storage:[MJSecureKey defaultStorage]];
+}
+
+- (id)initWithIdentifier:(NSString*)identifier length:(size_t)length storage:(id <MJSecureKeyStorage>)storage
+{
+    self = [super init];
+    if (self)
+    {
+        _identifier = identifier;
+        _length = length;
+        _storage = storage;
+        
+        _currentVersion = 0;
+        _secureKeys = [NSMutableDictionary dictionary];
+        _domainKeys = [[NSCache alloc] init];
+    }
+    return self;
+}
+
+#pragma mark Properties
+
+- (uint32_t)currentVersion
+{
+    @synchronized(self)
+    {
+        // A failed read returns 0, so it is retried on the next access.
+        if (_currentVersion == 0)
+            _currentVersion = [self mjz_storedCurrentVersion];
+        
+        return _currentVersion;
+    }
+}
+
+#pragma mark Public Methods
+
+- (NSData*)key
+{
+    return [self keyForVersion:self.currentVersion];
+}
+
+- (NSData*)keyForVersion:(uint32_t)version
+{
+    // Otherwise a new random key would be generated for it.
+    if (version == 0 || version > self.currentVersion)
+        return nil;
+    
+    MJSecureKey *secureKey = [self mjz_secureKeyForVersion:version];
+    return [secureKey key];
+}
+
+- (NSData*)keyForDomain:(NSString*)domain
+{
+    return [self keyForDomain:domain version:self.currentVersion];
+}
+
+- (NSData*)keyForDomain:(NSString*)domain version:(uint32_t)version
+{
+    if (!domain)
+        return [self keyForVersion:version];
+    
+    NSString *cacheKey = [NSString stringWithFormat:@"%u.%@", version, domain];
+    NSData *domainKey = [_domainKeys objectForKey:cacheKey];
+    
+    if (!domainKey)
+    {
+        NSData *key = [self keyForVersion:version];
+        if (!key)
+            return nil;
+        
+        domainKey = MJSecureKeyRingHKDF(key, [domain dataUsingEncoding:NSUTF8StringEncoding], _length);
+        [_domainKeys setObject:domainKey forKey:cacheKey];
+    }
+    
+    return domainKey;
+}
+
+- (uint32_t)rotate
+{
+    @synchronized(self)
+    {
+        uint32_t currentVersion = self.currentVersion;
+        if (currentVersion == 0)
+            return 0;
+        
+        uint32_t version = currentVersion + 1;
+        
+        // Creates and stores the key of the new version.
+        MJSecureKey *secureKey = [self mjz_secureKeyForVersion:version];
+        [secureKey reset];
+        if (![secureKey key])
+            return 0;
+        
+        uint8_t bytes[4] = {version >> 24, version >> 16, version >> 8, version};
+        NSData *versionData = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+        NSString *versionIdentifier = [self mjz_currentVersionIdentifier];
+        
+        if (![_storage updateKeyData:versionData forIdentifier:versionIdentifier] &&
+            ![_storage addKeyData:versionData forIdentifier:versionIdentifier length:sizeof(bytes)])
+        {
+            return 0;
+        }
+        
+        _currentVersion = version;
+        return version;
+    }
+}
+
+- (BOOL)clear
+{
+    @synchronized(self)
+    {
+        BOOL succeed = YES;
+        uint32_t currentVersion = self.currentVersion;
+        if (currentVersion == 0)
+            return NO;
+        
+        for (uint32_t version = 1; version <= currentVersion; version++)
+            succeed = [[self mjz_secureKeyForVersion:version] clear] && succeed;
+        
+        if (currentVersion > 1)
+            succeed = [_storage removeKeyDataForIdentifier:[self mjz_currentVersionIdentifier]] && succeed;
+        
+        _currentVersion = 0;
+        [_secureKeys removeAllObjects];
+        [_domainKeys removeAllObjects];
+        
+        return succeed;
+    }
+}
+
+#pragma mark Private Methods
+
+- (NSString*)mjz_currentVersionIdentifier
+{
+    return [_identifier stringByAppendingString:@".current"];
+}
+
+- (uint32_t)mjz_storedCurrentVersion
+{
+    NSError *error = nil;
+    NSData *data = [_storage keyDataForIdentifier:[self mjz_currentVersionIdentifier] length:4 error:&error];
+    
+    if (error)
+    {
+        // Same as MJSecureKey: guessing the version could encrypt with a retired key.
+        if (error.code == MJSecureKeyStorageInteractionNotAllowedErrorCode && [error.domain isEqualToString:MJSecureKeyStorageErrorDomain])
+        {
+            [[NSException exceptionWithName:@"PWInvalidKeychainAccess"
+                                     reason:@"The keychain couldn't be accessed because the device is locked."
+                                   userInfo:nil] raise];
+        }
+        
+        return 0;
+    }
+    
+    // Only a key ring that was never rotated has no current version item.
+    if (!data)
+        return 1;
+    
+    if (data.length != 4)
+        return 0;
+    
+    const uint8_t *bytes = data.bytes;
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+- (MJSecureKey*)mjz_secureKeyForVersion:(uint32_t)version
+{
+    @synchronized(self)
+    {
+        MJSecureKey *secureKey = _secureKeys[@(version)];
+        
+        if (!secureKey)
+        {
+            NSString *identifier = version == 1 ? _identifier : [NSString stringWithFormat:@"%@.v%u", _identifier, version];
+            secureKey = [[MJSecureKey alloc] initWithIdentifier:identifier length:_length storage:_storage];
+            _secureKeys[@(version)] = secureKey;
+        }
+        
+        return secureKey;
+    }
+}
+
+@end
@@ -0,0 +1,94 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const MJSecureKeyStorageErrorDomain;
+
+extern NSInteger const MJSecureKeyStorageInteractionNotAllowedErrorCode;
+extern NSInteger const MJSecureKeyStorageFailureErrorCode;
+
+/**
+ * Backend where secure keys are persisted.
+ **/
+@protocol MJSecureKeyStorage <NSObject>
+
+/**
+ * Reads a key.
+ * @param identifier The identifier of the key.
+ * @param length The length of the key.
+ * @param error An error pointer. Set only if the storage cannot be read. Use the `MJSecureKeyStorageInteractionNotAllowedErrorCode` code when the storage is temporarily locked.
+ * @return The key data, nil if not found or error.
+ **/
+- (NSData*)keyDataForIdentifier:(NSString*)identifier length:(size_t)length error:(NSError**)error;
+
+/**
+ * Stores a new key.
+ * @param keyData The key data.
+ * @param identifier The identifier of the key.
+ * @param length The length of the key.
+ * @return YES if succeed, NO otherwise (including if a key already exists for the identifier).
+ **/
+- (BOOL)addKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier length:(size_t)length;
+
+/**
+ * Replaces an existing key.
+ * @param keyData The new key data.
+ * @param identifier The identifier of the key.
+ * @return YES if succeed, NO otherwise (including if there is no key for the identifier).
+ **/
+- (BOOL)updateKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier;
+
+/**
+ * Removes a key.
+ * @param identifier The identifier of the key.
+ * @return YES if succeed, NO otherwise.
+ **/
+- (BOOL)removeKeyDataForIdentifier:(NSString*)identifier;
+
+@end
+
+/**
+ * Keychain storage. This is the default storage.
+ **/
+@interface MJKeychainSecureKeyStorage : NSObject <MJSecureKeyStorage>
+
+/**
+ * The shared keychain storage.
+ **/
++ (MJKeychainSecureKeyStorage*)sharedStorage;
+
+@end
+
+/**
+ * File storage. Each key is stored in a file inside a directory.
+ * @discussion Keys are stored unprotected. Intended as a stand-in for the keychain in tests, benchmarks and platforms without keychain.
+ **/
+@interface MJFileSecureKeyStorage : NSObject <MJSecureKeyStorage>
+
+/**
+ * Default initializer.
+ * @param directoryURL The directory where to store the keys. Created if needed.
+ * @return The initialized instance.
+ **/
+- (id)initWithDirectoryURL:(NSURL*)directoryURL;
+
+/**
+ * The directory where keys are stored.
+ **/
+@property (nonatomic, strong, readonly) NSURL *directoryURL;
+
+@end
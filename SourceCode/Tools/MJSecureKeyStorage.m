@@ -0,0 +1,205 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MJSecureKeyStorage.h"
+
+#import <Security/Security.h>
+
+NSString * const MJSecureKeyStorageErrorDomain = @"com.mobilejazz.MJSecureKeyStorage";
+
+NSInteger const MJSecureKeyStorageInteractionNotAllowedErrorCode    = 1;
+NSInteger const MJSecureKeyStorageFailureErrorCode                  = 2;
+
+@implementation MJKeychainSecureKeyStorage
+
++ (MJKeychainSecureKeyStorage*)sharedStorage
+{
+    static MJKeychainSecureKeyStorage *storage = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        storage = [[MJKeychainSecureKeyStorage alloc] init];
+    });
+    return storage;
+}
+
+- (NSData*)keyDataForIdentifier:(NSString*)identifier length:(size_t)length error:(NSError**)error
+{
+    NSData *tag = [identifier dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
+                            (__bridge id)kSecAttrApplicationTag: tag,
+                            (__bridge id)kSecAttrKeySizeInBits: @(length),
+                            (__bridge id)kSecReturnData: @YES};
+    
+    CFTypeRef dataRef = NULL;
+    OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)query, &dataRef);
+    
+    if (status == errSecSuccess)
+    {
+        return (__bridge_transfer NSData *)dataRef;
+    }
+    else if (status == -25308 /*errKCInteractionNotAllowed*/)
+    {
+        if (error)
+            *error = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain code:MJSecureKeyStorageInteractionNotAllowedErrorCode userInfo:nil];
+    }
+    else if (status != errSecItemNotFound)
+    {
+        if (error)
+            *error = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain
+                                         code:MJSecureKeyStorageFailureErrorCode
+                                     userInfo:@{NSUnderlyingErrorKey: [NSError errorWithDomain:NSOSStatusErrorDomain code:status userInfo:nil]}];
+    }
+    
+    return nil;
+}
+
+- (BOOL)addKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier length:(size_t)length
+{
+    NSData *tag = [identifier dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
+                            (__bridge id)kSecAttrApplicationTag: tag,
+                            (__bridge id)kSecAttrKeySizeInBits: @(length),
+                            (__bridge id)kSecAttrAccessible: (__bridge id)kSecAttrAccessibleAlways,
+                            (__bridge id)kSecValueData: keyData};
+    
+    OSStatus status = SecItemAdd((__bridge CFDictionaryRef)query, NULL);
+    
+    return status == errSecSuccess;
+}
+
+- (BOOL)updateKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier
+{
+    NSData *tag = [identifier dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
+                            (__bridge id)kSecAttrApplicationTag: tag,
+                            };
+    
+    NSDictionary *attributesToUpdate = @{(__bridge id)kSecValueData: keyData};
+    
+    OSStatus status = SecItemUpdate((__bridge CFDictionaryRef)query, (__bridge CFDictionaryRef)attributesToUpdate);
+    
+    return status == errSecSuccess;
+}
+
+- (BOOL)removeKeyDataForIdentifier:(NSString*)identifier
+{
+    NSData *tag = [identifier dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSDictionary *query = @{(__bridge id)kSecClass: (__bridge id)kSecClassKey,
+                            (__bridge id)kSecAttrApplicationTag: tag,
+                            };
+    
+    OSStatus status = SecItemDelete((__bridge CFDictionaryRef)query);
+    
+    return status == errSecSuccess;
+}
+
+@end
+
+#pragma mark -
+
+@implementation MJFileSecureKeyStorage
+
+- (id)init
+{
+    NSURL *directoryURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"com.mobilejazz.MJFileSecureKeyStorage"]];
+    return [self initWithDirectoryURL:directoryURL];
+}
+
+- (id)initWithDirectoryURL:(NSURL*)directoryURL
+{
+    self = [super init];
+    if (self)
+    {
+        _directoryURL = directoryURL;
+        
+        [[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:nil];
+    }
+    return self;
+}
+
+- (NSData*)keyDataForIdentifier:(NSString*)identifier length:(size_t)length error:(NSError**)error
+{
+    @synchronized(self)
+    {
+        NSURL *url = [self mjz_URLForIdentifier:identifier];
+        
+        if (![[NSFileManager defaultManager] fileExistsAtPath:url.path])
+            return nil;
+        
+        NSError *readError = nil;
+        NSData *data = [NSData dataWithContentsOfURL:url options:0 error:&readError];
+        
+        if (!data && error)
+            *error = [NSError errorWithDomain:MJSecureKeyStorageErrorDomain code:MJSecureKeyStorageFailureErrorCode userInfo:@{NSUnderlyingErrorKey: readError}];
+        
+        return data;
+    }
+}
+
+- (BOOL)addKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier length:(size_t)length
+{
+    @synchronized(self)
+    {
+        NSURL *url = [self mjz_URLForIdentifier:identifier];
+        
+        if ([[NSFileManager defaultManager] fileExistsAtPath:url.path])
+            return NO;
+        
+        return [keyData writeToURL:url options:NSDataWritingAtomic error:nil];
+    }
+}
+
+- (BOOL)updateKeyData:(NSData*)keyData forIdentifier:(NSString*)identifier
+{
+    @synchronized(self)
+    {
+        NSURL *url = [self mjz_URLForIdentifier:identifier];
+        
+        if (![[NSFileManager defaultManager] fileExistsAtPath:url.path])
+            return NO;
+        
+        return [keyData writeToURL:url options:NSDataWritingAtomic error:nil];
+    }
+}
+
+- (BOOL)removeKeyDataForIdentifier:(NSString*)identifier
+{
+    @synchronized(self)
+    {
+        return [[NSFileManager defaultManager] removeItemAtURL:[self mjz_URLForIdentifier:identifier] error:nil];
+    }
+}
+
+#pragma mark Private Methods
+
+- (NSURL*)mjz_URLForIdentifier:(NSString*)identifier
+{
+    // Hex encoded, so any identifier is a valid file name.
+    NSData *data = [identifier dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t *bytes = data.bytes;
+    
+    NSMutableString *fileName = [NSMutableString stringWithCapacity:data.length * 2];
+    for (NSUInteger i = 0; i < data.length; i++)
+        [fileName appendFormat:@"%02x", bytes[i]];
+    
+    return [_directoryURL URLByAppendingPathComponent:fileName];
+}
+
+@end
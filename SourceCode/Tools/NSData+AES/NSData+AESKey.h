@@ -28,6 +28,14 @@
 - (NSData*)aes_encryptValue:(NSData*)value;
 - (NSData*)aes_encryptValue:(NSData*)value usingPadding:(CCOptions)options;
 
+/**
+ * Encrypts a list of records reusing pooled cryptors (see `NSDataAESCryptorPool`).
+ * @param values An array of NSData values.
+ * @return An array with the encrypted values in the same order. Values that failed are replaced by `NSNull`.
+ **/
+- (NSArray*)aes_encryptRecords:(NSArray <NSData*> *)values;
+- (NSArray*)aes_encryptRecords:(NSArray <NSData*> *)values usingPadding:(CCOptions)options;
+
 /** *************************************************** **
  * @name Decrypt
  ** *************************************************** **/
@@ -35,4 +43,12 @@
 - (NSData*)aes_decryptValue:(NSData*)value;
 - (NSData*)aes_decryptValue:(NSData*)value usingPadding:(CCOptions)options;
 
+/**
+ * Decrypts a list of records reusing pooled cryptors (see `NSDataAESCryptorPool`).
+ * @param values An array of NSData values.
+ * @return An array with the decrypted values in the same order. Values that failed are replaced by `NSNull`.
+ **/
+- (NSArray*)aes_decryptRecords:(NSArray <NSData*> *)values;
+- (NSArray*)aes_decryptRecords:(NSArray <NSData*> *)values usingPadding:(CCOptions)options;
+
 @end
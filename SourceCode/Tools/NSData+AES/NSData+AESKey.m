@@ -16,6 +16,8 @@
 
 #import "NSData+AESKey.h"
 
+#import "NSDataAESCryptorPool.h"
+
 @implementation NSData (AESKey)
 
 - (NSData*)aes_encryptValue:(NSData*)value
@@ -28,6 +30,20 @@
     return [value aes_encrypt:self withPadding:options];
 }
 
+- (NSArray*)aes_encryptRecords:(NSArray <NSData*> *)values
+{
+    return [self aes_encryptRecords:values usingPadding:kCCOptionPKCS7Padding];
+}
+
+- (NSArray*)aes_encryptRecords:(NSArray <NSData*> *)values usingPadding:(CCOptions)options
+{
+    return [[NSDataAESCryptorPool sharedPool] cipherWithKey:self
+                                                    records:values
+                                                         iv:nil
+                                                  operation:kCCEncrypt
+                                                    options:options];
+}
+
 - (NSData*)aes_decryptValue:(NSData*)value
 {
     return [value aes_decrypt:self withPadding:kCCOptionPKCS7Padding];
@@ -38,4 +54,18 @@
     return [value aes_decrypt:self withPadding:options];
 }
 
+- (NSArray*)aes_decryptRecords:(NSArray <NSData*> *)values
+{
+    return [self aes_decryptRecords:values usingPadding:kCCOptionPKCS7Padding];
+}
+
+- (NSArray*)aes_decryptRecords:(NSArray <NSData*> *)values usingPadding:(CCOptions)options
+{
+    return [[NSDataAESCryptorPool sharedPool] cipherWithKey:self
+                                                    records:values
+                                                         iv:nil
+                                                  operation:kCCDecrypt
+                                                    options:options];
+}
+
 @end
@@ -0,0 +1,70 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NSData+AES.h"
+
+@class MJSecureKeyRing;
+
+extern NSUInteger const NSDataAESKeyRingHeaderLength;
+
+/**
+ * AES category on NSData to encrypt data with the keys of a `MJSecureKeyRing`.
+ * @discussion Encrypted data is prefixed with a header containing the version of the key used, so it can be decrypted after rotating the key ring. Header layout: format (1 byte), key version (4 bytes, big endian).
+ *
+ * Data encrypted with `aes_encrypt:` and the `MJSecureKey` key before adopting the key ring (no valid header) is decrypted with the key of version 1. As only its padding can be checked, it is never re-encrypted automatically: validate the plaintext and encrypt it again with `aes_encryptWithKeyRing:domain:` to migrate it. Data with a valid header is only decrypted with the key of its version.
+ **/
+@interface NSData (AESKeyRing)
+
+/** *************************************************** **
+ * @name Encrypt
+ ** *************************************************** **/
+
+/**
+ * Encrypts the data with the current key of the key ring.
+ * @param keyRing The key ring.
+ * @param domain The data domain used to derive the key. Can be nil.
+ * @return The encrypted data, including the header.
+ **/
+- (NSData*)aes_encryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain;
+
+/** *************************************************** **
+ * @name Decrypt
+ ** *************************************************** **/
+
+/**
+ * Decrypts data encrypted with any version of the key ring.
+ * @param keyRing The key ring.
+ * @param domain The data domain used to derive the key. Can be nil.
+ * @return The decrypted data, nil if error.
+ **/
+- (NSData*)aes_decryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain;
+
+/**
+ * Decrypts data encrypted with any version of the key ring, re-encrypting it if the version is not the current one.
+ * @param keyRing The key ring.
+ * @param domain The data domain used to derive the key. Can be nil.
+ * @param reencrypted On return, the data encrypted with the current key if the header version was an older one, nil otherwise. Store it in place of the original data to migrate it.
+ * @return The decrypted data, nil if error.
+ **/
+- (NSData*)aes_decryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain reencrypted:(NSData**)reencrypted;
+
+/**
+ * Returns the key version of data encrypted with a key ring.
+ * @return The key version, 0 if the header is not valid.
+ **/
+- (uint32_t)aes_keyRingVersion;
+
+@end
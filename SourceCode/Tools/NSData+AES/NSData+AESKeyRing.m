@@ -0,0 +1,103 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NSData+AESKeyRing.h"
+
+#import "MJSecureKeyRing.h"
+
+NSUInteger const NSDataAESKeyRingHeaderLength = 5;
+
+static uint8_t const NSDataAESKeyRingFormat = 1;
+
+@implementation NSData (AESKeyRing)
+
+- (NSData*)aes_encryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain
+{
+    uint32_t version = keyRing.currentVersion;
+    return [self mjz_aes_encryptWithKeyRing:keyRing domain:domain version:version];
+}
+
+- (NSData*)aes_decryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain
+{
+    return [self aes_decryptWithKeyRing:keyRing domain:domain reencrypted:NULL];
+}
+
+- (NSData*)aes_decryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain reencrypted:(NSData**)reencrypted
+{
+    if (reencrypted)
+        *reencrypted = nil;
+    
+    uint32_t version = [self aes_keyRingVersion];
+    uint32_t currentVersion = keyRing.currentVersion;
+    
+    if (version == 0 || version > currentVersion)
+    {
+        // Data encrypted before adopting the key ring has no valid header and was encrypted with the raw key that became version 1.
+        // The padding is the only check of the result, so it is never re-encrypted.
+        NSData *legacyKey = [keyRing keyForVersion:1];
+        if (!legacyKey)
+            return nil;
+        
+        return [self aes_decrypt:legacyKey withPadding:kCCOptionPKCS7Padding];
+    }
+    
+    NSData *key = [keyRing keyForDomain:domain version:version];
+    if (!key)
+        return nil;
+    
+    NSData *ciphertext = [self subdataWithRange:NSMakeRange(NSDataAESKeyRingHeaderLength, self.length - NSDataAESKeyRingHeaderLength)];
+    NSData *plaintext = [ciphertext aes_decrypt:key withPadding:kCCOptionPKCS7Padding];
+    
+    if (plaintext && reencrypted && version != currentVersion)
+        *reencrypted = [plaintext mjz_aes_encryptWithKeyRing:keyRing domain:domain version:currentVersion];
+    
+    return plaintext;
+}
+
+- (uint32_t)aes_keyRingVersion
+{
+    if (self.length < NSDataAESKeyRingHeaderLength)
+        return 0;
+    
+    const uint8_t *bytes = self.bytes;
+    if (bytes[0] != NSDataAESKeyRingFormat)
+        return 0;
+    
+    return ((uint32_t)bytes[1] << 24) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 8) | bytes[4];
+}
+
+#pragma mark Private Methods
+
+- (NSData*)mjz_aes_encryptWithKeyRing:(MJSecureKeyRing*)keyRing domain:(NSString*)domain version:(uint32_t)version
+{
+    NSData *key = [keyRing keyForDomain:domain version:version];
+    if (!key)
+        return nil;
+    
+    NSData *ciphertext = [self aes_encrypt:key withPadding:kCCOptionPKCS7Padding];
+    if (!ciphertext)
+        return nil;
+    
+    uint8_t header[5] = {NSDataAESKeyRingFormat, version >> 24, version >> 16, version >> 8, version};
+    
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + ciphertext.length];
+    [data appendBytes:header length:sizeof(header)];
+    [data appendData:ciphertext];
+    
+    return data;
+}
+
+@end
@@ -20,11 +20,26 @@ extern NSString * const NSDataSHAErrorDomain;
 extern NSInteger const NSDataSHA1ErrorCode;
 extern NSInteger const NSDataSHA256ErrorCode;
 
+/**
+ * NSData SHA hashing category.
+ * @discussion To hash large inputs without loading them in memory, use `NSDataSHAHasher`.
+ **/
 @interface NSData (SHA)
 
+/**
+ * Returns the SHA1 digest of the data.
+ * @return The 20 bytes long digest.
+ * @discussion Breaking change: previous versions returned only the first 16 bytes of the digest. Use `sha_SHA1Truncated` to compare with values computed by those versions.
+ **/
 - (NSData*)sha_SHA1;
 - (NSData*)sha_SHA1WithError:(NSError**)error;
 
+/**
+ * Returns the first 16 bytes of the SHA1 digest of the data, as returned by `sha_SHA1` in previous versions.
+ * @return The 16 bytes long truncated digest.
+ **/
+- (NSData*)sha_SHA1Truncated;
+
 - (NSData*)sha_SHA256;
 - (NSData*)sha_SHA256WithError:(NSError**)error;
 
@@ -31,7 +31,7 @@ NSInteger const NSDataSHA256ErrorCode   = 2;
 
 - (NSData*)sha_SHA1WithError:(NSError**)error
 {
-    NSMutableData *md = [NSMutableData dataWithLength:16];
+    NSMutableData *md = [NSMutableData dataWithLength:CC_SHA1_DIGEST_LENGTH];
     unsigned char *result = [md mutableBytes];
     if (result != CC_SHA1(self.bytes, (CC_LONG)self.length, result))
     {
@@ -41,6 +41,11 @@ NSInteger const NSDataSHA256ErrorCode   = 2;
     return md;
 }
 
+- (NSData*)sha_SHA1Truncated
+{
+    return [[self sha_SHA1] subdataWithRange:NSMakeRange(0, 16)];
+}
+
 - (NSData*)sha_SHA256
 {
     return [self sha_SHA256WithError:nil];
@@ -48,7 +53,7 @@ NSInteger const NSDataSHA256ErrorCode   = 2;
 
 - (NSData*)sha_SHA256WithError:(NSError**)error
 {
-    NSMutableData *md = [NSMutableData dataWithLength:32];
+    NSMutableData *md = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
     unsigned char *result = [md mutableBytes];
     if (result != CC_SHA256(self.bytes, (CC_LONG)self.length, result))
     {
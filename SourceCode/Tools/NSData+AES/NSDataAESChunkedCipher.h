@@ -0,0 +1,101 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSUInteger const NSDataAESChunkedCipherDefaultChunkSize;
+extern NSUInteger const NSDataAESChunkedCipherHeaderLength;
+extern NSUInteger const NSDataAESChunkedCipherTagLength;
+
+/**
+ * Chunked AES container.
+ * @discussion The plaintext is split in fixed-size chunks, each one encrypted with AES-CTR and authenticated with its own HMAC-SHA256 tag. Chunks are independent, so they are encrypted and decrypted concurrently and any of them can be decrypted alone.
+ *
+ * Container layout (integers are big endian):
+ * - Header: magic "MJAC" (4 bytes), version (4 bytes), chunk size (4 bytes), reserved (4 bytes), plaintext length (8 bytes), nonce (8 bytes).
+ * - Chunks: for each chunk, the ciphertext followed by its tag. Only the last chunk can be shorter than the chunk size. Empty data is stored as a single empty chunk, so the header is always authenticated.
+ *
+ * Containers can be read from memory-mapped files (`NSDataReadingMappedIfSafe`), so decrypting one chunk only touches the pages of that chunk.
+ **/
+@interface NSDataAESChunkedCipher : NSObject
+
+/** *************************************************** **
+ * @name Encrypt
+ ** *************************************************** **/
+
+/**
+ * Encrypts the data into a chunked container using the default chunk size.
+ * @param data The data to encrypt.
+ * @param key The key. Cannot be nil nor empty.
+ * @param error An error pointer.
+ * @return The container, nil if error.
+ **/
++ (NSData*)encryptData:(NSData*)data key:(NSData*)key error:(NSError**)error;
+
+/**
+ * Encrypts the data into a chunked container.
+ * @param data The data to encrypt.
+ * @param key The key. Cannot be nil nor empty.
+ * @param chunkSize The chunk size. Must be a non-zero multiple of the AES block size.
+ * @param error An error pointer.
+ * @return The container, nil if error.
+ **/
++ (NSData*)encryptData:(NSData*)data key:(NSData*)key chunkSize:(NSUInteger)chunkSize error:(NSError**)error;
+
+/** *************************************************** **
+ * @name Decrypt
+ ** *************************************************** **/
+
+/**
+ * Decrypts a whole chunked container.
+ * @param container The container.
+ * @param key The key. Cannot be nil nor empty.
+ * @param error An error pointer.
+ * @return The plaintext, nil if error or if any chunk fails authentication.
+ **/
++ (NSData*)decryptData:(NSData*)container key:(NSData*)key error:(NSError**)error;
+
+/**
+ * Decrypts a single chunk of a container.
+ * @param index The chunk index.
+ * @param container The container.
+ * @param key The key. Cannot be nil nor empty.
+ * @param error An error pointer.
+ * @return The plaintext of the chunk, nil if error or if the chunk fails authentication.
+ **/
++ (NSData*)decryptChunkAtIndex:(NSUInteger)index ofData:(NSData*)container key:(NSData*)key error:(NSError**)error;
+
+/** *************************************************** **
+ * @name Container information
+ ** *************************************************** **/
+
+/**
+ * Reads the container header.
+ * @param container The container.
+ * @param chunkSize On return, the chunk size. Can be NULL.
+ * @param length On return, the plaintext length. Can be NULL.
+ * @return YES if the header is valid, NO otherwise.
+ **/
++ (BOOL)readHeaderOfData:(NSData*)container chunkSize:(NSUInteger*)chunkSize length:(unsigned long long*)length;
+
+/**
+ * Returns the number of chunks of a container.
+ * @param container The container.
+ * @return The number of chunks, zero if the container is not valid.
+ **/
++ (NSUInteger)numberOfChunksOfData:(NSData*)container;
+
+@end
@@ -0,0 +1,436 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NSDataAESChunkedCipher.h"
+
+#import <CommonCrypto/CommonCryptor.h>
+#import <CommonCrypto/CommonHMAC.h>
+#import <Security/Security.h>
+
+#import "NSDataAESCipher.h"
+
+NSUInteger const NSDataAESChunkedCipherDefaultChunkSize = 64 * 1024;
+NSUInteger const NSDataAESChunkedCipherHeaderLength     = 32;
+NSUInteger const NSDataAESChunkedCipherTagLength        = CC_SHA256_DIGEST_LENGTH;
+
+static uint8_t const NSDataAESChunkedCipherMagic[4]     = {'M', 'J', 'A', 'C'};
+static uint32_t const NSDataAESChunkedCipherVersion     = 1;
+static size_t const NSDataAESChunkedCipherNonceLength   = 8;
+
+static char const NSDataAESChunkedCipherEncryptionLabel[]       = "com.mobilejazz.NSDataAESChunkedCipher.encryption";
+static char const NSDataAESChunkedCipherAuthenticationLabel[]   = "com.mobilejazz.NSDataAESChunkedCipher.authentication";
+
+#pragma mark - Helpers
+
+static void NSDataAESChunkedCipherWriteUInt32(uint8_t *bytes, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        bytes[i] = (uint8_t)(value >> (8 * (3 - i)));
+}
+
+static void NSDataAESChunkedCipherWriteUInt64(uint8_t *bytes, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        bytes[i] = (uint8_t)(value >> (8 * (7 - i)));
+}
+
+static uint32_t NSDataAESChunkedCipherReadUInt32(const uint8_t *bytes)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static uint64_t NSDataAESChunkedCipherReadUInt64(const uint8_t *bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static CCCryptorStatus NSDataAESChunkedCipherCryptChunk(const uint8_t *key,
+                                                        const uint8_t *nonce,
+                                                        NSUInteger chunkSize,
+                                                        NSUInteger index,
+                                                        const uint8_t *input,
+                                                        size_t length,
+                                                        uint8_t *output)
+{
+    // Counter block: nonce followed by the index of the first AES block of the chunk.
+    uint8_t counter[kCCBlockSizeAES128];
+    memcpy(counter, nonce, NSDataAESChunkedCipherNonceLength);
+    NSDataAESChunkedCipherWriteUInt64(counter + NSDataAESChunkedCipherNonceLength, (uint64_t)index * (chunkSize / kCCBlockSizeAES128));
+    
+    CCCryptorRef cryptor = NULL;
+    CCCryptorStatus status = CCCryptorCreateWithMode(kCCEncrypt,
+                                                     kCCModeCTR,
+                                                     kCCAlgorithmAES,
+                                                     ccNoPadding,
+                                                     counter,
+                                                     key,
+                                                     kCCKeySizeAES256,
+                                                     NULL,
+                                                     0,
+                                                     0,
+                                                     kCCModeOptionCTR_BE,
+                                                     &cryptor);
+    
+    if (status != kCCSuccess)
+        return status;
+    
+    size_t moved = 0;
+    status = CCCryptorUpdate(cryptor, input, length, output, length, &moved);
+    CCCryptorRelease(cryptor);
+    
+    return status;
+}
+
+static void NSDataAESChunkedCipherTagChunk(const uint8_t *macKey,
+                                           const uint8_t *header,
+                                           NSUInteger index,
+                                           const uint8_t *ciphertext,
+                                           size_t length,
+                                           uint8_t *tag)
+{
+    // The tag covers the header and the chunk index, so chunks cannot be moved nor swapped between containers.
+    uint8_t indexBytes[8];
+    NSDataAESChunkedCipherWriteUInt64(indexBytes, index);
+    
+    CCHmacContext context;
+    CCHmacInit(&context, kCCHmacAlgSHA256, macKey, CC_SHA256_DIGEST_LENGTH);
+    CCHmacUpdate(&context, header, NSDataAESChunkedCipherHeaderLength);
+    CCHmacUpdate(&context, indexBytes, sizeof(indexBytes));
+    CCHmacUpdate(&context, ciphertext, length);
+    CCHmacFinal(&context, tag);
+}
+
+static NSUInteger NSDataAESChunkedCipherChunkCount(unsigned long long length, NSUInteger chunkSize)
+{
+    // Empty data still has one empty chunk, so the header is always authenticated.
+    if (length == 0)
+        return 1;
+    
+    return (NSUInteger)((length + chunkSize - 1) / chunkSize);
+}
+
+static CCCryptorStatus NSDataAESChunkedCipherFirstFailure(const CCCryptorStatus *statuses, NSUInteger count)
+{
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        if (statuses[i] != kCCSuccess)
+            return statuses[i];
+    }
+    return kCCSuccess;
+}
+
+static BOOL NSDataAESChunkedCipherEqualTags(const uint8_t *tag1, const uint8_t *tag2)
+{
+    // Constant time comparison.
+    uint8_t difference = 0;
+    for (NSUInteger i = 0; i < NSDataAESChunkedCipherTagLength; i++)
+        difference |= tag1[i] ^ tag2[i];
+    return difference == 0;
+}
+
+#pragma mark -
+
+@implementation NSDataAESChunkedCipher
+
++ (NSData*)encryptData:(NSData*)data key:(NSData*)key error:(NSError**)error
+{
+    return [self encryptData:data key:key chunkSize:NSDataAESChunkedCipherDefaultChunkSize error:error];
+}
+
++ (NSData*)encryptData:(NSData*)data key:(NSData*)key chunkSize:(NSUInteger)chunkSize error:(NSError**)error
+{
+    if (key.length == 0 || chunkSize == 0 || chunkSize % kCCBlockSizeAES128 != 0 || chunkSize > UINT32_MAX)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return nil;
+    }
+    
+    NSUInteger length = data.length;
+    NSUInteger chunkCount = NSDataAESChunkedCipherChunkCount(length, chunkSize);
+    
+    NSMutableData *container = [NSMutableData dataWithLength:NSDataAESChunkedCipherHeaderLength + length + chunkCount * NSDataAESChunkedCipherTagLength];
+    uint8_t *output = container.mutableBytes;
+    const uint8_t *input = data.bytes;
+    
+    // Header
+    memcpy(output, NSDataAESChunkedCipherMagic, sizeof(NSDataAESChunkedCipherMagic));
+    NSDataAESChunkedCipherWriteUInt32(output + 4, NSDataAESChunkedCipherVersion);
+    NSDataAESChunkedCipherWriteUInt32(output + 8, (uint32_t)chunkSize);
+    NSDataAESChunkedCipherWriteUInt64(output + 16, length);
+    
+    uint8_t *nonce = output + 24;
+    if (SecRandomCopyBytes(kSecRandomDefault, NSDataAESChunkedCipherNonceLength, nonce) != 0)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCRNGFailure];
+        return nil;
+    }
+    
+    uint8_t encryptionKey[CC_SHA256_DIGEST_LENGTH];
+    uint8_t macKey[CC_SHA256_DIGEST_LENGTH];
+    [self mjz_deriveKeysFromKey:key encryptionKey:encryptionKey macKey:macKey];
+    
+    const uint8_t *header = output;
+    const uint8_t *encryptionKeyBytes = encryptionKey;
+    const uint8_t *macKeyBytes = macKey;
+    
+    // Each chunk records its own status, so workers never write to the same memory.
+    NSMutableData *statuses = [NSMutableData dataWithLength:chunkCount * sizeof(CCCryptorStatus)];
+    CCCryptorStatus *chunkStatuses = statuses.mutableBytes;
+    
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        
+        NSUInteger plainOffset = index * chunkSize;
+        size_t chunkLength = MIN(chunkSize, length - plainOffset);
+        uint8_t *chunk = output + NSDataAESChunkedCipherHeaderLength + index * (chunkSize + NSDataAESChunkedCipherTagLength);
+        
+        if (chunkLength > 0)
+        {
+            CCCryptorStatus status = NSDataAESChunkedCipherCryptChunk(encryptionKeyBytes, nonce, chunkSize, index, input + plainOffset, chunkLength, chunk);
+            
+            if (status != kCCSuccess)
+            {
+                chunkStatuses[index] = status;
+                return;
+            }
+        }
+        
+        NSDataAESChunkedCipherTagChunk(macKeyBytes, header, index, chunk, chunkLength, chunk + chunkLength);
+    });
+    
+    memset(encryptionKey, 0, sizeof(encryptionKey));
+    memset(macKey, 0, sizeof(macKey));
+    
+    CCCryptorStatus failure = NSDataAESChunkedCipherFirstFailure(chunkStatuses, chunkCount);
+    
+    if (failure != kCCSuccess)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:failure];
+        return nil;
+    }
+    
+    return container;
+}
+
++ (NSData*)decryptData:(NSData*)container key:(NSData*)key error:(NSError**)error
+{
+    if (key.length == 0)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return nil;
+    }
+    
+    NSUInteger chunkSize = 0;
+    unsigned long long length = 0;
+    
+    if (![self readHeaderOfData:container chunkSize:&chunkSize length:&length])
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCDecodeError];
+        return nil;
+    }
+    
+    uint8_t encryptionKey[CC_SHA256_DIGEST_LENGTH];
+    uint8_t macKey[CC_SHA256_DIGEST_LENGTH];
+    [self mjz_deriveKeysFromKey:key encryptionKey:encryptionKey macKey:macKey];
+    
+    NSUInteger chunkCount = NSDataAESChunkedCipherChunkCount(length, chunkSize);
+    
+    NSMutableData *data = [NSMutableData dataWithLength:(NSUInteger)length];
+    uint8_t *output = data.mutableBytes;
+    const uint8_t *header = container.bytes;
+    const uint8_t *nonce = header + 24;
+    const uint8_t *encryptionKeyBytes = encryptionKey;
+    const uint8_t *macKeyBytes = macKey;
+    
+    // Each chunk records its own status, so workers never write to the same memory.
+    NSMutableData *statuses = [NSMutableData dataWithLength:chunkCount * sizeof(CCCryptorStatus)];
+    CCCryptorStatus *chunkStatuses = statuses.mutableBytes;
+    
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        
+        NSUInteger plainOffset = index * chunkSize;
+        size_t chunkLength = (size_t)MIN((unsigned long long)chunkSize, length - plainOffset);
+        const uint8_t *chunk = header + NSDataAESChunkedCipherHeaderLength + index * (chunkSize + NSDataAESChunkedCipherTagLength);
+        
+        uint8_t tag[CC_SHA256_DIGEST_LENGTH];
+        NSDataAESChunkedCipherTagChunk(macKeyBytes, header, index, chunk, chunkLength, tag);
+        
+        if (!NSDataAESChunkedCipherEqualTags(tag, chunk + chunkLength))
+        {
+            chunkStatuses[index] = kCCDecodeError;
+            return;
+        }
+        
+        if (chunkLength > 0)
+            chunkStatuses[index] = NSDataAESChunkedCipherCryptChunk(encryptionKeyBytes, nonce, chunkSize, index, chunk, chunkLength, output + plainOffset);
+    });
+    
+    memset(encryptionKey, 0, sizeof(encryptionKey));
+    memset(macKey, 0, sizeof(macKey));
+    
+    CCCryptorStatus failure = NSDataAESChunkedCipherFirstFailure(chunkStatuses, chunkCount);
+    
+    if (failure != kCCSuccess)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:failure];
+        return nil;
+    }
+    
+    return data;
+}
+
++ (NSData*)decryptChunkAtIndex:(NSUInteger)index ofData:(NSData*)container key:(NSData*)key error:(NSError**)error
+{
+    if (key.length == 0)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return nil;
+    }
+    
+    NSUInteger chunkSize = 0;
+    unsigned long long length = 0;
+    
+    if (![self readHeaderOfData:container chunkSize:&chunkSize length:&length])
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCDecodeError];
+        return nil;
+    }
+    
+    NSUInteger chunkCount = NSDataAESChunkedCipherChunkCount(length, chunkSize);
+    
+    if (index >= chunkCount)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return nil;
+    }
+    
+    uint8_t encryptionKey[CC_SHA256_DIGEST_LENGTH];
+    uint8_t macKey[CC_SHA256_DIGEST_LENGTH];
+    [self mjz_deriveKeysFromKey:key encryptionKey:encryptionKey macKey:macKey];
+    
+    const uint8_t *header = container.bytes;
+    size_t chunkLength = (size_t)MIN((unsigned long long)chunkSize, length - (unsigned long long)index * chunkSize);
+    const uint8_t *chunk = header + NSDataAESChunkedCipherHeaderLength + index * (chunkSize + NSDataAESChunkedCipherTagLength);
+    
+    CCCryptorStatus status = kCCSuccess;
+    NSMutableData *data = nil;
+    
+    uint8_t tag[CC_SHA256_DIGEST_LENGTH];
+    NSDataAESChunkedCipherTagChunk(macKey, header, index, chunk, chunkLength, tag);
+    
+    if (NSDataAESChunkedCipherEqualTags(tag, chunk + chunkLength))
+    {
+        data = [NSMutableData dataWithLength:chunkLength];
+        if (chunkLength > 0)
+            status = NSDataAESChunkedCipherCryptChunk(encryptionKey, header + 24, chunkSize, index, chunk, chunkLength, data.mutableBytes);
+    }
+    else
+    {
+        status = kCCDecodeError;
+    }
+    
+    memset(encryptionKey, 0, sizeof(encryptionKey));
+    memset(macKey, 0, sizeof(macKey));
+    
+    if (status != kCCSuccess)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:status];
+        return nil;
+    }
+    
+    return data;
+}
+
++ (BOOL)readHeaderOfData:(NSData*)container chunkSize:(NSUInteger*)chunkSize length:(unsigned long long*)length
+{
+    if (container.length < NSDataAESChunkedCipherHeaderLength)
+        return NO;
+    
+    const uint8_t *bytes = container.bytes;
+    
+    if (memcmp(bytes, NSDataAESChunkedCipherMagic, sizeof(NSDataAESChunkedCipherMagic)) != 0)
+        return NO;
+    
+    if (NSDataAESChunkedCipherReadUInt32(bytes + 4) != NSDataAESChunkedCipherVersion)
+        return NO;
+    
+    uint32_t size = NSDataAESChunkedCipherReadUInt32(bytes + 8);
+    uint64_t plainLength = NSDataAESChunkedCipherReadUInt64(bytes + 16);
+    
+    if (size == 0 || size % kCCBlockSizeAES128 != 0)
+        return NO;
+    
+    if (plainLength > (uint64_t)container.length)
+        return NO;
+    
+    // The container must hold exactly the expected chunks and tags.
+    uint64_t chunkCount = plainLength == 0 ? 1 : (plainLength + size - 1) / size;
+    
+    if ((uint64_t)container.length != NSDataAESChunkedCipherHeaderLength + plainLength + chunkCount * NSDataAESChunkedCipherTagLength)
+        return NO;
+    
+    if (chunkSize)
+        *chunkSize = size;
+    
+    if (length)
+        *length = plainLength;
+    
+    return YES;
+}
+
++ (NSUInteger)numberOfChunksOfData:(NSData*)container
+{
+    NSUInteger chunkSize = 0;
+    unsigned long long length = 0;
+    
+    if (![self readHeaderOfData:container chunkSize:&chunkSize length:&length])
+        return 0;
+    
+    return NSDataAESChunkedCipherChunkCount(length, chunkSize);
+}
+
+#pragma mark Private Methods
+
++ (void)mjz_deriveKeysFromKey:(NSData*)key encryptionKey:(uint8_t*)encryptionKey macKey:(uint8_t*)macKey
+{
+    // Independent subkeys for encryption and authentication.
+    NSData *cipherKey = [NSDataAESCipher cipherKeyForKey:key];
+    
+    CCHmac(kCCHmacAlgSHA256, cipherKey.bytes, cipherKey.length,
+           NSDataAESChunkedCipherEncryptionLabel, strlen(NSDataAESChunkedCipherEncryptionLabel),
+           encryptionKey);
+    
+    CCHmac(kCCHmacAlgSHA256, cipherKey.bytes, cipherKey.length,
+           NSDataAESChunkedCipherAuthenticationLabel, strlen(NSDataAESChunkedCipherAuthenticationLabel),
+           macKey);
+}
+
+@end
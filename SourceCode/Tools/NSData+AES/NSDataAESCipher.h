@@ -19,11 +19,55 @@ extern NSInteger const NSDataAESCipherAlignmentErrorCode;
 extern NSInteger const NSDataAESCipherDecodeErrorCode;
 extern NSInteger const NSDataAESCipherCUnimplementedErrorCode;
 
+extern NSUInteger const NSDataAESCipherIVCacheDefaultLimit;
+
 /**
  * Cipher NSData handler
  **/
 @interface NSDataAESCipher : NSObject
 
+/** *************************************************** **
+ * @name Key derivation
+ ** *************************************************** **/
+
+/**
+ * Returns the AES256 key to be used for the given key.
+ * @param key The user key.
+ * @return The key itself if it is already 256 bits long, its SHA256 otherwise.
+ * @discussion Derived keys are not cached, so secrets are never retained by this class. When encrypting many records with the same key that is not 256 bits long, derive it once with this method and use the returned key instead.
+ **/
++ (NSData*)cipherKeyForKey:(NSData*)key;
+
+/**
+ * Returns the initialization vector to be used for the given iv.
+ * @param iv The user initialization vector.
+ * @return The SHA1 of the iv if it is not block sized, a zeroed block otherwise.
+ **/
++ (NSData*)cipherIVForIV:(NSData*)iv;
+
+/**
+ * Sets the maximum number of derived initialization vectors kept in memory.
+ * @param limit The maximum number of entries. Default value is `NSDataAESCipherIVCacheDefaultLimit`. Zero disables the cache.
+ * @discussion Initialization vectors that are not block sized are hashed once and then served from this cache. Keys are never cached (see `cipherKeyForKey:`).
+ **/
++ (void)setIVCacheLimit:(NSUInteger)limit;
+
+/**
+ * Removes all cached derived initialization vectors.
+ **/
++ (void)clearIVCache;
+
+/**
+ * Returns the error associated to a CommonCrypto status.
+ * @param status The cryptor status.
+ * @return An error in the `NSDataAESCipherErrorDomain`, nil if the status is `kCCSuccess`.
+ **/
++ (NSError*)errorForStatus:(CCCryptorStatus)status;
+
+/** *************************************************** **
+ * @name Cipher
+ ** *************************************************** **/
+
 + (NSData*)cipherWithkey:(NSData*)key
                    value:(NSData*)value
                       iv:(NSData*)iv
@@ -32,4 +76,22 @@ extern NSInteger const NSDataAESCipherCUnimplementedErrorCode;
                   output:(NSMutableData*)output
                    error:(NSError**)error;
 
-@end
\ No newline at end of file
+/**
+ * Ciphers the given data in place.
+ * @param key The key.
+ * @param data The data to cipher. The ciphered bytes are written directly in its `mutableBytes`.
+ * @param iv The initialization vector. Can be nil.
+ * @param operation The cipher operation.
+ * @param options The cipher options.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ * @discussion When encrypting with padding, the data grows by at most one block. If the operation fails, the data is emptied.
+ **/
++ (BOOL)cipherInPlaceWithKey:(NSData*)key
+                        data:(NSMutableData*)data
+                          iv:(NSData*)iv
+                   operation:(CCOperation)operation
+                     options:(CCOptions)options
+                       error:(NSError**)error;
+
+@end
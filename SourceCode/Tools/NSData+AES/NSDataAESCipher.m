@@ -8,6 +8,8 @@
 
 #import "NSDataAESCipher.h"
 
+#import <stdatomic.h>
+
 #import "NSData+SHA.h"
 
 NSString * NSDataAESCipherErrorDomain = @"com.mobilejazz.NSDataAESCipher";
@@ -20,8 +22,101 @@ NSInteger const NSDataAESCipherAlignmentErrorCode       = kCCAlignmentError;
 NSInteger const NSDataAESCipherDecodeErrorCode          = kCCDecodeError;
 NSInteger const NSDataAESCipherCUnimplementedErrorCode  = kCCUnimplemented;
 
+NSUInteger const NSDataAESCipherIVCacheDefaultLimit = 64;
+
+static NSCache *_ivCache;
+static NSData *_zeroIV;
+static atomic_bool _ivCacheEnabled = YES;
+
 @implementation NSDataAESCipher
 
++ (void)initialize
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _ivCache = [[NSCache alloc] init];
+        _ivCache.countLimit = NSDataAESCipherIVCacheDefaultLimit;
+        
+        _zeroIV = [NSData dataWithBytes:(uint8_t[kCCBlockSizeAES128]){0} length:kCCBlockSizeAES128];
+    });
+}
+
++ (NSData*)cipherKeyForKey:(NSData*)key
+{
+    if (kCCKeySizeAES256 != key.length)
+    {
+        // SHA256 the key unless it's already 256 bits.
+        // Not cached: a process-wide cache would keep copies of the secrets in memory.
+        key = [key sha_SHA256];
+    }
+    
+    return key;
+}
+
++ (NSData*)cipherIVForIV:(NSData*)iv
+{
+    if (iv && kCCBlockSizeAES128 != iv.length)
+    {
+        // SHA1 the iv if provided.
+        BOOL cacheEnabled = atomic_load(&_ivCacheEnabled);
+        NSData *derivedIV = cacheEnabled ? [_ivCache objectForKey:iv] : nil;
+        if (!derivedIV)
+        {
+            derivedIV = [iv sha_SHA1];
+            
+            if (cacheEnabled)
+                [_ivCache setObject:derivedIV forKey:[iv copy]];
+        }
+        iv = derivedIV;
+    }
+    else
+    {
+        iv = _zeroIV;
+    }
+    
+    return iv;
+}
+
++ (void)setIVCacheLimit:(NSUInteger)limit
+{
+    BOOL enabled = limit > 0;
+    atomic_store(&_ivCacheEnabled, enabled);
+    
+    _ivCache.countLimit = limit;
+    
+    if (!enabled)
+        [self clearIVCache];
+}
+
++ (void)clearIVCache
+{
+    [_ivCache removeAllObjects];
+}
+
++ (NSError*)errorForStatus:(CCCryptorStatus)status
+{
+    switch (status)
+    {
+        case kCCSuccess:
+            return nil;
+        
+        case kCCParamError:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherParamErrorCode userInfo:nil];
+        case kCCBufferTooSmall:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherBufferTooSmallErrorCode userInfo:nil];
+        case kCCMemoryFailure:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherMemoryFailureErrorCode userInfo:nil];
+        case kCCAlignmentError:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherAlignmentErrorCode userInfo:nil];
+        case kCCDecodeError:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherDecodeErrorCode userInfo:nil];
+        case kCCUnimplemented:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherCUnimplementedErrorCode userInfo:nil];
+        default:
+            return [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherUndefinedErrorCode userInfo:nil];
+    }
+}
+
 + (NSData*)cipherWithkey:(NSData*)key
                    value:(NSData*)value
                       iv:(NSData*)iv
@@ -30,11 +125,7 @@ NSInteger const NSDataAESCipherCUnimplementedErrorCode  = kCCUnimplemented;
                   output:(NSMutableData*)output
                    error:(NSError**)error
 {
-    if (kCCKeySizeAES256 != key.length)
-    {
-        // SHA256 the key unless it's already 256 bits.
-        key = [key sha_SHA256];
-    }
+    key = [self cipherKeyForKey:key];
     
     NSUInteger len = value.length;
     NSUInteger capacity = (NSUInteger)(len / kCCBlockSizeAES128 + 1) * kCCBlockSizeAES128;
@@ -52,15 +143,7 @@ NSInteger const NSDataAESCipherCUnimplementedErrorCode  = kCCUnimplemented;
         }
     }
     
-    if (iv && kCCBlockSizeAES128 != iv.length)
-    {
-        // SHA1 the iv if provided.
-        iv = [iv sha_SHA1];
-    }
-    else
-    {
-        iv = [NSMutableData dataWithLength:kCCBlockSizeAES128];
-    }
+    iv = [self cipherIVForIV:iv];
     
     const void *_iv = iv.bytes;
     
@@ -83,43 +166,66 @@ NSInteger const NSDataAESCipherCUnimplementedErrorCode  = kCCUnimplemented;
         [data setLength:dataOutMoved];
     }
     
-    switch (ccStatus)
+    if (ccStatus == kCCSuccess)
+        return data;
+    
+    if (error)
+        *error = [self errorForStatus:ccStatus];
+    
+    return nil;
+}
+
++ (BOOL)cipherInPlaceWithKey:(NSData*)key
+                        data:(NSMutableData*)data
+                          iv:(NSData*)iv
+                   operation:(CCOperation)operation
+                     options:(CCOptions)options
+                       error:(NSError**)error
+{
+    key = [self cipherKeyForKey:key];
+    
+    // A NULL iv is equivalent to a zeroed block, so there is no need to allocate one.
+    if (iv)
+        iv = [self cipherIVForIV:iv];
+    
+    NSUInteger len = data.length;
+    NSUInteger capacity = len;
+    
+    if (operation == kCCEncrypt && (options & kCCOptionPKCS7Padding) != 0)
     {
-        case kCCSuccess:
-            return data;
-            break;
-            
-        case kCCParamError:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherParamErrorCode userInfo:nil];
-            break;
-        case kCCBufferTooSmall:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherBufferTooSmallErrorCode userInfo:nil];
-            break;
-        case kCCMemoryFailure:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherMemoryFailureErrorCode userInfo:nil];
-            break;
-        case kCCAlignmentError:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherAlignmentErrorCode userInfo:nil];
-            break;
-        case kCCDecodeError:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherDecodeErrorCode userInfo:nil];
-            break;
-        case kCCUnimplemented:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherCUnimplementedErrorCode userInfo:nil];
-            break;
-        default:
-            if (error)
-                *error = [NSError errorWithDomain:NSDataAESCipherErrorDomain code:NSDataAESCipherUndefinedErrorCode userInfo:nil];
-            break;
+        // Padding adds at most one block.
+        capacity = (NSUInteger)(len / kCCBlockSizeAES128 + 1) * kCCBlockSizeAES128;
+        [data setLength:capacity];
     }
     
-    return nil;
+    void *bytes = data.mutableBytes;
+    
+    size_t dataOutMoved = 0;
+    CCCryptorStatus ccStatus = CCCrypt(operation,
+                                       kCCAlgorithmAES128,
+                                       options,
+                                       (const char*)key.bytes,
+                                       key.length,
+                                       iv.bytes,
+                                       bytes,
+                                       len,
+                                       bytes,
+                                       capacity,
+                                       &dataOutMoved
+                                       );
+    
+    if (ccStatus == kCCSuccess)
+    {
+        [data setLength:dataOutMoved];
+        return YES;
+    }
+    
+    [data setLength:0];
+    
+    if (error)
+        *error = [self errorForStatus:ccStatus];
+    
+    return NO;
 }
 
 @end
@@ -0,0 +1,89 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <CommonCrypto/CommonCryptor.h>
+
+extern NSUInteger const NSDataAESCryptorPoolDefaultMaxCryptorsPerKey;
+extern NSUInteger const NSDataAESCryptorPoolDefaultMaxKeys;
+
+/**
+ * Pool of initialized AES cryptors, indexed by key, initialization vector, operation and options.
+ * @discussion Cryptors are reset and reused between records, skipping the key schedule setup done by `CCCrypt` on every call. Output is byte-compatible with `NSDataAESCipher`. Cryptors are indexed by a keyed hash, so the pool doesn't keep copies of the keys; evicted cryptors are released, clearing their key schedule. This class is thread-safe.
+ **/
+@interface NSDataAESCryptorPool : NSObject
+
+/**
+ * The shared pool.
+ **/
++ (NSDataAESCryptorPool*)sharedPool;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The maximum number of idle cryptors kept for a same key. Default value is `NSDataAESCryptorPoolDefaultMaxCryptorsPerKey`.
+ **/
+@property (nonatomic, assign) NSUInteger maxCryptorsPerKey;
+
+/**
+ * The maximum number of different keys kept in the pool. Default value is `NSDataAESCryptorPoolDefaultMaxKeys`.
+ **/
+@property (nonatomic, assign) NSUInteger maxKeys;
+
+/** *************************************************** **
+ * @name Cipher
+ ** *************************************************** **/
+
+/**
+ * Ciphers a single value using a pooled cryptor.
+ * @param key The key.
+ * @param value The value to cipher.
+ * @param iv The initialization vector. Can be nil.
+ * @param operation The cipher operation.
+ * @param options The cipher options.
+ * @param error An error pointer.
+ * @return The ciphered data, nil if error.
+ **/
+- (NSData*)cipherWithKey:(NSData*)key
+                   value:(NSData*)value
+                      iv:(NSData*)iv
+               operation:(CCOperation)operation
+                 options:(CCOptions)options
+                   error:(NSError**)error;
+
+/**
+ * Ciphers a list of values using a single pooled cryptor.
+ * @param key The key.
+ * @param values An array of NSData values.
+ * @param iv The initialization vector. Can be nil.
+ * @param operation The cipher operation.
+ * @param options The cipher options.
+ * @return An array with the ciphered values, in the same order. Values that failed are replaced by `NSNull`.
+ **/
+- (NSArray*)cipherWithKey:(NSData*)key
+                  records:(NSArray <NSData*> *)values
+                       iv:(NSData*)iv
+                operation:(CCOperation)operation
+                  options:(CCOptions)options;
+
+/**
+ * Releases all idle cryptors.
+ **/
+- (void)removeAllCryptors;
+
+@end
@@ -0,0 +1,265 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NSDataAESCryptorPool.h"
+
+#import <CommonCrypto/CommonHMAC.h>
+#import <Security/Security.h>
+
+#import "NSDataAESCipher.h"
+
+NSUInteger const NSDataAESCryptorPoolDefaultMaxCryptorsPerKey   = 8;
+NSUInteger const NSDataAESCryptorPoolDefaultMaxKeys             = 16;
+
+static NSData* NSDataAESCryptorPoolCipherRecord(CCCryptorRef cryptor, NSData *iv, NSData *value, CCCryptorStatus *status)
+{
+    // Resetting restores the initial CBC state, so the cryptor behaves as a freshly created one.
+    *status = CCCryptorReset(cryptor, iv.bytes);
+    if (*status != kCCSuccess)
+        return nil;
+    
+    size_t capacity = CCCryptorGetOutputLength(cryptor, value.length, true);
+    NSMutableData *data = [NSMutableData dataWithLength:capacity];
+    uint8_t *bytes = data.mutableBytes;
+    
+    size_t updateMoved = 0;
+    *status = CCCryptorUpdate(cryptor, value.bytes, value.length, bytes, capacity, &updateMoved);
+    if (*status != kCCSuccess)
+        return nil;
+    
+    size_t finalMoved = 0;
+    *status = CCCryptorFinal(cryptor, bytes + updateMoved, capacity - updateMoved, &finalMoved);
+    if (*status != kCCSuccess)
+        return nil;
+    
+    [data setLength:updateMoved + finalMoved];
+    return data;
+}
+
+@implementation NSDataAESCryptorPool
+{
+    NSMutableDictionary <NSData*, NSMutableArray <NSValue*>*> *_cryptors;
+    uint8_t _poolKeySecret[CC_SHA256_DIGEST_LENGTH];
+}
+
++ (NSDataAESCryptorPool*)sharedPool
+{
+    static NSDataAESCryptorPool *pool = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        pool = [[NSDataAESCryptorPool alloc] init];
+    });
+    return pool;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _cryptors = [NSMutableDictionary dictionary];
+        
+        if (SecRandomCopyBytes(kSecRandomDefault, sizeof(_poolKeySecret), _poolKeySecret) != 0)
+            arc4random_buf(_poolKeySecret, sizeof(_poolKeySecret));
+        
+        _maxCryptorsPerKey = NSDataAESCryptorPoolDefaultMaxCryptorsPerKey;
+        _maxKeys = NSDataAESCryptorPoolDefaultMaxKeys;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self removeAllCryptors];
+    memset_s(_poolKeySecret, sizeof(_poolKeySecret), 0, sizeof(_poolKeySecret));
+}
+
+#pragma mark Public Methods
+
+- (NSData*)cipherWithKey:(NSData*)key
+                   value:(NSData*)value
+                      iv:(NSData*)iv
+               operation:(CCOperation)operation
+                 options:(CCOptions)options
+                   error:(NSError**)error
+{
+    NSArray *records = [self mjz_cipherWithKey:key records:@[value ?: [NSData data]] iv:iv operation:operation options:options error:error];
+    
+    id record = records.firstObject;
+    if (record == [NSNull null])
+        return nil;
+    
+    return record;
+}
+
+- (NSArray*)cipherWithKey:(NSData*)key
+                  records:(NSArray <NSData*> *)values
+                       iv:(NSData*)iv
+                operation:(CCOperation)operation
+                  options:(CCOptions)options
+{
+    return [self mjz_cipherWithKey:key records:values iv:iv operation:operation options:options error:nil];
+}
+
+- (void)removeAllCryptors
+{
+    @synchronized(self)
+    {
+        [_cryptors enumerateKeysAndObjectsUsingBlock:^(NSData * _Nonnull poolKey, NSMutableArray<NSValue *> * _Nonnull cryptors, BOOL * _Nonnull stop) {
+            [self mjz_releaseCryptors:cryptors];
+        }];
+        [_cryptors removeAllObjects];
+    }
+}
+
+#pragma mark Private Methods
+
+- (NSArray*)mjz_cipherWithKey:(NSData*)key
+                      records:(NSArray <NSData*> *)values
+                           iv:(NSData*)iv
+                    operation:(CCOperation)operation
+                      options:(CCOptions)options
+                        error:(NSError**)error
+{
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:values.count];
+    
+    if ((options & kCCOptionECBMode) != 0)
+    {
+        // Resetting is only supported in CBC mode, ECB values are not pooled.
+        for (NSData *value in values)
+        {
+            NSData *record = [NSDataAESCipher cipherWithkey:key value:value iv:iv operation:operation options:options output:nil error:error];
+            [records addObject:record ?: [NSNull null]];
+        }
+        return records;
+    }
+    
+    key = [NSDataAESCipher cipherKeyForKey:key];
+    iv = [NSDataAESCipher cipherIVForIV:iv];
+    
+    NSData *poolKey = [self mjz_poolKeyWithKey:key iv:iv operation:operation options:options];
+    
+    CCCryptorStatus status = kCCSuccess;
+    CCCryptorRef cryptor = [self mjz_dequeueCryptorForPoolKey:poolKey];
+    
+    for (NSData *value in values)
+    {
+        if (cryptor == NULL)
+        {
+            status = CCCryptorCreate(operation, kCCAlgorithmAES128, options, key.bytes, key.length, iv.bytes, &cryptor);
+            if (status != kCCSuccess)
+            {
+                cryptor = NULL;
+                [records addObject:[NSNull null]];
+                continue;
+            }
+        }
+        
+        NSData *record = NSDataAESCryptorPoolCipherRecord(cryptor, iv, value, &status);
+        
+        if (record)
+        {
+            [records addObject:record];
+        }
+        else
+        {
+            // The cryptor state is unknown after a failure, do not reuse it.
+            CCCryptorRelease(cryptor);
+            cryptor = NULL;
+            [records addObject:[NSNull null]];
+        }
+    }
+    
+    if (cryptor != NULL)
+        [self mjz_enqueueCryptor:cryptor forPoolKey:poolKey];
+    
+    if (status != kCCSuccess && error)
+        *error = [NSDataAESCipher errorForStatus:status];
+    
+    return records;
+}
+
+- (NSData*)mjz_poolKeyWithKey:(NSData*)key iv:(NSData*)iv operation:(CCOperation)operation options:(CCOptions)options
+{
+    // A keyed hash with a per-pool secret, so the dictionary never holds key material.
+    uint32_t header[2] = {operation, options};
+    uint8_t poolKey[CC_SHA256_DIGEST_LENGTH];
+    
+    CCHmacContext context;
+    CCHmacInit(&context, kCCHmacAlgSHA256, _poolKeySecret, sizeof(_poolKeySecret));
+    CCHmacUpdate(&context, header, sizeof(header));
+    CCHmacUpdate(&context, key.bytes, key.length);
+    CCHmacUpdate(&context, iv.bytes, iv.length);
+    CCHmacFinal(&context, poolKey);
+    
+    return [NSData dataWithBytes:poolKey length:sizeof(poolKey)];
+}
+
+- (CCCryptorRef)mjz_dequeueCryptorForPoolKey:(NSData*)poolKey
+{
+    @synchronized(self)
+    {
+        NSMutableArray <NSValue*> *cryptors = _cryptors[poolKey];
+        NSValue *value = cryptors.lastObject;
+        
+        if (value)
+        {
+            [cryptors removeLastObject];
+            return (CCCryptorRef)value.pointerValue;
+        }
+    }
+    
+    return NULL;
+}
+
+- (void)mjz_enqueueCryptor:(CCCryptorRef)cryptor forPoolKey:(NSData*)poolKey
+{
+    @synchronized(self)
+    {
+        NSMutableArray <NSValue*> *cryptors = _cryptors[poolKey];
+        
+        if (!cryptors && _maxKeys > 0)
+        {
+            if (_cryptors.count >= _maxKeys)
+            {
+                // Evict any other key to make room for the new one.
+                NSData *evictedKey = [_cryptors keyEnumerator].nextObject;
+                [self mjz_releaseCryptors:_cryptors[evictedKey]];
+                [_cryptors removeObjectForKey:evictedKey];
+            }
+            
+            cryptors = [NSMutableArray arrayWithCapacity:_maxCryptorsPerKey];
+            _cryptors[poolKey] = cryptors;
+        }
+        
+        if (cryptors && cryptors.count < _maxCryptorsPerKey)
+        {
+            [cryptors addObject:[NSValue valueWithPointer:cryptor]];
+            return;
+        }
+    }
+    
+    CCCryptorRelease(cryptor);
+}
+
+- (void)mjz_releaseCryptors:(NSArray <NSValue*> *)cryptors
+{
+    // Releasing a cryptor clears its key schedule.
+    for (NSValue *value in cryptors)
+        CCCryptorRelease((CCCryptorRef)value.pointerValue);
+}
+
+@end
@@ -0,0 +1,128 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <CommonCrypto/CommonCryptor.h>
+
+extern NSUInteger const NSDataAESStreamCipherDefaultBufferSize;
+
+/**
+ * Stateful AES cipher that processes data by chunks.
+ * @discussion Keys and initialization vectors are derived as in `NSDataAESCipher`, therefore the output of a stream cipher is byte-compatible with the `NSData+AES` categories.
+ **/
+@interface NSDataAESStreamCipher : NSObject
+
+/** *************************************************** **
+ * @name Initializers
+ ** *************************************************** **/
+
+/**
+ * Default static initializer.
+ * @param key The key.
+ * @param iv The initialization vector. Can be nil.
+ * @param operation The cipher operation (`kCCEncrypt` or `kCCDecrypt`).
+ * @param options The cipher options.
+ * @return An initialized instance or nil if the cryptor couldn't be created.
+ **/
++ (instancetype)streamCipherWithKey:(NSData*)key iv:(NSData*)iv operation:(CCOperation)operation options:(CCOptions)options;
+
+/**
+ * Default initializer.
+ * @param key The key.
+ * @param iv The initialization vector. Can be nil.
+ * @param operation The cipher operation (`kCCEncrypt` or `kCCDecrypt`).
+ * @param options The cipher options.
+ * @return The initialized instance or nil if the cryptor couldn't be created.
+ **/
+- (id)initWithKey:(NSData*)key iv:(NSData*)iv operation:(CCOperation)operation options:(CCOptions)options;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The cipher operation.
+ **/
+@property (nonatomic, assign, readonly) CCOperation operation;
+
+/**
+ * The size of the reusable buffer used when ciphering streams and files. Default value is `NSDataAESStreamCipherDefaultBufferSize`.
+ **/
+@property (nonatomic, assign) NSUInteger bufferSize;
+
+/** *************************************************** **
+ * @name Ciphering chunks
+ ** *************************************************** **/
+
+/**
+ * Ciphers a chunk of bytes, appending the result to the output.
+ * @param bytes The bytes to cipher.
+ * @param length The number of bytes.
+ * @param output The data where to append the ciphered bytes.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ **/
+- (BOOL)updateWithBytes:(const void*)bytes length:(size_t)length output:(NSMutableData*)output error:(NSError**)error;
+
+/**
+ * Ciphers a chunk of data.
+ * @param data The data to cipher.
+ * @param error An error pointer.
+ * @return The ciphered bytes available so far, nil if error.
+ **/
+- (NSData*)update:(NSData*)data error:(NSError**)error;
+
+/**
+ * Finishes the cipher, appending the remaining bytes (and padding) to the output.
+ * @param output The data where to append the remaining bytes.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ * @discussion Once finalized, the cipher cannot be updated anymore.
+ **/
+- (BOOL)finalizeWithOutput:(NSMutableData*)output error:(NSError**)error;
+
+/**
+ * Finishes the cipher.
+ * @param error An error pointer.
+ * @return The remaining bytes, nil if error.
+ * @discussion Once finalized, the cipher cannot be updated anymore.
+ **/
+- (NSData*)finalizeWithError:(NSError**)error;
+
+/** *************************************************** **
+ * @name Ciphering streams
+ ** *************************************************** **/
+
+/**
+ * Reads the input stream until its end and writes the ciphered bytes into the output stream, then finalizes the cipher.
+ * @param inputStream The input stream. Opened if needed.
+ * @param outputStream The output stream. Opened if needed.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ * @discussion Memory usage is bounded by `bufferSize`, whatever is the length of the input.
+ **/
+- (BOOL)cipherInputStream:(NSInputStream*)inputStream outputStream:(NSOutputStream*)outputStream error:(NSError**)error;
+
+/**
+ * Ciphers the file at the input URL into the output URL.
+ * @param inputURL The file URL to read.
+ * @param outputURL The file URL to write. The file is replaced if it already exists.
+ * @param error An error pointer.
+ * @return YES if succeed, NO otherwise.
+ **/
+- (BOOL)cipherFileAtURL:(NSURL*)inputURL toURL:(NSURL*)outputURL error:(NSError**)error;
+
+@end
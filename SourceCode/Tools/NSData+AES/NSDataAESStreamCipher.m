@@ -0,0 +1,272 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NSDataAESStreamCipher.h"
+
+#import "NSDataAESCipher.h"
+
+NSUInteger const NSDataAESStreamCipherDefaultBufferSize = 64 * 1024;
+
+static BOOL NSDataAESStreamCipherWrite(NSOutputStream *stream, const uint8_t *bytes, size_t length)
+{
+    while (length > 0)
+    {
+        NSInteger written = [stream write:bytes maxLength:length];
+        if (written <= 0)
+            return NO;
+        
+        bytes += written;
+        length -= written;
+    }
+    return YES;
+}
+
+@implementation NSDataAESStreamCipher
+{
+    CCCryptorRef _cryptor;
+    BOOL _finalized;
+}
+
++ (instancetype)streamCipherWithKey:(NSData*)key iv:(NSData*)iv operation:(CCOperation)operation options:(CCOptions)options
+{
+    return [[self alloc] initWithKey:key iv:iv operation:operation options:options];
+}
+
+- (id)initWithKey:(NSData*)key iv:(NSData*)iv operation:(CCOperation)operation options:(CCOptions)options
+{
+    self = [super init];
+    if (self)
+    {
+        key = [NSDataAESCipher cipherKeyForKey:key];
+        iv = [NSDataAESCipher cipherIVForIV:iv];
+        
+        CCCryptorStatus status = CCCryptorCreate(operation,
+                                                 kCCAlgorithmAES128,
+                                                 options,
+                                                 key.bytes,
+                                                 key.length,
+                                                 iv.bytes,
+                                                 &_cryptor);
+        
+        if (status != kCCSuccess)
+            return nil;
+        
+        _operation = operation;
+        _bufferSize = NSDataAESStreamCipherDefaultBufferSize;
+        _finalized = NO;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_cryptor != NULL)
+        CCCryptorRelease(_cryptor);
+}
+
+#pragma mark Public Methods
+
+- (BOOL)updateWithBytes:(const void*)bytes length:(size_t)length output:(NSMutableData*)output error:(NSError**)error
+{
+    if (_finalized)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return NO;
+    }
+    
+    NSUInteger offset = output.length;
+    size_t capacity = CCCryptorGetOutputLength(_cryptor, length, false);
+    [output setLength:offset + capacity];
+    
+    size_t moved = 0;
+    CCCryptorStatus status = CCCryptorUpdate(_cryptor, bytes, length, (uint8_t*)output.mutableBytes + offset, capacity, &moved);
+    [output setLength:offset + moved];
+    
+    if (status != kCCSuccess)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:status];
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (NSData*)update:(NSData*)data error:(NSError**)error
+{
+    NSMutableData *output = [NSMutableData dataWithCapacity:CCCryptorGetOutputLength(_cryptor, data.length, false)];
+    if (![self updateWithBytes:data.bytes length:data.length output:output error:error])
+        return nil;
+    return output;
+}
+
+- (BOOL)finalizeWithOutput:(NSMutableData*)output error:(NSError**)error
+{
+    if (_finalized)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return NO;
+    }
+    
+    _finalized = YES;
+    
+    NSUInteger offset = output.length;
+    size_t capacity = CCCryptorGetOutputLength(_cryptor, 0, true);
+    [output setLength:offset + capacity];
+    
+    size_t moved = 0;
+    CCCryptorStatus status = CCCryptorFinal(_cryptor, (uint8_t*)output.mutableBytes + offset, capacity, &moved);
+    [output setLength:offset + moved];
+    
+    if (status != kCCSuccess)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:status];
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (NSData*)finalizeWithError:(NSError**)error
+{
+    NSMutableData *output = [NSMutableData dataWithCapacity:kCCBlockSizeAES128];
+    if (![self finalizeWithOutput:output error:error])
+        return nil;
+    return output;
+}
+
+- (BOOL)cipherInputStream:(NSInputStream*)inputStream outputStream:(NSOutputStream*)outputStream error:(NSError**)error
+{
+    BOOL openedInput = NO;
+    BOOL openedOutput = NO;
+    
+    if (inputStream.streamStatus == NSStreamStatusNotOpen)
+    {
+        [inputStream open];
+        openedInput = YES;
+    }
+    
+    if (outputStream.streamStatus == NSStreamStatusNotOpen)
+    {
+        [outputStream open];
+        openedOutput = YES;
+    }
+    
+    BOOL succeed = [self mjz_cipherInputStream:inputStream outputStream:outputStream error:error];
+    
+    if (openedInput)
+        [inputStream close];
+    
+    if (openedOutput)
+        [outputStream close];
+    
+    return succeed;
+}
+
+- (BOOL)cipherFileAtURL:(NSURL*)inputURL toURL:(NSURL*)outputURL error:(NSError**)error
+{
+    NSInputStream *inputStream = [NSInputStream inputStreamWithURL:inputURL];
+    NSOutputStream *outputStream = [NSOutputStream outputStreamWithURL:outputURL append:NO];
+    
+    return [self cipherInputStream:inputStream outputStream:outputStream error:error];
+}
+
+#pragma mark Private Methods
+
+- (BOOL)mjz_cipherInputStream:(NSInputStream*)inputStream outputStream:(NSOutputStream*)outputStream error:(NSError**)error
+{
+    NSUInteger bufferSize = MAX(_bufferSize, (NSUInteger)kCCBlockSizeAES128);
+    
+    // The cipher is finalized at the end of the stream, so the buffers live for this call only.
+    NSMutableData *inputBuffer = [NSMutableData dataWithLength:bufferSize];
+    NSMutableData *outputBuffer = [NSMutableData dataWithLength:bufferSize + kCCBlockSizeAES128];
+    
+    uint8_t *input = inputBuffer.mutableBytes;
+    uint8_t *output = outputBuffer.mutableBytes;
+    size_t outputCapacity = outputBuffer.length;
+    
+    while (YES)
+    {
+        NSInteger read = [inputStream read:input maxLength:bufferSize];
+        
+        if (read < 0)
+        {
+            if (error)
+                *error = inputStream.streamError;
+            return NO;
+        }
+        
+        if (read == 0)
+            break;
+        
+        if (_finalized)
+        {
+            if (error)
+                *error = [NSDataAESCipher errorForStatus:kCCParamError];
+            return NO;
+        }
+        
+        size_t moved = 0;
+        CCCryptorStatus status = CCCryptorUpdate(_cryptor, input, read, output, outputCapacity, &moved);
+        
+        if (status != kCCSuccess)
+        {
+            if (error)
+                *error = [NSDataAESCipher errorForStatus:status];
+            return NO;
+        }
+        
+        if (!NSDataAESStreamCipherWrite(outputStream, output, moved))
+        {
+            if (error)
+                *error = outputStream.streamError;
+            return NO;
+        }
+    }
+    
+    if (_finalized)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:kCCParamError];
+        return NO;
+    }
+    
+    _finalized = YES;
+    
+    size_t moved = 0;
+    CCCryptorStatus status = CCCryptorFinal(_cryptor, output, outputCapacity, &moved);
+    
+    if (status != kCCSuccess)
+    {
+        if (error)
+            *error = [NSDataAESCipher errorForStatus:status];
+        return NO;
+    }
+    
+    if (!NSDataAESStreamCipherWrite(outputStream, output, moved))
+    {
+        if (error)
+            *error = outputStream.streamError;
+        return NO;
+    }
+    
+    return YES;
+}
+
+@end
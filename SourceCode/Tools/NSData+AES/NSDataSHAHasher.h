@@ -0,0 +1,125 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSUInteger, NSDataSHAAlgorithm)
+{
+    NSDataSHAAlgorithmSHA1,
+    NSDataSHAAlgorithmSHA256,
+};
+
+extern NSUInteger const NSDataSHAHasherDefaultBufferSize;
+
+/**
+ * Incremental SHA hasher.
+ * @discussion Produces the same digests as the `NSData+SHA` category, without requiring the whole input in memory.
+ **/
+@interface NSDataSHAHasher : NSObject
+
+/** *************************************************** **
+ * @name Initializers
+ ** *************************************************** **/
+
+/**
+ * Default static initializer.
+ * @param algorithm The hash algorithm.
+ * @return An initialized instance.
+ **/
++ (instancetype)hasherWithAlgorithm:(NSDataSHAAlgorithm)algorithm;
+
+/**
+ * Default initializer.
+ * @param algorithm The hash algorithm.
+ * @return The initialized instance.
+ **/
+- (id)initWithAlgorithm:(NSDataSHAAlgorithm)algorithm;
+
+/** *************************************************** **
+ * @name Properties
+ ** *************************************************** **/
+
+/**
+ * The hash algorithm.
+ **/
+@property (nonatomic, assign, readonly) NSDataSHAAlgorithm algorithm;
+
+/**
+ * The length in bytes of the digests.
+ **/
+@property (nonatomic, assign, readonly) NSUInteger digestLength;
+
+/** *************************************************** **
+ * @name Hashing
+ ** *************************************************** **/
+
+/**
+ * Appends bytes to the hashed input.
+ * @param bytes The bytes.
+ * @param length The number of bytes.
+ **/
+- (void)updateWithBytes:(const void*)bytes length:(size_t)length;
+
+/**
+ * Appends data to the hashed input.
+ * @param data The data.
+ **/
+- (void)updateWithData:(NSData*)data;
+
+/**
+ * Finishes the hash.
+ * @return The digest of all the appended input.
+ * @discussion The hasher is reset afterwards and can be reused.
+ **/
+- (NSData*)digest;
+
+/**
+ * Discards all the appended input.
+ **/
+- (void)reset;
+
+/** *************************************************** **
+ * @name Hashing files and streams
+ ** *************************************************** **/
+
+/**
+ * Hashes a file. The file is memory-mapped, or read with a fixed-size buffer if it cannot be mapped.
+ * @param url The file URL.
+ * @param algorithm The hash algorithm.
+ * @param error An error pointer.
+ * @return The digest, nil if error.
+ **/
++ (NSData*)digestOfFileAtURL:(NSURL*)url algorithm:(NSDataSHAAlgorithm)algorithm error:(NSError**)error;
+
+/**
+ * Hashes an input stream until its end, using a buffer of `NSDataSHAHasherDefaultBufferSize` bytes.
+ * @param inputStream The input stream. Opened if needed.
+ * @param algorithm The hash algorithm.
+ * @param error An error pointer.
+ * @return The digest, nil if error.
+ **/
++ (NSData*)digestOfInputStream:(NSInputStream*)inputStream algorithm:(NSDataSHAAlgorithm)algorithm error:(NSError**)error;
+
+/**
+ * Hashes a list of values.
+ * @param values An array of NSData values.
+ * @param algorithm The hash algorithm.
+ * @return A single data with the digests of all values one after the other. The digest of the value at index `i` is at offset `i * digestLength`.
+ * @discussion No object is created per value.
+ **/
++ (NSData*)digestsOfDataArray:(NSArray <NSData*> *)values algorithm:(NSDataSHAAlgorithm)algorithm;
+
+@end
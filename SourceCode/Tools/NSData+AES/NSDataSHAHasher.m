@@ -0,0 +1,190 @@
+//
+// Copyright 2016 Mobile Jazz SL
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NSDataSHAHasher.h"
+#import <CommonCrypto/CommonDigest.h>
+
+NSUInteger const NSDataSHAHasherDefaultBufferSize = 64 * 1024;
+
+static void NSDataSHAHasherDigest(NSDataSHAAlgorithm algorithm, const uint8_t *bytes, size_t length, unsigned char *md)
+{
+    if (length <= UINT32_MAX)
+    {
+        if (algorithm == NSDataSHAAlgorithmSHA1)
+            CC_SHA1(bytes, (CC_LONG)length, md);
+        else
+            CC_SHA256(bytes, (CC_LONG)length, md);
+        return;
+    }
+    
+    // CC_LONG is 32 bits, larger inputs go through an incremental context.
+    NSDataSHAHasher *hasher = [NSDataSHAHasher hasherWithAlgorithm:algorithm];
+    [hasher updateWithBytes:bytes length:length];
+    NSData *digest = [hasher digest];
+    memcpy(md, digest.bytes, digest.length);
+}
+
+@implementation NSDataSHAHasher
+{
+    CC_SHA1_CTX _sha1;
+    CC_SHA256_CTX _sha256;
+}
+
++ (instancetype)hasherWithAlgorithm:(NSDataSHAAlgorithm)algorithm
+{
+    return [[self alloc] initWithAlgorithm:algorithm];
+}
+
+- (id)init
+{
+    return [self initWithAlgorithm:NSDataSHAAlgorithmSHA256];
+}
+
+- (id)initWithAlgorithm:(NSDataSHAAlgorithm)algorithm
+{
+    self = [super init];
+    if (self)
+    {
+        _algorithm = algorithm;
+        _digestLength = algorithm == NSDataSHAAlgorithmSHA1 ? CC_SHA1_DIGEST_LENGTH : CC_SHA256_DIGEST_LENGTH;
+        
+        [self reset];
+    }
+    return self;
+}
+
+#pragma mark Public Methods
+
+- (void)updateWithBytes:(const void*)bytes length:(size_t)length
+{
+    const uint8_t *input = bytes;
+    
+    while (length > 0)
+    {
+        CC_LONG chunk = (CC_LONG)MIN(length, (size_t)UINT32_MAX);
+        
+        if (_algorithm == NSDataSHAAlgorithmSHA1)
+            CC_SHA1_Update(&_sha1, input, chunk);
+        else
+            CC_SHA256_Update(&_sha256, input, chunk);
+        
+        input += chunk;
+        length -= chunk;
+    }
+}
+
+- (void)updateWithData:(NSData*)data
+{
+    [data enumerateByteRangesUsingBlock:^(const void * _Nonnull bytes, NSRange byteRange, BOOL * _Nonnull stop) {
+        [self updateWithBytes:bytes length:byteRange.length];
+    }];
+}
+
+- (NSData*)digest
+{
+    NSMutableData *md = [NSMutableData dataWithLength:_digestLength];
+    
+    if (_algorithm == NSDataSHAAlgorithmSHA1)
+        CC_SHA1_Final(md.mutableBytes, &_sha1);
+    else
+        CC_SHA256_Final(md.mutableBytes, &_sha256);
+    
+    [self reset];
+    
+    return md;
+}
+
+- (void)reset
+{
+    if (_algorithm == NSDataSHAAlgorithmSHA1)
+        CC_SHA1_Init(&_sha1);
+    else
+        CC_SHA256_Init(&_sha256);
+}
+
++ (NSData*)digestOfFileAtURL:(NSURL*)url algorithm:(NSDataSHAAlgorithm)algorithm error:(NSError**)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedAlways error:nil];
+    
+    if (data)
+    {
+        // Mapped pages are clean, the system can reclaim them while hashing.
+        NSDataSHAHasher *hasher = [self hasherWithAlgorithm:algorithm];
+        [hasher updateWithData:data];
+        return [hasher digest];
+    }
+    
+    return [self digestOfInputStream:[NSInputStream inputStreamWithURL:url] algorithm:algorithm error:error];
+}
+
++ (NSData*)digestOfInputStream:(NSInputStream*)inputStream algorithm:(NSDataSHAAlgorithm)algorithm error:(NSError**)error
+{
+    BOOL opened = NO;
+    if (inputStream.streamStatus == NSStreamStatusNotOpen)
+    {
+        [inputStream open];
+        opened = YES;
+    }
+    
+    NSDataSHAHasher *hasher = [self hasherWithAlgorithm:algorithm];
+    NSMutableData *buffer = [NSMutableData dataWithLength:NSDataSHAHasherDefaultBufferSize];
+    uint8_t *bytes = buffer.mutableBytes;
+    
+    NSData *digest = nil;
+    
+    while (YES)
+    {
+        NSInteger read = [inputStream read:bytes maxLength:NSDataSHAHasherDefaultBufferSize];
+        
+        if (read < 0)
+        {
+            if (error)
+                *error = inputStream.streamError;
+            break;
+        }
+        
+        if (read == 0)
+        {
+            digest = [hasher digest];
+            break;
+        }
+        
+        [hasher updateWithBytes:bytes length:read];
+    }
+    
+    if (opened)
+        [inputStream close];
+    
+    return digest;
+}
+
++ (NSData*)digestsOfDataArray:(NSArray <NSData*> *)values algorithm:(NSDataSHAAlgorithm)algorithm
+{
+    NSUInteger digestLength = algorithm == NSDataSHAAlgorithmSHA1 ? CC_SHA1_DIGEST_LENGTH : CC_SHA256_DIGEST_LENGTH;
+    
+    NSMutableData *digests = [NSMutableData dataWithLength:values.count * digestLength];
+    unsigned char *md = digests.mutableBytes;
+    
+    for (NSData *value in values)
+    {
+        NSDataSHAHasherDigest(algorithm, value.bytes, value.length, md);
+        md += digestLength;
+    }
+    
+    return digests;
+}
+
+@end
@@ -26,14 +26,12 @@
 
 - (void)aes_encryptInPlace:(NSData*)key withPadding:(CCOptions)options
 {
-    NSData *data = [NSDataAESCipher cipherWithkey:key
-                                            value:self
-                                               iv:nil
-                                        operation:kCCEncrypt
-                                          options:options
-                                           output:nil
-                                            error:nil];
-    [self setData:data];
+    [NSDataAESCipher cipherInPlaceWithKey:key
+                                     data:self
+                                       iv:nil
+                                operation:kCCEncrypt
+                                  options:options
+                                    error:nil];
 }
 
 - (void)aes_decryptInPlace:(NSData*)key
@@ -43,15 +41,12 @@
 
 - (void)aes_decryptInPlace:(NSData*)key withPadding:(CCOptions)options
 {
-    NSData *data = [NSDataAESCipher cipherWithkey:key
-                                            value:self
-                                               iv:nil
-                                        operation:kCCDecrypt
-                                          options:options
-                                           output:nil
-                                            error:nil];
-    
-    [self setData:data];
+    [NSDataAESCipher cipherInPlaceWithKey:key
+                                     data:self
+                                       iv:nil
+                                operation:kCCDecrypt
+                                  options:options
+                                    error:nil];
 }
 
 @end